@@ -19,6 +19,6 @@ typedef struct s_fen_format {
 #define UNKOWN_PIECE	'?'
 #define EMPTY_PIECE		' '
 
-char *build_FEN_notation(SDLHandle *h);
+char *build_FEN_notation(ChessBoard *b);
 
 #endif
\ No newline at end of file
@@ -66,6 +66,22 @@ typedef u64 Bitboard;
 #define NOT_RANK_7 (~RANK_7)
 #define NOT_RANK_8 (~RANK_8)
 
+/* Mask of the light tiles (A1 is dark) */
+#define LIGHT_TILES 0x55AA55AA55AA55AAULL
+
+/* Game phase of the start position (4 minor * 1, 4 rook * 2, 2 queen * 4), 0 with only kings and pawns */
+#define PHASE_MAX 24
+
+/* Known endgames are only probed with at most this number of pieces on the board */
+#define ENDGAME_MAX_PIECES 5
+
+/* Syzygy tablebases: largest supported table and the environment variable of the tablebase directory */
+#define SYZYGY_MAX_PIECES 6
+#define SYZYGY_PATH_ENV "C_CHESS_SYZYGY"
+
+/* Size of the position key ring, power of two covering the full halfmove_count range */
+#define HASH_HISTORY_SIZE 256
+
 /* Chess quit */
 #define CHESS_QUIT -2
 
@@ -107,6 +123,9 @@ typedef struct s_chess_board {
 	/* 64 bitboard for each piece */
 	Bitboard	piece[PIECE_MAX];
 
+	/* Piece on each tile, kept in sync with the piece bitboards */
+	ChessPiece	mailbox[TILE_MAX];
+
 	/* Bitboard for occupied tile */
 	Bitboard	occupied;
 
@@ -123,10 +142,6 @@ typedef struct s_chess_board {
 	Bitboard	en_passant;			/* Bitboard for en passant possible moves */
 	ChessTile	en_passant_tile;	/* Tile of the pawn can be attacked by en passant move */
 
-	/* Bitboard for white and black control */
-	Bitboard	white_control;		/* Bitboard for white control tile */
-	Bitboard	black_control;		/* Bitboard for black control tile */
-
 	/* Store last move for display it */
 	ChessTile	last_tile_from;			/* Tile from */
 	ChessTile	last_tile_to;			/* Tile to */
@@ -137,11 +152,24 @@ typedef struct s_chess_board {
 	/* Turn count */
 	u16			fullmove_count;		/* Turn count white + black == 1 */
 	u8			halfmove_count;		/* Half turn count, for the 50 moves rule */
+	s8			turn;				/* Color to play, IS_WHITE or IS_BLACK */
+
+	/* Zobrist key of the position, updated with each board change */
+	u64			hash_key;
 
-	/* Value of white and black pieces taken */
+	/* Zobrist keys of the played positions, ring indexed by history_ply */
+	u64			hash_history[HASH_HISTORY_SIZE];
+	u16			history_ply;		/* Index of the current position, increase with each move */
+
+	/* Value of white and black pieces on the board (pawn unit), updated with each board change */
 	s8			white_piece_val;		/* White piece value */
 	s8			black_piece_val;		/* Black piece value */
 
+	/* Material + piece square scores (white - black) and game phase, updated with each board change */
+	s32			eval_mg;			/* Middlegame score */
+	s32			eval_eg;			/* Endgame score */
+	s32			phase;				/* Sum of the piece phase values, PHASE_MAX at the start */
+
 	/* u8 used as 8 boolean info used as follow
 	 * 0: white check
 	 * 1: black check
@@ -155,25 +183,204 @@ typedef struct s_chess_board {
 	u8			info;
 } ChessBoard;
 
-/* @brief Function pointer typedef for get move functions 
- * @param b		ChessBoard struct pointer
- * @param piece	Bitboard of piece position to get move (1 bit set)
+/* Magic bitboard entry, used for sliding piece attack lookup */
+typedef struct s_magic_entry {
+	Bitboard	mask;		/* Relevant occupancy mask (board edges excluded) */
+	Bitboard	magic;		/* Magic multiplier */
+	Bitboard	*attacks;	/* Attack sets of this tile in the shared table */
+	u8			shift;		/* 64 - number of bits in mask */
+} MagicEntry;
+
+/* Magic entry for each tile, filled by init_attack_table (src/attack_table.c) */
+extern MagicEntry g_rook_magic[TILE_MAX];
+extern MagicEntry g_bishop_magic[TILE_MAX];
+
+/* @brief Get the rook attacks from a tile
+ * @param tile		ChessTile enum
+ * @param occupied	Bitboard of the occupied tiles
+ * @return Bitboard of the attacked tiles (first blocker included, ally or enemy)
+*/
+FT_INLINE Bitboard get_rook_attacks(ChessTile tile, Bitboard occupied) {
+	const MagicEntry *m = &g_rook_magic[tile];
+	return (m->attacks[((occupied & m->mask) * m->magic) >> m->shift]);
+}
+
+/* @brief Get the bishop attacks from a tile
+ * @param tile		ChessTile enum
+ * @param occupied	Bitboard of the occupied tiles
+ * @return Bitboard of the attacked tiles (first blocker included, ally or enemy)
+*/
+FT_INLINE Bitboard get_bishop_attacks(ChessTile tile, Bitboard occupied) {
+	const MagicEntry *m = &g_bishop_magic[tile];
+	return (m->attacks[((occupied & m->mask) * m->magic) >> m->shift]);
+}
+
+/* Leaper attack tables, filled by init_attack_table (src/attack_table.c) */
+extern Bitboard g_knight_attack[TILE_MAX];
+extern Bitboard g_king_attack[TILE_MAX];
+extern Bitboard g_pawn_attack[2][TILE_MAX];
+
+/* Line tables, filled by init_attack_table (src/attack_table.c), empty if the tiles are not aligned */
+extern Bitboard g_line_between[TILE_MAX][TILE_MAX];	/* Tiles strictly between the two tiles */
+extern Bitboard g_line_through[TILE_MAX][TILE_MAX];	/* Full board line through the two tiles */
+
+/* @brief Get the attacks of a piece from a tile (control tiles, no pawn push)
+ * @param piece		ChessPiece enum
+ * @param tile		ChessTile enum
+ * @param occupied	Bitboard of the occupied tiles (only used for sliding pieces)
+ * @return Bitboard of the attacked tiles, ally pieces are not removed
+*/
+FT_INLINE Bitboard attacks_from(ChessPiece piece, ChessTile tile, Bitboard occupied) {
+	switch (piece) {
+		case WHITE_PAWN: return (g_pawn_attack[IS_WHITE][tile]);
+		case BLACK_PAWN: return (g_pawn_attack[IS_BLACK][tile]);
+		case WHITE_KNIGHT: case BLACK_KNIGHT: return (g_knight_attack[tile]);
+		case WHITE_BISHOP: case BLACK_BISHOP: return (get_bishop_attacks(tile, occupied));
+		case WHITE_ROOK: case BLACK_ROOK: return (get_rook_attacks(tile, occupied));
+		case WHITE_QUEEN: case BLACK_QUEEN: return (get_bishop_attacks(tile, occupied) | get_rook_attacks(tile, occupied));
+		case WHITE_KING: case BLACK_KING: return (g_king_attack[tile]);
+		default: return (0);
+	}
+}
+
+/* @brief Get the first tile set in a mask
+ * @param mask	Bitboard mask
+ * @return ChessTile of the lowest bit set, or INVALID_TILE if mask is empty
+*/
+FT_INLINE ChessTile get_tile_from_mask(Bitboard mask) {
+	if (mask == 0) {
+		return (INVALID_TILE);
+	}
+	return ((ChessTile)__builtin_ctzll(mask));
+}
+
+/* @brief Count the bits set in a bitboard
+ * @param mask	Bitboard mask
+ * @return Number of bits set
+*/
+FT_INLINE s32 bitboard_count(Bitboard mask) {
+	return (__builtin_popcountll(mask));
+}
+
+/* @brief Check if a side can still castle on one side, king and rook never moved
+ * @param b			ChessBoard struct
+ * @param king_idx	Info index of the king moved bit
+ * @param rook_idx	Info index of the rook moved bit
+ * @param rook		Rook piece
+ * @param rook_tile	Rook start tile
+*/
+FT_INLINE s8 castle_available(ChessBoard *b, s32 king_idx, s32 rook_idx, ChessPiece rook, ChessTile rook_tile) {
+	return (!u8ValueGet(b->info, king_idx) && !u8ValueGet(b->info, rook_idx) && b->mailbox[rook_tile] == rook);
+}
+
+/* @brief Get the king distance between two tiles (number of king moves)
+ * @param a		ChessTile enum
+ * @param b		ChessTile enum
+ * @return Max of the file and rank distance
+*/
+FT_INLINE s32 tile_distance(ChessTile a, ChessTile b) {
+	s32 file = INT_ABS_DIFF(a & 7, b & 7);
+	s32 rank = INT_ABS_DIFF(a / 8, b / 8);
+
+	return (file > rank ? file : rank);
+}
+
+/* Zobrist keys, filled by init_zobrist_table (src/zobrist.c) */
+extern u64 g_zobrist_piece[PIECE_MAX][TILE_MAX];	/* Piece on tile */
+extern u64 g_zobrist_castle[4];						/* Castle right: white king side, white queen side, black king side, black queen side */
+extern u64 g_zobrist_en_passant[8];					/* 'En passant' file, only if a pawn can take */
+extern u64 g_zobrist_turn;							/* Black to play */
+
+/* @brief Get the pawns of the side to move that can take 'en passant'
+ * @param b		ChessBoard struct
+ * @return Bitboard of the pawns next to the pushed pawn, 0 if there is no 'en passant' tile
+*/
+FT_INLINE Bitboard en_passant_attackers(ChessBoard *b) {
+	Bitboard pushed = 0;
+
+	if (!b->en_passant) {
+		return (0);
+	}
+	pushed = 1ULL << b->en_passant_tile;
+	return ((((pushed & NOT_FILE_A) >> 1) | ((pushed & NOT_FILE_H) << 1)) & b->piece[b->turn == IS_WHITE ? WHITE_PAWN : BLACK_PAWN]);
+}
+
+/* Evaluation tables, filled by init_eval_table (src/evaluate.c) */
+extern s16 g_psq_mg[PIECE_MAX][TILE_MAX];			/* Middlegame material + piece square, black negative */
+extern s16 g_psq_eg[PIECE_MAX][TILE_MAX];			/* Endgame material + piece square, black negative */
+extern const s8 g_phase_value[PIECE_MAX];			/* Game phase weight */
+extern const s8 g_piece_value[PIECE_MAX];			/* Piece value in pawn unit, displayed by the UI */
+
+/* @brief Add (sign 1) or remove (sign -1) a piece from the incremental evaluation */
+FT_INLINE void board_eval_update(ChessBoard *b, ChessPiece type, ChessTile tile, s32 sign) {
+	b->eval_mg += sign * g_psq_mg[type][tile];
+	b->eval_eg += sign * g_psq_eg[type][tile];
+	b->phase += sign * g_phase_value[type];
+	if (type >= BLACK_PAWN) {
+		b->black_piece_val += sign * g_piece_value[type];
+	} else {
+		b->white_piece_val += sign * g_piece_value[type];
+	}
+}
+
+/* @brief Save the current zobrist key as a new position in the history ring */
+FT_INLINE void board_history_push(ChessBoard *b) {
+	b->history_ply++;
+	b->hash_history[b->history_ply & (HASH_HISTORY_SIZE - 1)] = b->hash_key;
+}
+
+/* @brief Replace the current position key of the history ring, used when the position changes without a move */
+FT_INLINE void board_history_replace(ChessBoard *b) {
+	b->hash_history[b->history_ply & (HASH_HISTORY_SIZE - 1)] = b->hash_key;
+}
+
+/* @brief Toggle a piece mask in the piece, color and occupied bitboards, the mailbox is not updated
+ * @param b		ChessBoard struct
  * @param type	ChessPiece enum
- * @param is_black	1 for black piece, 0 for white piece
- * @param check_legal	1 for check legal move, 0 for not check legal move
- * @return Bitboard of possible moves
- */
-typedef Bitboard (*GetMoveFunc)(ChessBoard*, Bitboard, ChessPiece, s8, s8);
-
-/* Struct for piece move */
-typedef struct s_piece_move {
-	ChessPiece	white_piece_type;
-	ChessPiece	black_piece_type;
-	GetMoveFunc get_move_func;
-} PieceMove;
-
-/* Piece Move Array size */
-#define PIECE_MOVE_ARRAY_SIZE 6
+ * @param mask	Bitboard of the tiles to toggle
+*/
+FT_INLINE void board_toggle_piece(ChessBoard *b, ChessPiece type, Bitboard mask) {
+	b->piece[type] ^= mask;
+	if (type >= BLACK_PAWN) {
+		b->black ^= mask;
+	} else {
+		b->white ^= mask;
+	}
+	b->occupied ^= mask;
+}
+
+/* @brief Add a piece on an empty tile */
+FT_INLINE void board_add_piece(ChessBoard *b, ChessPiece type, ChessTile tile) {
+	board_toggle_piece(b, type, 1ULL << tile);
+	b->mailbox[tile] = type;
+	b->hash_key ^= g_zobrist_piece[type][tile];
+	board_eval_update(b, type, tile, 1);
+}
+
+/* @brief Remove a piece from its tile */
+FT_INLINE void board_remove_piece(ChessBoard *b, ChessPiece type, ChessTile tile) {
+	board_toggle_piece(b, type, 1ULL << tile);
+	b->mailbox[tile] = EMPTY;
+	b->hash_key ^= g_zobrist_piece[type][tile];
+	board_eval_update(b, type, tile, -1);
+}
+
+/* @brief Move a piece from its tile to an empty tile */
+FT_INLINE void board_move_piece(ChessBoard *b, ChessPiece type, ChessTile from, ChessTile to) {
+	board_toggle_piece(b, type, (1ULL << from) | (1ULL << to));
+	b->mailbox[from] = EMPTY;
+	b->mailbox[to] = type;
+	b->hash_key ^= g_zobrist_piece[type][from] ^ g_zobrist_piece[type][to];
+	b->eval_mg += g_psq_mg[type][to] - g_psq_mg[type][from];
+	b->eval_eg += g_psq_eg[type][to] - g_psq_eg[type][from];
+}
+
+/* Board consistency check, only enabled with CHESS_BOARD_DEBUG (make debug) */
+#ifdef CHESS_BOARD_DEBUG
+	#define BOARD_DEBUG_CHECK(b) board_check_consistency(b)
+#else
+	#define BOARD_DEBUG_CHECK(b)
+#endif
 
 /* @brief Display kill info
  * @param enemy_piece	ChessPiece enum
@@ -184,6 +391,69 @@ FT_INLINE void display_kill_info(ChessPiece enemy_piece, ChessTile tile_to) {
 		ChessPiece_to_str(enemy_piece), ChessTile_to_str(tile_to));
 }
 
+/* Check and pin info for one color, computed once per position to filter legal moves */
+typedef struct s_check_info {
+	Bitboard	checkers;		/* Enemy pieces giving check */
+	Bitboard	check_mask;		/* Tiles a non king move must reach (capture or block the check) */
+	Bitboard	pinned;			/* Ally pieces pinned on their king */
+	ChessTile	king_tile;		/* Ally king tile, INVALID_TILE if no king on board */
+	s8			is_black;		/* Color of the info */
+} CheckInfo;
+
+/* Move encoded on 16 bits: from tile (bits 0-5), to tile (bits 6-11), MoveFlag (bits 12-15)
+ * Promotion flags hold the promoted piece in their 2 low bits (knight, bishop, rook, queen)
+*/
+typedef u16 Move;
+
+#define MOVE_NONE 0
+
+/* Maximum number of legal moves in a position (218 is the known maximum) */
+#define MAX_MOVES 256
+
+FT_INLINE Move move_new(ChessTile from, ChessTile to, u16 flag) {
+	return ((Move)(from | (to << 6) | (flag << 12)));
+}
+
+FT_INLINE ChessTile move_from(Move move) {
+	return ((ChessTile)(move & 0x3F));
+}
+
+FT_INLINE ChessTile move_to(Move move) {
+	return ((ChessTile)((move >> 6) & 0x3F));
+}
+
+FT_INLINE u16 move_flag(Move move) {
+	return (move >> 12);
+}
+
+/* Capture flag bit is set for capture, 'en passant' and promotion capture */
+FT_INLINE s8 move_is_capture(Move move) {
+	return ((move_flag(move) & MOVE_CAPTURE) != 0);
+}
+
+FT_INLINE s8 move_is_promotion(Move move) {
+	return ((move_flag(move) & MOVE_PROMOTION) != 0);
+}
+
+/* @brief Get the promoted piece of a move, EMPTY if the move is not a promotion */
+FT_INLINE ChessPiece move_promotion_piece(Move move, s8 is_black) {
+	if (!move_is_promotion(move)) {
+		return (EMPTY);
+	}
+	return ((is_black ? BLACK_KNIGHT : WHITE_KNIGHT) + (move_flag(move) & 3));
+}
+
+/* State of the board that can't be recovered from a move, saved by make_move for unmake_move */
+typedef struct s_undo {
+	ChessPiece	captured;			/* Captured piece, EMPTY if no capture */
+	Bitboard	en_passant;			/* 'En passant' bitboard before the move */
+	ChessTile	en_passant_tile;	/* 'En passant' pawn tile before the move */
+	u16			fullmove_count;		/* Fullmove count before the move */
+	u8			halfmove_count;		/* Halfmove count before the move */
+	u8			info;				/* Check and castle bits before the move */
+	u64			hash_key;			/* Zobrist key before the move */
+} Undo;
+
 /* Tile color */
 #define BLACK_TILE ((u32)(RGBA_TO_UINT32(0, 120, 120, 255)))
 #define WHITE_TILE ((u32)(RGBA_TO_UINT32(255, 255, 255, 255)))
@@ -284,12 +554,58 @@ u32			handle_chess_flag(int argc, char **argv, s8 *error, PlayerInfo *player_inf
 /* src/chess_board.c */
 void		init_board(ChessBoard *board, u32 *app_flag);
 void		update_piece_state(ChessBoard *b);
+void		update_check_flags(ChessBoard *b);
+s8			board_check_consistency(ChessBoard *b);
 void		display_bitboard(Bitboard board, const char *msg);
 s8			is_selected_possible_move(Bitboard possible_moves, ChessTile tile);
 s8			is_en_passant_move(ChessBoard *b, ChessTile tile);
 ChessPiece	get_piece_from_tile(ChessBoard *b, ChessTile tile);
 ChessPiece	get_piece_from_mask(ChessBoard *b, Bitboard mask);
+
+/* src/board_move.c */
+void		board_special_info_handler(ChessBoard *b, ChessPiece type, ChessTile tile_from);
+void		handle_castle_move(ChessBoard *b, ChessPiece type, ChessTile tile_from, ChessTile tile_to);
 void		handle_turn_count(ChessBoard *b, ChessPiece piece_type, s8 kill);
+ChessPiece	board_apply_move(ChessBoard *b, ChessTile tile_from, ChessTile tile_to, ChessPiece type, ChessPiece promotion);
+void		make_move(ChessBoard *b, Move move, Undo *undo);
+void		unmake_move(ChessBoard *b, Move move, Undo *undo);
+
+/* src/load_FEN_notation.c */
+s8			load_FEN_notation(ChessBoard *b, const char *fen);
+
+/* src/attack_table.c */
+void		init_attack_table();
+
+/* src/zobrist.c */
+void		init_zobrist_table();
+u64			zobrist_castle_key(u8 info);
+u64			zobrist_en_passant_key(ChessBoard *b);
+u64			compute_zobrist_key(ChessBoard *b);
+
+/* src/evaluate.c */
+void		init_eval_table();
+void		compute_board_eval(ChessBoard *b);
+s8			board_check_eval(ChessBoard *b);
+s32			evaluate(ChessBoard *b);
+
+/* src/draw_detection.c */
+s32			repetition_count(ChessBoard *b);
+s8			is_insufficient_material(ChessBoard *b);
+DrawReason	get_draw_reason(ChessBoard *b);
+
+/* src/endgame.c */
+void		init_endgame_table();
+EndgameWDL	endgame_probe_known(ChessBoard *b);
+EndgameWDL	endgame_probe(ChessBoard *b);
+s8			endgame_adjudicate(ChessBoard *b, s8 *winner);
+
+/* src/syzygy.c */
+s32			syzygy_init(const char *path);
+void		syzygy_free();
+s32			syzygy_max_pieces();
+EndgameWDL	syzygy_probe_wdl(ChessBoard *b);
+s8			syzygy_probe_dtz(ChessBoard *b, s32 *dtz);
+s32			syzygy_root_filter(ChessBoard *b, Move *moves, s32 count);
 
 /* src/chess_piece_moves.c */
 Bitboard	get_pawn_moves(ChessBoard *b, Bitboard pawn, ChessPiece type, s8 is_black, s8 check_legal);
@@ -300,21 +616,34 @@ Bitboard	get_king_moves(ChessBoard *b, Bitboard king, ChessPiece type, s8 is_bla
 Bitboard	get_knight_moves(ChessBoard *b, Bitboard knight, ChessPiece type, s8 is_black, s8 check_legal);
 
 
-/* src/generic_piece_move.c */
+/* src/legal_move.c */
+Bitboard	get_attackers_to(ChessBoard *b, ChessTile tile, Bitboard occupied);
+s8			is_tile_attacked(ChessBoard *b, ChessTile tile, s8 by_black, Bitboard occupied);
+void		compute_check_info(ChessBoard *b, s8 is_black, CheckInfo *ci);
+Bitboard	keep_legal_moves(ChessBoard *b, ChessTile tile, ChessPiece type, Bitboard moves, CheckInfo *ci);
 Bitboard 	get_piece_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, s8 check_legal);
+Bitboard	get_legal_piece_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, CheckInfo *ci);
+s8			has_legal_move(ChessBoard *b, s8 is_black);
+
+/* src/generate_move.c */
+s32			generate_legal_moves(ChessBoard *b, Move *out);
+s32			generate_capture_moves(ChessBoard *b, Move *out);
+s32			generate_quiet_moves(ChessBoard *b, Move *out);
+s8			is_legal_move(ChessBoard *b, Move move);
+
+/* src/generic_piece_move.c */
 s32			move_piece(SDLHandle *handle, ChessTile tile_from, ChessTile tile_to, ChessPiece type);
-s8			handle_enemy_piece_kill(ChessBoard *b, ChessPiece type, Bitboard mask_to);
 
 /* src/handle_board.c */
 s32			event_handler(SDLHandle *h, s8 player_color);
 void		reset_selected_tile(SDLHandle *h);
+void		handle_locale_turn(SDLHandle *h);
 
 /* src/draw_baord.c */
 s8			is_selected_possible_move(Bitboard possible_moves, ChessTile tile);
 s8			is_en_passant_move(ChessBoard *b, ChessTile tile);
 ChessTile	handle_tile(ChessTile tile, s32 player_color);
 s8			verify_check_and_mat(ChessBoard *b, s8 is_black);
-Bitboard	get_piece_color_control(ChessBoard *b, s8 is_black);
 void 		update_graphic_board(SDLHandle *h);
 
 /* src/pawn_promotion.c */
@@ -327,7 +656,6 @@ void		pawn_selection_event(SDLHandle *h);
 s8			move_save_add(ChessMoveList **lst, ChessTile tile_from, ChessTile tile_to, ChessPiece piece_from, ChessPiece piece_to);
 void		display_move_list(ChessMoveList *lst);
 void		add_kill_lst(ChessBoard *b, ChessPiece killed_piece);
-void		compute_piece_value(ChessBoard *b);
 
 /* src/parse_message_receive.c */
 s8 			ignore_msg(SDLHandle *h, char *buffer);
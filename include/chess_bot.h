@@ -1,8 +1,312 @@
 #ifndef CHESS_BOT_H
 #define CHESS_BOT_H
 
-#include <curl/curl.h>
+/* Bot difficulty, a search budget: the search stop after nodes (all the threads together)
+ * or time_ms, the first reached. With the same nodes a level play the same moves on any
+ * hardware (one thread), the time is a guard for the slow ones.
+ * threads is the number of search threads (0 for one per CPU core)
+*/
+typedef enum {
+	LEVEL_EASY,
+	LEVEL_MEDIUM,
+	LEVEL_HARD,
+	LEVEL_EXPERT,
+} BotLevel;
 
-void send_stockfish_fen(char *fen_str);
+typedef struct s_bot_skill_level {
+	BotLevel	level;
+	char		*name;
+	u64			nodes;
+	u32			time_ms;
+	u8			threads;
+} BotSkillLevel;
 
-#endif
\ No newline at end of file
+#define SKILL_LEVEL_ARRAY_SIZE 4
+
+#define SKILL_LVL_ARRAY { \
+	{LEVEL_EASY, "Easy", 1000, 200, 1}, \
+	{LEVEL_MEDIUM, "Medium", 30000, 500, 1}, \
+	{LEVEL_HARD, "Hard", 400000, 1500, 2}, \
+	{LEVEL_EXPERT, "Expert", 4000000, 4000, 0} \
+}
+
+/* Level used by the local bot ('p' key) */
+#define BOT_DEFAULT_LEVEL LEVEL_MEDIUM
+
+/* Depth limit of a search with a node or time budget */
+#define SEARCH_MAX_DEPTH 64
+
+/* Maximum number of search threads */
+#define SEARCH_MAX_THREADS 64
+
+/* Search score bounds, a mate score is SCORE_MATE minus the ply of the mat */
+#define SCORE_INF		32000
+#define SCORE_MATE		31000
+#define SCORE_DRAW		0
+#define SCORE_KNOWN_WIN	10000	/* Known won endgame, the evaluation is added to make progress */
+#define MAX_PLY			128
+#define IS_MATE_SCORE(score) ((score) > SCORE_MATE - MAX_PLY || (score) < -SCORE_MATE + MAX_PLY)
+
+/*
+ * Transposition table, a power of two array of cache line buckets.
+ * An entry is two u64: data pack move, score, depth, bound and age, check is key ^ data.
+ * Readers and writers don't lock, a torn entry written by another thread fail the
+ * key ^ data check and is seen as a miss.
+*/
+#define TT_BUCKET_SIZE		4
+#define TT_DEFAULT_SIZE_MB	16
+#define TT_AGE_MASK			0x3F
+
+typedef struct s_tt_entry {
+	u64		check;		/* Zobrist key ^ data */
+	u64		data;		/* Packed entry data */
+} TTEntry;
+
+typedef struct s_tt_bucket {
+	TTEntry	entry[TT_BUCKET_SIZE];
+} __attribute__((aligned(64))) TTBucket;
+
+typedef struct s_transposition_table {
+	TTBucket	*bucket;		/* Bucket array, aligned on a cache line */
+	void		*alloc;			/* Allocated pointer, bucket is aligned inside */
+	u64			mask;			/* Bucket count - 1 */
+	u32			size_mb;		/* Table size in MB */
+	u8			age;			/* Search generation, increased with each search */
+} TranspositionTable;
+
+/* Unpacked entry */
+typedef struct s_tt_data {
+	Move		move;
+	s32			score;
+	s32			depth;
+	TTBound		bound;
+} TTData;
+
+/* Killer moves kept by ply */
+#define KILLER_SIZE 2
+
+/*
+ * Staged move picker: hash move, captures by MVV-LVA, killers, then quiet moves by history.
+ * Each stage is generated only when the previous one is done, a cutoff on the hash move
+ * or a capture don't generate the quiet moves.
+*/
+typedef struct s_move_picker {
+	ChessBoard	*b;						/* Board of the node */
+	Move		hash_move;				/* Transposition table move, MOVE_NONE if none */
+	Move		killer[KILLER_SIZE];	/* Killer moves of the ply */
+	s32			(*history)[TILE_MAX];	/* History score indexed by [piece][tile_to], NULL for none */
+	Move		moves[MAX_MOVES];		/* Moves of the current stage */
+	s32			score[MAX_MOVES];		/* Ordering score of the moves */
+	s32			count;					/* Number of moves of the current stage */
+	s32			idx;					/* Next move index */
+	MoveStage	stage;					/* Current stage */
+	MoveStage	last_stage;				/* STAGE_CAPTURE for the quiescence, STAGE_QUIET otherwise */
+} MovePicker;
+
+/*
+ * Polyglot opening book, the file is memory mapped and never loaded in the heap.
+ * Entries are 16 bytes big endian (key, move, weight, learn), sorted by key,
+ * a position is found with a binary search.
+*/
+#define BOOK_PATH				"rsc/book/book.bin"
+#define BOOK_ENTRY_SIZE			16
+#define POLYGLOT_RANDOM_SIZE	781
+
+typedef struct s_opening_book {
+	const u8	*data;			/* Mapped file, NULL if no book is open */
+	u64			size;			/* Mapped size in bytes */
+	u64			count;			/* Number of entries */
+#ifdef CHESS_WINDOWS_VERSION
+	void		*file;			/* File handle */
+	void		*mapping;		/* File mapping handle */
+#endif
+} OpeningBook;
+
+/*
+ * UCI engine backend, a local engine binary (stockfish ...) is used instead of the bot search
+ * when the C_CHESS_ENGINE environment variable give its path. The engine process is started
+ * on the first bot move and kept alive until the bot is destroyed.
+*/
+#define UCI_ENGINE_ENV			"C_CHESS_ENGINE"
+#define UCI_BUFF_SIZE			4096	/* Engine output buffer, a longer line is dropped */
+#define UCI_LINE_SIZE			1024	/* Max line length given to the caller, a longer line is cut */
+#define UCI_MOVE_SIZE			6		/* 'e7e8q' + '\0' */
+#define UCI_INIT_TIMEOUT_MS		5000	/* Time to answer uciok and readyok */
+#define UCI_MOVE_MARGIN_MS		2000	/* Time over movetime to answer bestmove, then stop is sent */
+#define UCI_QUIT_TIMEOUT_MS		200		/* Time to exit after quit, then the engine is killed */
+#define UCI_POLL_MS				20		/* Read granularity, the cancel flag is checked between the reads */
+#define UCI_MAX_RESTART			3		/* Restarts in a row before giving up */
+
+/* uci_engine_read_line result */
+#define UCI_READ_LINE			0
+#define UCI_READ_TIMEOUT		1
+#define UCI_READ_ERROR			2
+
+typedef struct s_uci_engine {
+	char	*path;						/* Engine binary path, NULL if no engine */
+	s32		pid;						/* Engine process, 0 if not running */
+	s32		in_fd;						/* Engine stdin, written by us */
+	s32		out_fd;						/* Engine stdout, read by us */
+	char	buff[UCI_BUFF_SIZE];		/* Bytes read and not yet given as a line */
+	u32		buff_len;					/* Number of bytes in buff */
+	u32		restart_count;				/* Restarts since the last answered search */
+} UciEngine;
+
+/*
+ * Remote engine, a HTTP endpoint with the stockfish.online answer ({"success":true, "bestmove":"bestmove e2e4 ..."}).
+ * The bot use it when C_CHESS_STOCKFISH_URL give the URL prefix (STOCKFISH_URL for the public API),
+ * the FEN and the depth are appended.
+*/
+#define STOCKFISH_URL			"https://stockfish.online/api/s/v2.php?fen="
+#define STOCKFISH_URL_ENV		"C_CHESS_STOCKFISH_URL"
+#define STOCKFISH_DEPTH			10			/* Depth asked by the bot */
+#define STOCKFISH_POOL_SIZE		4			/* Parallel requests, one kept alive connection each */
+#define STOCKFISH_CACHE_SIZE	256			/* Cached answers */
+#define STOCKFISH_TIMEOUT_MS	10000		/* Request timeout */
+#define STOCKFISH_BODY_SIZE		1024		/* First response buffer size, doubled when needed */
+#define STOCKFISH_BODY_MAX		(1 << 20)	/* Bigger responses are dropped */
+
+/* Remote engine answer */
+typedef struct s_stockfish_result {
+	u32		id;						/* Request id */
+	char	move[UCI_MOVE_SIZE];	/* UCI best move, empty on failure */
+	s8		from_cache;				/* TRUE if the answer come from the cache */
+	u32		new_connections;		/* Connections opened by the request, 0 when one is reused */
+	u64		time_ms;				/* Request time */
+} StockfishResult;
+
+/*
+ * Time manager, the game clock of the bot side give two deadlines to the search:
+ * the soft one is the time the move should take, no new depth start after it (sooner when the
+ * best move is stable, later when it just changed), the hard one stop the search in the middle
+ * of a depth. The hard deadline keep TM_MOVE_OVERHEAD_MS and most of the clock for the next moves.
+*/
+#define TM_MOVE_OVERHEAD_MS		100		/* Kept for the move display and the network */
+#define TM_MOVES_HORIZON		50		/* Expected game length in moves, the moves left are counted from it */
+#define TM_MIN_MOVES_LEFT		15		/* Moves left never estimated under it */
+#define TM_HARD_FACTOR			3		/* Hard deadline, at most soft * TM_HARD_FACTOR */
+#define TM_HARD_MAX_DIV			4		/* Hard deadline, at most the clock / TM_HARD_MAX_DIV */
+#define TM_MIN_TIME_MS			10		/* Deadline when the clock is empty */
+#define TM_STABILITY_MAX		4		/* Stable depths counted */
+
+/* Soft deadline scale in percent, by number of depths with the same best move */
+#define TM_STABILITY_SCALE		{200, 130, 100, 75, 55}
+
+/* Game clock of the bot side */
+typedef struct s_bot_clock {
+	u64		remaining_ms;		/* Time left on the clock */
+	u32		increment_ms;		/* Time added after each move */
+	u32		moves_to_go;		/* Moves before the next time control, 0 for the whole game */
+} BotClock;
+
+/* Search parameters and result */
+typedef struct s_search_info {
+	/* Limits, set by the caller */
+	s32		max_depth;			/* Iterative deepening depth limit */
+	u32		time_limit_ms;		/* Stop the search after this time, 0 for no limit */
+	u32		soft_limit_ms;		/* No new depth after this time (scaled by the best move stability), 0 for no limit */
+	u64		node_limit;			/* Stop the search after this number of nodes, all threads, 0 for no limit */
+	s32		threads;			/* Number of search threads, they share the transposition table */
+	TranspositionTable	*tt;	/* Transposition table, NULL to search without */
+	s8		ponder;				/* TRUE while pondering, the time limits are ignored until it's cleared (ponder hit) */
+
+	/* Result */
+	Move	best_move;			/* Best move of the last finished depth */
+	s32		score;				/* Score of the best move, side to move point of view */
+	s32		depth;				/* Last finished depth */
+	u64		nodes;				/* Number of nodes searched, all threads */
+
+	/* Internal state */
+	u64		start_ms;			/* Search start time */
+	u64		node_count;			/* Nodes of all the threads, counted by blocks for the node limit */
+	s8		stop;				/* TRUE when the search must stop, shared by the threads, set it to cancel the search */
+} SearchInfo;
+
+/* Bot worker job queue size, a job is a board snapshot */
+#define BOT_JOB_QUEUE_SIZE 4
+
+/* Bot move found by the worker thread */
+typedef struct s_bot_result {
+	u32		id;					/* Job id, a result of an old or cancelled job is dropped */
+	u64		hash_key;			/* Key of the searched position, the board must still match */
+	Move	move;				/* Best move, MOVE_NONE if there is no legal move */
+	s32		score;				/* Search score, side to move point of view */
+	s32		depth;				/* Last finished depth, 0 for a book move */
+	u64		nodes;				/* Nodes searched */
+	u64		time_ms;			/* Search time */
+	s8		from_book;			/* TRUE if the move come from the opening book */
+} BotResult;
+
+/* src/transposition.c */
+s8		tt_init(TranspositionTable *tt, u32 size_mb);
+s8		tt_resize(TranspositionTable *tt, u32 size_mb);
+void	tt_clear(TranspositionTable *tt);
+void	tt_free(TranspositionTable *tt);
+void	tt_new_search(TranspositionTable *tt);
+s8		tt_probe(TranspositionTable *tt, u64 key, s32 ply, TTData *out);
+void	tt_store(TranspositionTable *tt, u64 key, s32 ply, s32 depth, TTBound bound, s32 score, Move move);
+
+/* src/move_picker.c */
+void	move_picker_init(MovePicker *mp, ChessBoard *b, Move hash_move, Move *killer, s32 (*history)[TILE_MAX]);
+void	move_picker_init_capture(MovePicker *mp, ChessBoard *b);
+Move	move_picker_next(MovePicker *mp);
+
+/* src/opening_book.c */
+s8		book_open(OpeningBook *book, const char *path);
+void	book_close(OpeningBook *book);
+u64		polyglot_key(ChessBoard *b);
+u16		book_encode_move(Move move);
+Move	book_decode_move(ChessBoard *b, u16 book_move);
+Move	book_probe(OpeningBook *book, ChessBoard *b);
+
+/* src/uci_engine.c */
+void	uci_move_to_str(Move move, char *buff);
+Move	uci_parse_move(ChessBoard *b, const char *str);
+s8		uci_engine_start(UciEngine *e, const char *path);
+void	uci_engine_stop(UciEngine *e);
+s8		uci_engine_send(UciEngine *e, const char *cmd);
+s32		uci_engine_read_line(UciEngine *e, char *line, u32 size, u32 timeout_ms);
+Move	uci_engine_go(UciEngine *e, ChessBoard *b, const char *fen, const char *moves, u32 movetime_ms, s8 *stop);
+
+/* src/search.c */
+u64		search_time_ms();
+s32		get_cpu_count();
+const BotSkillLevel	*get_bot_skill(BotLevel level);
+void	set_bot_skill(SearchInfo *info, BotLevel level);
+Move	search_best_move(ChessBoard *b, SearchInfo *info);
+
+/* src/time_manager.c */
+void	time_manager_init(SearchInfo *info, const BotClock *clock, u16 fullmove_count);
+s8		time_manager_stop_depth(SearchInfo *info, s32 stable_depths);
+
+/* src/chess_bot.c */
+s8		bot_set_hash_size(u32 size_mb);
+void	bot_destroy();
+Move	bot_search_move(ChessBoard *b, BotLevel level, const BotClock *clock, SearchInfo *info, s8 *from_book);
+s8		bot_apply_move(SDLHandle *h, Move move);
+void	bot_clock_from_handle(SDLHandle *h, s8 color, BotClock *clock);
+s8		bot_request_move(ChessBoard *b, BotLevel level, const BotClock *clock);
+s8		bot_poll_move(ChessBoard *b, Move *move);
+s8		bot_busy();
+void	bot_cancel();
+s8		bot_ponder(SDLHandle *h, BotLevel level);
+void	bot_turn_handover(ChessBoard *b);
+
+/* src/bot_worker.c */
+s8		bot_worker_submit(ChessBoard *b, BotLevel level, const BotClock *clock);
+s8		bot_worker_ponder(ChessBoard *b, BotLevel level, const BotClock *clock);
+s8		bot_worker_ponder_hit(u64 hash_key);
+s8		bot_worker_ponder_claim(u64 hash_key);
+s8		bot_worker_poll(BotResult *out);
+s8		bot_worker_busy();
+void	bot_worker_cancel();
+void	bot_worker_destroy();
+
+/* src/stockfish.c */
+u32		send_stockfish_fen(char *fen_str, u8 depth);
+s8		stockfish_poll(StockfishResult *out);
+void	stockfish_cancel();
+s8		stockfish_enabled();
+void	stockfish_client_destroy();
+
+#endif
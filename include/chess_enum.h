@@ -9,6 +9,11 @@ typedef enum { CHESS_TILE_ENUM } ChessTile;
 typedef enum { TILE_TYPE_ENUM } TileType;
 typedef enum { CHESS_PIECE_ENUM } ChessPiece;
 typedef enum { CHESS_BOOL_INFO_ENUM } ChessBoolInfo;
+typedef enum { MOVE_FLAG_ENUM } MoveFlag;
+typedef enum { DRAW_REASON_ENUM } DrawReason;
+typedef enum { ENDGAME_WDL_ENUM } EndgameWDL;
+typedef enum { TT_BOUND_ENUM } TTBound;
+typedef enum { MOVE_STAGE_ENUM } MoveStage;
 typedef enum { BTN_STATE_ENUM } BtnState;
 typedef enum { BTN_TYPE_ENUM } BtnType;
 typedef enum { CLIENT_STATE_ENUM } ClientState;
@@ -33,6 +38,11 @@ ENUM_TO_STRING_FUNC(ChessTile, CHESS_TILE_ENUM)
 ENUM_TO_STRING_FUNC(TileType, TILE_TYPE_ENUM)
 ENUM_TO_STRING_FUNC(ChessPiece, CHESS_PIECE_ENUM)
 ENUM_TO_STRING_FUNC(ChessBoolInfo, CHESS_BOOL_INFO_ENUM)
+ENUM_TO_STRING_FUNC(MoveFlag, MOVE_FLAG_ENUM)
+ENUM_TO_STRING_FUNC(DrawReason, DRAW_REASON_ENUM)
+ENUM_TO_STRING_FUNC(EndgameWDL, ENDGAME_WDL_ENUM)
+ENUM_TO_STRING_FUNC(TTBound, TT_BOUND_ENUM)
+ENUM_TO_STRING_FUNC(MoveStage, MOVE_STAGE_ENUM)
 ENUM_TO_STRING_FUNC(BtnState, BTN_STATE_ENUM)
 ENUM_TO_STRING_FUNC(BtnType, BTN_TYPE_ENUM)
 ENUM_TO_STRING_FUNC(ClientState, CLIENT_STATE_ENUM)
@@ -113,6 +113,54 @@
 	X(BLACK_QUEEN_ROOK_MOVED, ) \
 
 
+/* Move flag, stored in the 4 high bits of a Move */
+#define MOVE_FLAG_ENUM \
+	X(MOVE_QUIET, =0) \
+	X(MOVE_DOUBLE_PAWN, ) \
+	X(MOVE_KING_CASTLE, ) \
+	X(MOVE_QUEEN_CASTLE, ) \
+	X(MOVE_CAPTURE, ) \
+	X(MOVE_EN_PASSANT, ) \
+	X(MOVE_PROMOTION, =8) \
+	X(MOVE_PROMOTION_CAPTURE, =12) \
+
+
+/* Transposition table score bound */
+#define TT_BOUND_ENUM \
+	X(TT_BOUND_NONE, =0) \
+	X(TT_BOUND_UPPER, ) \
+	X(TT_BOUND_LOWER, ) \
+	X(TT_BOUND_EXACT, ) \
+
+
+/* Move picker stage, in the order the moves are given to the search */
+#define MOVE_STAGE_ENUM \
+	X(STAGE_HASH, =0) \
+	X(STAGE_CAPTURE_GEN, ) \
+	X(STAGE_CAPTURE, ) \
+	X(STAGE_KILLER, ) \
+	X(STAGE_QUIET_GEN, ) \
+	X(STAGE_QUIET, ) \
+	X(STAGE_DONE, ) \
+
+
+/* Draw reason, DRAW_NONE if the game can continue */
+#define DRAW_REASON_ENUM \
+	X(DRAW_NONE, =0) \
+	X(DRAW_INSUFFICIENT_MATERIAL, ) \
+	X(DRAW_FIFTY_MOVE, ) \
+	X(DRAW_REPETITION, ) \
+	X(DRAW_KNOWN_ENDGAME, ) \
+
+
+/* Known endgame result, side to move point of view */
+#define ENDGAME_WDL_ENUM \
+	X(WDL_UNKNOWN, =0) \
+	X(WDL_LOSS, ) \
+	X(WDL_DRAW, ) \
+	X(WDL_WIN, ) \
+
+
 #define BTN_STATE_ENUM \
 	X(BTN_STATE_RELEASED, =0) \
 	X(BTN_STATE_PRESSED, ) \
@@ -178,6 +226,7 @@
 	X(FLAG_PROMOTION_SELECTION, =1<<7) \
 	X(FLAG_EDIT_PROFILE, =1<<8) \
 	X(FLAG_FIRST_MOVE_PLAYED, =1<<9) \
+	X(FLAG_BOT_GAME, =1<<10) \
 
 
 #endif /* CHESS_ENUM_DEFINITIONS_H */
\ No newline at end of file
@@ -197,6 +197,9 @@ typedef struct s_center_text {
 
 #define TIME_STR_SIZE 16
 
+/* Game clock of each player, in seconds */
+#define GAME_TIME_SEC (60 * 30)
+
 /* Routine function, (local_chess_routine or network_chess_routine) */
 typedef void (*RoutineFunc)();
 
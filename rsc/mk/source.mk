@@ -8,9 +8,7 @@ SRC_DIR 		=	src
 
 MAIN_MANDATORY 	=	main.c
 
-SRCS			=	chess_board.c \
-					chess_flag.c \
-					chess_piece_move.c \
+SRCS			=	chess_flag.c \
 					generic_piece_move.c \
 					handle_board.c \
 					draw_board.c \
@@ -21,9 +19,7 @@ SRCS			=	chess_board.c \
 					handle_signal.c \
 					handle_sdl.c \
 					pawn_promotion.c \
-					chess_log.c \
 					text_display.c \
-					move_save.c \
 					handle_reconnect.c \
 					parse_message_receive.c \
 					timer.c \
@@ -37,8 +33,32 @@ SRCS			=	chess_board.c \
 					handle_textfield_keyboard.c \
 					compute_win_elem_size.c \
 					android_asset_manager.c \
-					build_FEN_notation.c \
 					stockfish.c \
+					chess_bot.c \
+					bot_worker.c \
+
+# Rules core sources (libchess_core.a), no SDL, TTF or curl dependency
+CORE_SRCS		=	chess_board.c \
+					attack_table.c \
+					chess_piece_move.c \
+					legal_move.c \
+					generate_move.c \
+					board_move.c \
+					zobrist.c \
+					draw_detection.c \
+					endgame.c \
+					syzygy.c \
+					evaluate.c \
+					search.c \
+					time_manager.c \
+					transposition.c \
+					move_picker.c \
+					opening_book.c \
+					uci_engine.c \
+					load_FEN_notation.c \
+					build_FEN_notation.c \
+					move_save.c \
+					chess_log.c \
 
 MAKE_LIBFT		=	make -s -C libft -j
 
@@ -50,6 +70,10 @@ LIST			= 	libft/list/linked_list.a
 
 OBJS 			= $(addprefix $(OBJ_DIR)/, $(SRCS:.c=.o))
 
+CORE_OBJS		= $(addprefix $(OBJ_DIR)/, $(CORE_SRCS:.c=.o))
+
+CORE_LIB		=	libchess_core.a
+
 RM			=	rm -rf
 
 ifeq ($(findstring bonus, $(MAKECMDGOALS)), bonus)
@@ -60,9 +84,9 @@ SRCS += $(MAIN_MANDATORY)
 endif
 
 ifeq ($(findstring leak, $(MAKECMDGOALS)), leak)
-CFLAGS = -Wall -Wextra -Werror -g3 -fsanitize=address
+CFLAGS = -Wall -Wextra -Werror -g3 -fsanitize=address -DCHESS_BOARD_DEBUG
 else ifeq ($(findstring thread, $(MAKECMDGOALS)), thread)
 CFLAGS = -Wall -Wextra -Werror -g3 -fsanitize=thread
 else ifeq ($(findstring debug, $(MAKECMDGOALS)), debug)
-CFLAGS = -Wall -Wextra -Werror -g3
+CFLAGS = -Wall -Wextra -Werror -g3 -DCHESS_BOARD_DEBUG
 endif
@@ -0,0 +1,110 @@
+#include "../../include/chess.h"
+#include "../../include/chess_log.h"
+#include "../../include/chess_bot.h"
+
+/*
+ * Search bench, search a fixed suite of positions at a fixed depth on one thread.
+ * The total node count is the signature of the search: it only change when the search
+ * change (pruning, ordering, evaluation ...), a speed change keep it.
+ * Then each bot level search the same positions with its budget (nodes, time and threads),
+ * the nodes it really searched and its time per move are given.
+ * Usage:
+ *	./chess_bench [depth]		Default depth BENCH_DEFAULT_DEPTH
+*/
+
+#define BENCH_DEFAULT_DEPTH 7
+
+static const char *bench_fen[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"r1bqk2r/pppp1ppp/2n2n2/2b1p3/2B1P3/3P1N2/PPP2PPP/RNBQK2R w KQkq - 1 5",
+	"2r3k1/pp3ppp/4p3/3p4/3P4/2P1PN2/P4PPP/2R3K1 b - - 0 20",
+	"8/5pk1/6p1/8/8/6P1/r4PK1/1R6 w - - 0 40",
+	"8/8/3k4/8/3PK3/8/8/8 w - - 0 1",
+};
+
+#define BENCH_FEN_SIZE (sizeof(bench_fen) / sizeof(char *))
+
+/* @brief Search the bench positions with the limits of a level
+ * @param tt		TranspositionTable struct, cleared for each position
+ * @param level		BotLevel enum
+ * @param max_nodes	Most nodes searched for a move, filled
+ * @param elapsed	Search time of all the positions, filled
+ * @return Nodes searched for all the positions
+*/
+static u64 bench_level(TranspositionTable *tt, BotLevel level, u64 *max_nodes, u64 *elapsed) {
+	ChessBoard	b;
+	SearchInfo	info;
+	u64			nodes = 0;
+
+	*max_nodes = 0;
+	*elapsed = 0;
+	for (u32 i = 0; i < BENCH_FEN_SIZE; i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		fast_bzero(&info, sizeof(SearchInfo));
+		load_FEN_notation(&b, (char *)bench_fen[i]);
+		tt_clear(tt);
+		set_bot_skill(&info, level);
+		info.tt = tt;
+		search_best_move(&b, &info);
+		*elapsed += search_time_ms() - info.start_ms;
+		nodes += info.nodes;
+		if (info.nodes > *max_nodes) {
+			*max_nodes = info.nodes;
+		}
+	}
+	return (nodes);
+}
+
+int main(int argc, char **argv) {
+	TranspositionTable	tt;
+	ChessBoard			b;
+	SearchInfo			info;
+	s32					depth = argc > 1 ? ft_atoi(argv[1]) : BENCH_DEFAULT_DEPTH;
+	u64					nodes = 0, elapsed = 0, nps = 0, max_nodes = 0;
+	const BotSkillLevel	*skill = NULL;
+
+	set_log_level(LOG_ERROR);
+	if (depth < 1 || depth > SEARCH_MAX_DEPTH || !tt_init(&tt, TT_DEFAULT_SIZE_MB)) {
+		printf("Usage: %s [depth]\n", argv[0]);
+		return (1);
+	}
+	/* Same state for each position: empty table, one thread, no time or node limit */
+	for (u32 i = 0; i < BENCH_FEN_SIZE; i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		fast_bzero(&info, sizeof(SearchInfo));
+		load_FEN_notation(&b, bench_fen[i]);
+		tt_clear(&tt);
+		info.max_depth = depth;
+		info.threads = 1;
+		info.tt = &tt;
+		search_best_move(&b, &info);
+		elapsed += search_time_ms() - info.start_ms;
+		nodes += info.nodes;
+		printf("Position %2u/%u: %10llu nodes, best %s%s\n", i + 1, (u32)BENCH_FEN_SIZE, (unsigned long long)info.nodes
+			, ChessTile_to_str(move_from(info.best_move)), ChessTile_to_str(move_to(info.best_move)));
+	}
+	nps = elapsed > 0 ? nodes * 1000 / elapsed : 0;
+
+	printf("===========================\n");
+	printf("Depth           : %d\n", depth);
+	printf("Total time (ms) : %llu\n", (unsigned long long)elapsed);
+	printf(CYAN"Nodes searched  : %llu"RESET"\n", (unsigned long long)nodes);
+	printf("Nodes/second    : %llu\n", (unsigned long long)nps);
+
+	/* Nodes really searched by each level, the time limit stop the search on a slow machine */
+	printf("===========================\n");
+	printf("%-8s %12s %14s %14s %12s\n", "Level", "Nodes/move", "Searched/move", "Max searched", "ms/move");
+	for (s32 level = LEVEL_EASY; level <= LEVEL_EXPERT; level++) {
+		skill = get_bot_skill(level);
+		nodes = bench_level(&tt, level, &max_nodes, &elapsed);
+		printf("%-8s %12llu %14llu %14llu %12llu\n", skill->name, (unsigned long long)skill->nodes
+			, (unsigned long long)(nodes / BENCH_FEN_SIZE), (unsigned long long)max_nodes, (unsigned long long)(elapsed / BENCH_FEN_SIZE));
+	}
+	tt_free(&tt);
+	return (0);
+}
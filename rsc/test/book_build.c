@@ -0,0 +1,138 @@
+#include "../../include/chess.h"
+#include "../../include/chess_log.h"
+#include "../../include/chess_bot.h"
+
+/*
+ * Build a Polyglot opening book from opening lines.
+ * Each line of the input file is a list of moves in coordinate notation from the start position
+ * (e2e4 e7e5 g1f3 ...), a '#' line is a comment. Each position/move pair get a weight equal to
+ * the number of lines that play it.
+ * Usage:
+ *	./chess_book_build <lines.txt> <book.bin> [max_ply]		Default max_ply is 16
+*/
+
+#define START_FEN		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define LINE_SIZE		4096
+#define BOOK_MAX_WEIGHT	0xFFFF
+
+typedef struct s_book_entry {
+	u64		key;
+	u16		move;
+	u32		weight;
+} BookEntry;
+
+/* @brief Sort by key, then by move to merge the duplicates */
+static int entry_cmp_move(const void *a, const void *b) {
+	const BookEntry *ea = a, *eb = b;
+
+	if (ea->key != eb->key) {
+		return (ea->key < eb->key ? -1 : 1);
+	}
+	return ((int)ea->move - (int)eb->move);
+}
+
+/* @brief Sort by key, then by weight, the most played move first */
+static int entry_cmp_weight(const void *a, const void *b) {
+	const BookEntry *ea = a, *eb = b;
+
+	if (ea->key != eb->key) {
+		return (ea->key < eb->key ? -1 : 1);
+	}
+	return ((int)eb->weight - (int)ea->weight);
+}
+
+/* @brief Add the position/move pairs of one line
+ * @param line		Opening line, modified by the tokenizer
+ * @param max_ply	Number of moves kept
+ * @param entries	Entry array, grown if needed
+ * @param count		Number of entries, updated
+ * @param capacity	Entry array size, updated
+ * @return TRUE on success, FALSE on malloc failure
+*/
+static s8 add_line(char *line, s32 max_ply, BookEntry **entries, u32 *count, u32 *capacity) {
+	ChessBoard	b;
+	Undo		undo;
+	Move		move = MOVE_NONE;
+	char		*token = strtok(line, " \t\r\n");
+	BookEntry	*tmp = NULL;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, START_FEN);
+	for (s32 ply = 0; token && ply < max_ply; ply++, token = strtok(NULL, " \t\r\n")) {
+		if ((move = uci_parse_move(&b, token)) == MOVE_NONE) {
+			printf(RED"Illegal move %s at ply %d, rest of the line ignored\n"RESET, token, ply);
+			break ;
+		}
+		if (*count == *capacity) {
+			*capacity = *capacity ? *capacity * 2 : 1024;
+			if (!(tmp = realloc(*entries, *capacity * sizeof(BookEntry)))) {
+				return (FALSE);
+			}
+			*entries = tmp;
+		}
+		(*entries)[(*count)++] = (BookEntry){polyglot_key(&b), book_encode_move(move), 1};
+		make_move(&b, move, &undo);
+	}
+	return (TRUE);
+}
+
+/* @brief Write a big endian value */
+static void write_be(FILE *file, u64 value, s32 size) {
+	for (s32 i = size - 1; i >= 0; i--) {
+		fputc((value >> (i * 8)) & 0xFF, file);
+	}
+}
+
+int main(int argc, char **argv) {
+	FILE		*in = NULL, *out = NULL;
+	char		line[LINE_SIZE];
+	BookEntry	*entries = NULL;
+	u32			count = 0, capacity = 0, merged = 0;
+	s32			max_ply = argc > 3 ? ft_atoi(argv[3]) : 16;
+
+	set_log_level(LOG_ERROR);
+	if (argc < 3 || max_ply < 1) {
+		printf("Usage: %s <lines.txt> <book.bin> [max_ply]\n", argv[0]);
+		return (1);
+	}
+	if (!(in = fopen(argv[1], "r"))) {
+		printf(RED"Can't open %s\n"RESET, argv[1]);
+		return (1);
+	}
+	while (fgets(line, LINE_SIZE, in)) {
+		if (line[0] != '#' && !add_line(line, max_ply, &entries, &count, &capacity)) {
+			printf(RED"Malloc failed\n"RESET);
+			fclose(in);
+			free(entries);
+			return (1);
+		}
+	}
+	fclose(in);
+
+	/* Merge the same position/move pairs, the weight is the number of lines */
+	qsort(entries, count, sizeof(BookEntry), entry_cmp_move);
+	for (u32 i = 0; i < count; i++) {
+		if (merged > 0 && entries[merged - 1].key == entries[i].key && entries[merged - 1].move == entries[i].move) {
+			entries[merged - 1].weight += entries[merged - 1].weight < BOOK_MAX_WEIGHT;
+		} else {
+			entries[merged++] = entries[i];
+		}
+	}
+	qsort(entries, merged, sizeof(BookEntry), entry_cmp_weight);
+
+	if (!(out = fopen(argv[2], "wb"))) {
+		printf(RED"Can't create %s\n"RESET, argv[2]);
+		free(entries);
+		return (1);
+	}
+	for (u32 i = 0; i < merged; i++) {
+		write_be(out, entries[i].key, 8);
+		write_be(out, entries[i].move, 2);
+		write_be(out, entries[i].weight, 2);
+		write_be(out, 0, 4);
+	}
+	fclose(out);
+	printf(GREEN"%s: %u entries\n"RESET, argv[2], merged);
+	free(entries);
+	return (0);
+}
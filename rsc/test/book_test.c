@@ -0,0 +1,75 @@
+#include "test_check.h"
+
+/*
+ * Opening book test, the Polyglot keys and a probe of the default book.
+ * The expected keys are the test positions of the Polyglot book format specification,
+ * a book built by another Polyglot tool use the same keys.
+ * Usage:
+ *	./chess_book_test [book.bin]		Default book is BOOK_PATH
+*/
+
+typedef struct s_key_position {
+	const char	*fen;
+	u64			key;
+} KeyPosition;
+
+static const KeyPosition key_positions[] = {
+	{"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463B96181691FC9CULL},
+	{"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823C9B50FD114196ULL},
+	{"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756B94461C50FB0ULL},
+	{"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662FAFB965DB29D4ULL},
+	{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", 0x22A48B5A8E47FF78ULL},
+	{"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", 0x652A607CA3F242C1ULL},
+	{"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", 0x00FDD303C946BDD9ULL},
+	{"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", 0x3C8123EA7B067637ULL},
+	{"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5C3F9B829B279560ULL},
+};
+
+/* @brief The key of each test position of the Polyglot specification */
+static int test_polyglot_keys() {
+	ChessBoard	b;
+	u64			key = 0, start = search_time_ms();
+	s8			ok = TRUE;
+
+	for (u32 i = 0; i < sizeof(key_positions) / sizeof(KeyPosition); i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		load_FEN_notation(&b, (char *)key_positions[i].fen);
+		key = polyglot_key(&b);
+		if (key != key_positions[i].key) {
+			printf("Wrong key: %s, %016llx for %016llx\n", key_positions[i].fen
+				, (unsigned long long)key, (unsigned long long)key_positions[i].key);
+			ok = FALSE;
+		}
+	}
+	return (test_check("Polyglot keys", ok, start));
+}
+
+/* @brief The book give a legal move for the start position */
+static int test_book_probe(const char *path) {
+	OpeningBook	book;
+	ChessBoard	b;
+	Move		move = MOVE_NONE;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	fast_bzero(&book, sizeof(OpeningBook));
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, (char *)key_positions[0].fen);
+	ok = book_open(&book, path);
+	if (ok) {
+		move = book_probe(&book, &b);
+		ok = move != MOVE_NONE && book_decode_move(&b, book_encode_move(move)) == move;
+		book_close(&book);
+	}
+	return (test_check("Book probe", ok, start));
+}
+
+int main(int argc, char **argv) {
+	int ret = 0;
+
+	set_log_level(LOG_ERROR);
+	ret |= test_polyglot_keys();
+	ret |= test_book_probe(argc > 1 ? argv[1] : BOOK_PATH);
+	printf("%s"RESET"\n", ret == 0 ? GREEN"Opening book OK" : RED"Opening book KO");
+	return (ret);
+}
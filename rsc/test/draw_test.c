@@ -0,0 +1,131 @@
+#include "test_check.h"
+
+/*
+ * Draw rules test, threefold repetition, fifty moves and insufficient material.
+ * Usage:
+ *	./chess_draw_test
+*/
+
+#define START_FEN		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+/* @brief Play a list of coordinate notation moves
+ * @param b		ChessBoard struct
+ * @param moves	Moves, NULL terminated
+ * @param draw	Filled with the draw reason after each move, NULL to ignore
+ * @return TRUE if all the moves are legal, FALSE otherwise
+*/
+static s8 play_moves(ChessBoard *b, const char **moves, DrawReason *draw) {
+	Move	move = MOVE_NONE;
+	Undo	undo;
+
+	for (s32 i = 0; moves[i]; i++) {
+		move = uci_parse_move(b, moves[i]);
+		if (move == MOVE_NONE) {
+			printf("Illegal move: %s\n", moves[i]);
+			return (FALSE);
+		}
+		make_move(b, move, &undo);
+		if (draw) {
+			draw[i] = get_draw_reason(b);
+		}
+	}
+	return (TRUE);
+}
+
+/* @brief Load a position and play moves
+ * @return TRUE if the position and all the moves are legal, FALSE otherwise
+*/
+static s8 load_and_play(ChessBoard *b, const char *fen, const char **moves, DrawReason *draw) {
+	fast_bzero(b, sizeof(ChessBoard));
+	return (load_FEN_notation(b, (char *)fen) && play_moves(b, moves, draw));
+}
+
+/* @brief Only the third occurrence of a position is a draw */
+static int test_threefold() {
+	static const char	*moves[] = {"g1f3", "g8f6", "f3g1", "f6g8", "g1f3", "g8f6", "f3g1", "f6g8", NULL};
+	DrawReason			draw[8];
+	ChessBoard			b;
+	u64					start = search_time_ms();
+	s8					ok = TRUE;
+
+	ok = load_and_play(&b, START_FEN, moves, draw);
+	for (s32 i = 0; ok && i < 7; i++) {
+		ok = draw[i] == DRAW_NONE;
+	}
+	ok = ok && draw[7] == DRAW_REPETITION && repetition_count(&b) == 3;
+	return (test_check("Threefold repetition", ok, start));
+}
+
+/* @brief A double push no pawn can take and lost castle bits without a right change keep the same position */
+static int test_threefold_key() {
+	/* The position after e7e5 repeat, no white pawn can take on e6 */
+	static const char	*en_passant[] = {"e2e4", "e7e5", "g1f3", "g8f6", "f3g1", "f6g8", "g1f3", "g8f6", "f3g1", "f6g8", NULL};
+	/* The king move lose both rights, the rook moves after it only set the moved bits */
+	static const char	*castle[] = {"e1e2", "e8e7", "e2e1", "e7e8", "a1a2", "e8e7", "a2a1", "e7e8"
+									, "h1h2", "e8e7", "h2h1", "e7e8", NULL};
+	ChessBoard			b;
+	u64					start = search_time_ms();
+	s8					ok = TRUE;
+
+	ok = load_and_play(&b, START_FEN, en_passant, NULL) && repetition_count(&b) == 3;
+	ok = ok && load_and_play(&b, "4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1", castle, NULL) && repetition_count(&b) == 3;
+	return (test_check("Repetition key", ok, start));
+}
+
+/* @brief The hundredth halfmove without capture or pawn move is a draw, a pawn move reset the count */
+static int test_fifty_move() {
+	static const char	*quiet[] = {"a1a2", NULL};
+	static const char	*pawn[] = {"h2h3", NULL};
+	DrawReason			draw[1];
+	ChessBoard			b;
+	u64					start = search_time_ms();
+	s8					ok = TRUE;
+
+	ok = load_and_play(&b, "8/8/8/8/8/3k4/7P/R3K3 w - - 98 80", quiet, draw) && draw[0] == DRAW_NONE;
+	ok = ok && load_and_play(&b, "8/8/8/8/8/3k4/7P/R3K3 w - - 99 80", quiet, draw) && draw[0] == DRAW_FIFTY_MOVE;
+	ok = ok && load_and_play(&b, "8/8/8/8/8/3k4/7P/R3K3 w - - 99 80", pawn, draw) && draw[0] == DRAW_NONE;
+	return (test_check("Fifty moves", ok, start));
+}
+
+/* @brief Insufficient material: lone kings, a single minor piece, bishops on one tile color */
+static int test_insufficient_material() {
+	static const char	*draw_fen[] = {
+		"8/8/4k3/8/8/3K4/8/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/3B4/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/8/6n1 w - - 0 1",
+		"8/8/4k3/2b5/8/3K4/3B4/8 w - - 0 1",
+	};
+	static const char	*play_fen[] = {
+		"8/8/4k3/8/8/3K4/3P4/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/3R4/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/2NN4/8 w - - 0 1",
+		"8/8/4k3/8/2b5/3K4/3B4/8 w - - 0 1",
+		"8/8/4k3/8/8/3K4/3BN3/8 w - - 0 1",
+	};
+	ChessBoard	b;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	for (u32 i = 0; i < sizeof(draw_fen) / sizeof(char *); i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		ok = ok && load_FEN_notation(&b, (char *)draw_fen[i]) && is_insufficient_material(&b)
+			&& get_draw_reason(&b) == DRAW_INSUFFICIENT_MATERIAL;
+	}
+	for (u32 i = 0; i < sizeof(play_fen) / sizeof(char *); i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		ok = ok && load_FEN_notation(&b, (char *)play_fen[i]) && !is_insufficient_material(&b);
+	}
+	return (test_check("Insufficient material", ok, start));
+}
+
+int main() {
+	int ret = 0;
+
+	set_log_level(LOG_ERROR);
+	ret |= test_threefold();
+	ret |= test_threefold_key();
+	ret |= test_fifty_move();
+	ret |= test_insufficient_material();
+	printf("%s"RESET"\n", ret == 0 ? GREEN"Draw rules OK" : RED"Draw rules KO");
+	return (ret);
+}
@@ -0,0 +1,277 @@
+#include "test_check.h"
+
+#include <unistd.h>
+
+/*
+ * Known endgames test, the KPK bitbase, the game adjudication and the Syzygy fallback.
+ * The Syzygy tables are probed only if C_CHESS_SYZYGY give a tablebase directory with the 3 pieces tables.
+ * Usage:
+ *	./chess_endgame_test
+ *	C_CHESS_SYZYGY=path/to/syzygy ./chess_endgame_test
+*/
+
+typedef struct s_endgame_position {
+	const char	*fen;
+	EndgameWDL	wdl;		/* Side to move point of view */
+} EndgamePosition;
+
+/* @brief Known KPK results, both sides to move and both pawn colors */
+static const EndgamePosition kpk_positions[] = {
+	/* King on the sixth rank in front of his pawn, win with any side to move */
+	{"4k3/8/4K3/4P3/8/8/8/8 w - - 0 1", WDL_WIN},
+	{"4k3/8/4K3/4P3/8/8/8/8 b - - 0 1", WDL_LOSS},
+	/* Pawn on the seventh rank, pat with black to move, Kd6 Kf7 Kd7 win with white to move */
+	{"4k3/4P3/4K3/8/8/8/8/8 w - - 0 1", WDL_WIN},
+	{"4k3/4P3/4K3/8/8/8/8/8 b - - 0 1", WDL_DRAW},
+	/* Rook pawn with the defending king in the corner */
+	{"k7/8/8/P7/8/8/8/K7 w - - 0 1", WDL_DRAW},
+	/* The king is out of the pawn square */
+	{"8/8/8/P7/8/8/8/K6k w - - 0 1", WDL_WIN},
+	{"8/8/8/P7/8/8/8/K6k b - - 0 1", WDL_LOSS},
+	/* Undefended pawn taken at once */
+	{"8/8/8/8/8/8/Pk6/7K b - - 0 1", WDL_DRAW},
+	/* Black pawn, mirrored probe */
+	{"k7/8/8/8/p7/8/8/7K b - - 0 1", WDL_WIN},
+	{"k7/8/8/8/p7/8/8/7K w - - 0 1", WDL_LOSS},
+	{"8/8/8/8/4p3/4k3/8/4K3 w - - 0 1", WDL_LOSS},
+};
+
+/* @brief The KPK bitbase give the known results */
+static int test_kpk_positions() {
+	ChessBoard	b;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	for (u32 i = 0; i < sizeof(kpk_positions) / sizeof(EndgamePosition); i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		load_FEN_notation(&b, (char *)kpk_positions[i].fen);
+		if (endgame_probe(&b) != kpk_positions[i].wdl) {
+			printf("Wrong KPK result: %s, %s for %s\n", kpk_positions[i].fen
+				, EndgameWDL_to_str(endgame_probe(&b)), EndgameWDL_to_str(kpk_positions[i].wdl));
+			ok = FALSE;
+		}
+	}
+	return (test_check("KPK positions", ok, start));
+}
+
+/* @brief Check if white win after a promotion, the queen or rook win if black can't take it or is pat
+ * @param b		ChessBoard struct, black to move
+ * @param piece	Promotion piece tile
+*/
+static s8 promotion_white_win(ChessBoard *b, ChessTile piece) {
+	Move	moves[MAX_MOVES];
+	s32		count = generate_legal_moves(b, moves);
+
+	if (!(b->piece[WHITE_QUEEN] | b->piece[WHITE_ROOK]) || count == 0) {
+		return (count == 0 && u8ValueGet(b->info, BLACK_CHECK));
+	}
+	for (s32 i = 0; i < count; i++) {
+		if (move_to(moves[i]) == piece) {
+			return (FALSE);
+		}
+	}
+	return (TRUE);
+}
+
+/* @brief Check if white win a position after a white or black move, the white pawn is promoted or taken
+ * @param b		ChessBoard struct
+ * @param move	Move just played
+*/
+static s8 child_white_win(ChessBoard *b, Move move) {
+	EndgameWDL wdl = WDL_UNKNOWN;
+
+	if (!b->piece[WHITE_PAWN]) {
+		return (b->turn == IS_BLACK && move_is_promotion(move) && promotion_white_win(b, move_to(move)));
+	}
+	wdl = endgame_probe(b);
+	return (wdl == (b->turn == IS_WHITE ? WDL_WIN : WDL_LOSS));
+}
+
+/* @brief Check a KPK position against its successors, played with the move generator
+ * @param b		ChessBoard struct, white has the pawn
+ * @return TRUE if the bitbase result match the successors
+*/
+static s8 kpk_position_consistent(ChessBoard *b) {
+	Move	moves[MAX_MOVES];
+	Undo	undo;
+	s32		count = generate_legal_moves(b, moves);
+	s8		win = b->turn == IS_BLACK, child = FALSE;
+
+	/* White need one winning move, black one move that doesn't lose, no move is pat */
+	for (s32 i = 0; i < count; i++) {
+		make_move(b, moves[i], &undo);
+		child = child_white_win(b, moves[i]);
+		unmake_move(b, moves[i], &undo);
+		if (b->turn == IS_WHITE && child) {
+			win = TRUE;
+			break ;
+		} else if (b->turn == IS_BLACK && !child) {
+			win = FALSE;
+			break ;
+		}
+	}
+	if (count == 0 || !win) {
+		return (endgame_probe(b) == WDL_DRAW);
+	}
+	return (endgame_probe(b) == (b->turn == IS_WHITE ? WDL_WIN : WDL_LOSS));
+}
+
+/* @brief Every legal KPK position (pawn on the A-D files) match the result of its successors */
+static int test_kpk_retrograde() {
+	ChessBoard	b;
+	ChessTile	pawn = INVALID_TILE;
+	u64			start = search_time_ms();
+	u32			errors = 0, checked = 0;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1");
+	for (s32 pawn_idx = 0; pawn_idx < 24; pawn_idx++) {
+		pawn = (pawn_idx / 4 + 1) * 8 + (pawn_idx & 3);
+		for (ChessTile wk = 0; wk < TILE_MAX; wk++) {
+			for (ChessTile bk = 0; bk < TILE_MAX; bk++) {
+				if (wk == bk || wk == pawn || bk == pawn || tile_distance(wk, bk) <= 1) {
+					continue ;
+				}
+				for (s8 turn = IS_WHITE; turn <= IS_BLACK; turn++) {
+					/* Black in check with white to move */
+					if (turn == IS_WHITE && (g_pawn_attack[IS_WHITE][pawn] & (1ULL << bk))) {
+						continue ;
+					}
+					b.piece[WHITE_KING] = 1ULL << wk;
+					b.piece[BLACK_KING] = 1ULL << bk;
+					b.piece[WHITE_PAWN] = 1ULL << pawn;
+					b.turn = turn;
+					update_piece_state(&b);
+					checked++;
+					if (!kpk_position_consistent(&b) && errors++ < 10) {
+						printf("KPK result not consistent: wk %d bk %d pawn %d turn %d\n", wk, bk, pawn, turn);
+					}
+				}
+			}
+		}
+	}
+	if (errors != 0) {
+		printf("%u / %u KPK positions not consistent\n", errors, checked);
+	}
+	return (test_check("KPK retrograde", errors == 0, start));
+}
+
+/* @brief The game end: known draws, won endgames for the right side, unknown endgames go on */
+static int test_adjudication() {
+	ChessBoard	b;
+	s8			winner = -1;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	/* Drawn KPK is a known endgame draw, not a win */
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, "k7/8/8/P7/8/8/8/K7 w - - 0 1");
+	ok = ok && get_draw_reason(&b) == DRAW_KNOWN_ENDGAME && !endgame_adjudicate(&b, &winner);
+	/* Won KPK for black, white to move */
+	load_FEN_notation(&b, "k7/8/8/8/p7/8/8/7K w - - 0 1");
+	ok = ok && get_draw_reason(&b) == DRAW_NONE && endgame_adjudicate(&b, &winner) && winner == IS_BLACK;
+	/* King and queen against king, any side to move */
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/3QK3 w - - 0 1");
+	ok = ok && endgame_adjudicate(&b, &winner) && winner == IS_WHITE;
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/3QK3 b - - 0 1");
+	ok = ok && endgame_adjudicate(&b, &winner) && winner == IS_WHITE;
+	/* The bare king can take the rook, the game go on */
+	load_FEN_notation(&b, "8/8/8/8/8/8/3r4/3K1k2 w - - 0 1");
+	ok = ok && endgame_probe(&b) == WDL_UNKNOWN && !endgame_adjudicate(&b, &winner) && get_draw_reason(&b) == DRAW_NONE;
+	/* Bishop and knight win, two knights can't force the mat */
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/2BNK3 b - - 0 1");
+	ok = ok && endgame_adjudicate(&b, &winner) && winner == IS_WHITE;
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/2NNK3 w - - 0 1");
+	ok = ok && !endgame_adjudicate(&b, &winner) && get_draw_reason(&b) == DRAW_NONE;
+	/* Insufficient material keep its own draw reason */
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/3BK3 w - - 0 1");
+	ok = ok && get_draw_reason(&b) == DRAW_INSUFFICIENT_MATERIAL && !endgame_adjudicate(&b, &winner);
+	/* More pieces than the probe limit */
+	load_FEN_notation(&b, "8/8/4k3/8/8/8/PPPP4/3QK3 w - - 0 1");
+	ok = ok && endgame_probe(&b) == WDL_UNKNOWN && !endgame_adjudicate(&b, &winner);
+	return (test_check("Adjudication", ok, start));
+}
+
+/* @brief Without table the known endgames are used, a corrupted table file is never probed */
+static int test_syzygy_fallback() {
+	static const u8	bad_magic[80] = {0x12, 0x34, 0x56, 0x78};
+	char			dir[] = "/tmp/chess_syzygy_XXXXXX";
+	char			path[64];
+	FILE			*file = NULL;
+	ChessBoard		b;
+	u64				start = search_time_ms();
+	s8				ok = TRUE;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/3QK3 b - - 0 1");
+	ok = syzygy_init(NULL) == 0 && syzygy_probe_wdl(&b) == WDL_UNKNOWN && endgame_probe(&b) == WDL_LOSS;
+	if (!mkdtemp(dir)) {
+		return (test_check("Syzygy fallback", FALSE, start));
+	}
+	snprintf(path, sizeof(path), "%s/KQvK.rtbw", dir);
+	if ((file = fopen(path, "wb"))) {
+		ok = ok && fwrite(bad_magic, 1, sizeof(bad_magic), file) == sizeof(bad_magic);
+		fclose(file);
+	}
+	/* The table is registered, its first probe find the bad magic */
+	set_log_level(LOG_NONE);
+	ok = ok && syzygy_init(dir) == 3 && syzygy_probe_wdl(&b) == WDL_UNKNOWN && endgame_probe(&b) == WDL_LOSS;
+	set_log_level(LOG_ERROR);
+	syzygy_free();
+	unlink(path);
+	rmdir(dir);
+	return (test_check("Syzygy fallback", ok && syzygy_max_pieces() == 0, start));
+}
+
+/* @brief The tables of C_CHESS_SYZYGY give the KPK results and only DTZ optimal KQK root moves */
+static int test_syzygy_tables() {
+	Move		moves[MAX_MOVES];
+	Undo		undo;
+	ChessBoard	b;
+	char		*path = getenv(SYZYGY_PATH_ENV);
+	u64			start = search_time_ms();
+	s32			count = 0, kept = 0, dtz = 0, root_dtz = 0;
+	s8			ok = TRUE;
+
+	if (!path || syzygy_init(path) < 3) {
+		printf(CYAN"Syzygy tables"RESET": skipped, %s not set\n", SYZYGY_PATH_ENV);
+		return (0);
+	}
+	for (u32 i = 0; i < sizeof(kpk_positions) / sizeof(EndgamePosition); i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		load_FEN_notation(&b, (char *)kpk_positions[i].fen);
+		if (syzygy_probe_wdl(&b) != kpk_positions[i].wdl) {
+			printf("Wrong Syzygy result: %s, %s for %s\n", kpk_positions[i].fen
+				, EndgameWDL_to_str(syzygy_probe_wdl(&b)), EndgameWDL_to_str(kpk_positions[i].wdl));
+			ok = FALSE;
+		}
+	}
+	/* Each kept move leave the bare king one ply closer to the mat */
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, "8/8/8/4k3/8/8/8/3QK3 w - - 0 1");
+	count = generate_legal_moves(&b, moves);
+	ok = ok && syzygy_probe_dtz(&b, &root_dtz) && root_dtz > 0;
+	kept = syzygy_root_filter(&b, moves, count);
+	ok = ok && kept > 0 && kept < count;
+	for (s32 i = 0; ok && i < kept; i++) {
+		make_move(&b, moves[i], &undo);
+		ok = syzygy_probe_dtz(&b, &dtz) && dtz == -(root_dtz - 1);
+		unmake_move(&b, moves[i], &undo);
+	}
+	syzygy_free();
+	return (test_check("Syzygy tables", ok, start));
+}
+
+int main() {
+	int ret = 0;
+
+	set_log_level(LOG_ERROR);
+	init_endgame_table();
+	ret |= test_kpk_positions();
+	ret |= test_kpk_retrograde();
+	ret |= test_adjudication();
+	ret |= test_syzygy_fallback();
+	ret |= test_syzygy_tables();
+	printf("%s"RESET"\n", ret == 0 ? GREEN"Endgame OK" : RED"Endgame KO");
+	return (ret);
+}
@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Stand-in UCI engine for the UCI adapter test (rsc/test/uci_engine_test.c).
+# The best move is e2e4, the position is not read.
+# Test options, reset when the engine restart:
+#	setoption name BestMove value <move>	Best move of the next searches
+#	setoption name Crash		Exit without answer on the next go
+#	setoption name Hang			Answer the next go only after stop
+
+CRASH=0
+HANG=0
+BESTMOVE="e2e4"
+
+while read -r line; do
+	line="${line%$'\r'}"
+	case "${line}" in
+		"uci")
+			printf "id name Fake UCI engine\nid author C_Chess\nuciok\n" ;;
+		"isready")
+			printf "readyok\n" ;;
+		"setoption name BestMove value "*)
+			BESTMOVE="${line##* }" ;;
+		"setoption name Crash"*)
+			CRASH=1 ;;
+		"setoption name Hang"*)
+			HANG=1 ;;
+		"go"*)
+			if [[ ${CRASH} -eq 1 ]] ; then
+				exit 1
+			fi
+			if [[ ${HANG} -eq 0 ]] ; then
+				printf "info depth 1 score cp 20 pv %s\nbestmove %s\n" "${BESTMOVE}" "${BESTMOVE}"
+			fi ;;
+		"stop")
+			if [[ ${HANG} -eq 1 ]] ; then
+				HANG=0
+				printf "bestmove %s\n" "${BESTMOVE}"
+			fi ;;
+		"quit")
+			exit 0 ;;
+	esac
+done
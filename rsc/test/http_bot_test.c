@@ -0,0 +1,145 @@
+#include "test_check.h"
+
+/*
+ * HTTP bot client test, run against the stub server (rsc/test/stub_stockfish_server.py)
+ * with C_CHESS_STOCKFISH_URL set, see rsc/test/http_bot_test.sh.
+ * Usage:
+ *	./chess_http_test
+*/
+
+#define START_FEN		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define START_FEN_LATE	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 4 3"
+#define BLACK_FEN		"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1"
+#define TEST_TIMEOUT_MS	5000
+#define CANCEL_WAIT_MS	200
+
+/* @brief Poll until the result of a request is given
+ * @return TRUE if the result is given before the timeout
+*/
+static s8 wait_result(u32 id, StockfishResult *out, u32 timeout_ms) {
+	u64 end = search_time_ms() + timeout_ms;
+
+	while (id != 0 && search_time_ms() < end) {
+		if (stockfish_poll(out) && out->id == id) {
+			return (TRUE);
+		}
+		usleep(1000);
+	}
+	return (FALSE);
+}
+
+/* @brief Request a position and wait the answer */
+static s8 request(char *fen, u8 depth, StockfishResult *out) {
+	return (wait_result(send_stockfish_fen(fen, depth), out, TEST_TIMEOUT_MS));
+}
+
+/* @brief Build a distinct position for the cache test, a lone king on a tile */
+static void lru_fen(u32 idx, char *fen) {
+	ChessTile	tile = idx % TILE_MAX;
+	u32			len = 0;
+
+	for (s32 rank = 7; rank >= 0; rank--) {
+		if (rank != tile / 8) {
+			fen[len++] = '8';
+		} else {
+			if (tile % 8) { fen[len++] = '0' + tile % 8; }
+			fen[len++] = 'K';
+			if (7 - tile % 8) { fen[len++] = '0' + 7 - tile % 8; }
+		}
+		fen[len++] = rank ? '/' : ' ';
+	}
+	fen[len++] = (idx / TILE_MAX) % 2 ? 'b' : 'w';
+	ft_memcpy(fen + len, " - - 0 1", 9);
+}
+
+/* @brief Key of the cache test, the depth change each 128 keys */
+static s8 lru_request(u32 idx, StockfishResult *out) {
+	char fen[128];
+
+	lru_fen(idx, fen);
+	return (request(fen, 7 + idx / (TILE_MAX * 2), out));
+}
+
+/* @brief The least recently used answer is evicted, a used answer is kept */
+static int test_lru() {
+	StockfishResult	r;
+	u64				start = search_time_ms();
+	s8				ok = TRUE;
+
+	ok = lru_request(0, &r) && lru_request(1, &r);
+	/* Key 0 become the most recent, then the cache is filled with new keys */
+	ok = ok && lru_request(0, &r) && r.from_cache;
+	for (u32 i = 2; ok && i < STOCKFISH_CACHE_SIZE + 1; i++) {
+		ok = lru_request(i, &r) && !r.from_cache;
+	}
+	ok = ok && lru_request(0, &r) && r.from_cache;
+	ok = ok && lru_request(1, &r) && !r.from_cache;
+	return (test_check("LRU eviction", ok, start));
+}
+
+int main() {
+	StockfishResult	r;
+	u32				id[3] = {0};
+	u32				count = 0;
+	u64				start = 0;
+	s8				ok = FALSE;
+	int				ret = 0;
+
+	set_log_level(LOG_NONE);
+	if (!stockfish_enabled()) {
+		printf("Set %s to the stub server URL\n", STOCKFISH_URL_ENV);
+		return (1);
+	}
+
+	start = search_time_ms();
+	ok = request(START_FEN, 5, &r) && ft_strncmp(r.move, "e2e4", UCI_MOVE_SIZE) == 0;
+	ret |= test_check("First request", ok && !r.from_cache && r.new_connections == 1, start);
+
+	start = search_time_ms();
+	ok = request(BLACK_FEN, 5, &r) && ft_strncmp(r.move, "e7e5", UCI_MOVE_SIZE) == 0;
+	ret |= test_check("Connection reuse", ok && !r.from_cache && r.new_connections == 0, start);
+
+	/* Same position, the move counters are not part of the key */
+	start = search_time_ms();
+	ok = request(START_FEN_LATE, 5, &r) && ft_strncmp(r.move, "e2e4", UCI_MOVE_SIZE) == 0;
+	ret |= test_check("Cache hit", ok && r.from_cache, start);
+
+	start = search_time_ms();
+	ok = request(START_FEN, 6, &r) && !r.from_cache;
+	ret |= test_check("Depth in the key", ok, start);
+
+	/* The requests run together, each result is given once */
+	start = search_time_ms();
+	id[0] = send_stockfish_fen(START_FEN, 8);
+	id[1] = send_stockfish_fen(BLACK_FEN, 8);
+	id[2] = send_stockfish_fen(START_FEN, 9);
+	/* Results in any order */
+	for (u64 end = search_time_ms() + TEST_TIMEOUT_MS; count < 3 && search_time_ms() < end; usleep(1000)) {
+		if (stockfish_poll(&r) && r.move[0] && (r.id == id[0] || r.id == id[1] || r.id == id[2])) {
+			count++;
+		}
+	}
+	ret |= test_check("Parallel requests", id[0] && id[1] && id[2] && count == 3, start);
+
+	start = search_time_ms();
+	ok = request(START_FEN, 13, &r) && ft_strncmp(r.move, "e2e4", UCI_MOVE_SIZE) == 0;
+	ret |= test_check("Big answer", ok, start);
+
+	start = search_time_ms();
+	ok = request(START_FEN, 14, &r) && r.move[0] == '\0';
+	ok = ok && request(START_FEN, 14, &r) && !r.from_cache;
+	ret |= test_check("Failed request", ok, start);
+
+	ret |= test_lru();
+
+	start = search_time_ms();
+	id[0] = send_stockfish_fen(START_FEN, 12);
+	stockfish_cancel();
+	ok = !wait_result(id[0], &r, CANCEL_WAIT_MS);
+	ok = ok && request(START_FEN, 12, &r) && !r.from_cache;
+	ret |= test_check("Cancel", ok, start);
+
+	stockfish_client_destroy();
+	printf("%s"RESET"\n", ret == 0 ? GREEN"HTTP bot client OK" : RED"HTTP bot client KO");
+	return (ret);
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+# Run the HTTP bot client test against the stub server
+# Usage: ./http_bot_test.sh <chess_http_test> [port]
+
+TEST_EXE=${1}
+PORT=${2:-18089}
+
+./rsc/test/stub_stockfish_server.py ${PORT} &
+SERVER_PID=$!
+
+# Wait for the server
+for i in $(seq 1 50) ; do
+	if (echo > /dev/tcp/127.0.0.1/${PORT}) 2>/dev/null ; then
+		break
+	fi
+	sleep 0.1
+done
+
+C_CHESS_STOCKFISH_URL="http://127.0.0.1:${PORT}/api/s/v2.php?fen=" ./${TEST_EXE}
+RET=$?
+
+kill ${SERVER_PID}
+exit ${RET}
@@ -0,0 +1,178 @@
+#include "../../include/chess.h"
+#include "../../include/chess_log.h"
+
+/*
+ * Headless perft driver, count the leaf nodes of the legal move tree.
+ * Usage:
+ *	./chess_perft						Run the reference positions and check the node count
+ *	./chess_perft -c					Same one ply less with the board checks: board_check_consistency
+ *										after each make/unmake and the key restored by unmake
+ *	./chess_perft "<fen>" <depth>		Divide output for each root move of the position
+*/
+
+typedef struct s_perft_test {
+	const char	*name;
+	const char	*fen;
+	s32			depth;
+	u64			nodes;
+	u64			check_nodes;	/* Node count one ply less, the check mode depth */
+} PerftTest;
+
+static const PerftTest perft_reference[] = {
+	{"Initial position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL, 197281ULL},
+	{"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL, 97862ULL},
+	{"Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ULL, 674624ULL},
+	{"Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL, 422333ULL},
+	{"Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL, 62379ULL},
+	{"Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL, 89890ULL},
+};
+
+#define PERFT_REFERENCE_SIZE (sizeof(perft_reference) / sizeof(PerftTest))
+
+/* Callback called for each root move in divide mode */
+typedef void (*PerftDivideFunc)(Move move, u64 nodes);
+
+/* Check mode (-c), number of board errors found */
+static s8	perft_check = FALSE;
+static u64	perft_errors = 0;
+
+/* @brief Display a move in coordinate notation, without new line */
+static void display_move(Move move) {
+	static const char promotion_char[4] = "nbrq";
+	ChessTile from = move_from(move), to = move_to(move);
+
+	printf("%c%c%c%c", 'a' + from % 8, '1' + from / 8, 'a' + to % 8, '1' + to / 8);
+	if (move_is_promotion(move)) {
+		printf("%c", promotion_char[move_flag(move) & 3]);
+	}
+}
+
+/* @brief Check the board after a make or an unmake, check mode only
+ * @param b		ChessBoard struct
+ * @param move	Move just played or taken back
+ * @param key	Expected zobrist key, 0 to skip the key check (after make)
+ * @param msg	Step name for the error message
+*/
+static void perft_check_board(ChessBoard *b, Move move, u64 key, const char *msg) {
+	if (board_check_consistency(b) && (key == 0 || b->hash_key == key)) {
+		return ;
+	}
+	/* Only the first errors are displayed, one bug is usually found by many nodes */
+	if (perft_errors++ < 10) {
+		printf(RED"Board out of sync after %s of "RESET, msg);
+		display_move(move);
+		printf(RED"%s"RESET"\n", key != 0 && b->hash_key != key ? ", key not restored" : "");
+	}
+}
+
+/* @brief Get the current time in seconds */
+static double perft_time() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+/* @brief Count the leaf nodes at depth with make/unmake
+ * @param b			ChessBoard struct
+ * @param depth		Depth to search
+ * @param divide	Callback for each root move, NULL to disable
+ * @return Number of leaf nodes
+*/
+static u64 perft(ChessBoard *b, s32 depth, PerftDivideFunc divide) {
+	Move		moves[MAX_MOVES];
+	s32			count = 0;
+	u64			nodes = 0, child = 0;
+	Undo		undo;
+	u64			key = b->hash_key;
+
+	if (depth == 0) {
+		return (1);
+	}
+	count = generate_legal_moves(b, moves);
+	/* Bulk counting, the leaf moves are not played (played in check mode) */
+	if (depth == 1 && !divide && !perft_check) {
+		return (count);
+	}
+	for (s32 i = 0; i < count; i++) {
+		make_move(b, moves[i], &undo);
+		if (perft_check) {
+			perft_check_board(b, moves[i], 0, "make");
+		}
+		child = perft(b, depth - 1, NULL);
+		unmake_move(b, moves[i], &undo);
+		if (perft_check) {
+			perft_check_board(b, moves[i], key, "unmake");
+		}
+		if (divide) {
+			divide(moves[i], child);
+		}
+		nodes += child;
+	}
+	return (nodes);
+}
+
+/* @brief Display a root move and his node count */
+static void display_divide(Move move, u64 nodes) {
+	display_move(move);
+	printf(": %llu\n", (unsigned long long)nodes);
+}
+
+/* @brief Run perft on a position and display the result
+ * @return Number of leaf nodes
+*/
+static u64 run_perft(ChessBoard *b, s32 depth, PerftDivideFunc divide) {
+	double	start = perft_time(), elapsed = 0;
+	u64		nodes = perft(b, depth, divide);
+
+	elapsed = perft_time() - start;
+	printf("Depth %d: %llu nodes in %.3fs, %.0f nps\n", depth, (unsigned long long)nodes, elapsed, elapsed > 0 ? nodes / elapsed : 0);
+	return (nodes);
+}
+
+/* @brief Run the reference positions
+ * @return 0 if all the node count are correct (and no board error in check mode), 1 otherwise
+*/
+static int run_reference() {
+	ChessBoard	b;
+	u64			nodes = 0, expected = 0;
+	int			ret = 0;
+
+	for (u32 i = 0; i < PERFT_REFERENCE_SIZE; i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		load_FEN_notation(&b, perft_reference[i].fen);
+		printf(CYAN"%s"RESET": ", perft_reference[i].name);
+		/* The board checks are slow, one ply less */
+		nodes = run_perft(&b, perft_reference[i].depth - perft_check, NULL);
+		expected = perft_check ? perft_reference[i].check_nodes : perft_reference[i].nodes;
+		if (nodes != expected) {
+			printf(RED"KO: expected %llu nodes\n"RESET, (unsigned long long)expected);
+			ret = 1;
+		}
+	}
+	if (perft_errors != 0) {
+		printf(RED"%llu board errors\n"RESET, (unsigned long long)perft_errors);
+		ret = 1;
+	}
+	printf("%s"RESET"\n", ret == 0 ? GREEN"Perft OK" : RED"Perft KO");
+	return (ret);
+}
+
+int main(int argc, char **argv) {
+	ChessBoard b;
+
+	set_log_level(LOG_ERROR);
+	perft_check = argc == 2 && ft_strncmp(argv[1], "-c", 3) == 0;
+	if (argc == 1 || perft_check) {
+		return (run_reference());
+	} else if (argc != 3) {
+		printf("Usage: %s [-c | \"<fen>\" <depth>]\n", argv[0]);
+		return (1);
+	}
+	fast_bzero(&b, sizeof(ChessBoard));
+	if (!load_FEN_notation(&b, argv[1])) {
+		return (1);
+	}
+	run_perft(&b, ft_atoi(argv[2]), display_divide);
+	return (0);
+}
@@ -0,0 +1,74 @@
+#include "../../include/chess.h"
+#include "../../include/chess_log.h"
+#include "../../include/chess_bot.h"
+
+/*
+ * Headless Lazy SMP benchmark, search the bench positions with 1, 2, 4 ... threads
+ * and display the nodes per second and the speedup against one thread.
+ * Usage:
+ *	./chess_search_bench [depth] [max_threads]	Default depth 7, max_threads is the CPU count
+*/
+
+static const char *bench_fen[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+#define BENCH_FEN_SIZE (sizeof(bench_fen) / sizeof(char *))
+
+/* @brief Search all the bench positions
+ * @param tt		TranspositionTable struct, cleared before each position
+ * @param depth		Search depth
+ * @param threads	Number of search threads
+ * @param nodes		Total nodes, filled
+ * @return Elapsed time in milliseconds
+*/
+static u64 run_bench(TranspositionTable *tt, s32 depth, s32 threads, u64 *nodes) {
+	ChessBoard	b;
+	SearchInfo	info;
+	u64			elapsed = 0;
+
+	*nodes = 0;
+	for (u32 i = 0; i < BENCH_FEN_SIZE; i++) {
+		fast_bzero(&b, sizeof(ChessBoard));
+		fast_bzero(&info, sizeof(SearchInfo));
+		load_FEN_notation(&b, bench_fen[i]);
+		tt_clear(tt);
+		info.max_depth = depth;
+		info.threads = threads;
+		info.tt = tt;
+		search_best_move(&b, &info);
+		elapsed += search_time_ms() - info.start_ms;
+		*nodes += info.nodes;
+	}
+	return (elapsed);
+}
+
+int main(int argc, char **argv) {
+	TranspositionTable	tt;
+	s32					depth = argc > 1 ? ft_atoi(argv[1]) : 7;
+	s32					max_threads = argc > 2 ? ft_atoi(argv[2]) : get_cpu_count();
+	u64					nodes = 0, elapsed = 0;
+	double				nps = 0, base_nps = 0;
+
+	set_log_level(LOG_ERROR);
+	if (depth < 1 || max_threads < 1 || !tt_init(&tt, TT_DEFAULT_SIZE_MB)) {
+		printf("Usage: %s [depth] [max_threads]\n", argv[0]);
+		return (1);
+	}
+	printf("Depth %d, %d positions, %u MB hash\n", depth, (s32)BENCH_FEN_SIZE, tt.size_mb);
+	/* Double the threads, always end with the requested thread count */
+	for (s32 threads = 1; threads <= max_threads; threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2) {
+		elapsed = run_bench(&tt, depth, threads, &nodes);
+		nps = elapsed > 0 ? nodes * 1000.0 / elapsed : 0;
+		if (threads == 1) {
+			base_nps = nps;
+		}
+		printf(CYAN"%2d threads"RESET": %10llu nodes in %6llu ms, %10.0f nps, x%.2f\n", threads
+			, (unsigned long long)nodes, (unsigned long long)elapsed, nps, base_nps > 0 ? nps / base_nps : 0);
+	}
+	tt_free(&tt);
+	return (0);
+}
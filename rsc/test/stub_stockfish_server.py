@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+
+# Stub of the stockfish.online API for the HTTP bot client test (rsc/test/http_bot_test.c).
+# HTTP/1.1 keep-alive, the best move is e2e4 for a white to move position, e7e5 otherwise.
+# Test depths:
+#	13	Padded answer, bigger than the first response buffer
+#	14	Failed request ("success":false)
+# Usage: ./stub_stockfish_server.py <port>
+
+import sys
+import json
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+
+class StockfishHandler(BaseHTTPRequestHandler):
+	protocol_version = "HTTP/1.1"
+	# Headers and body are two writes, no delayed ACK wait between them
+	disable_nagle_algorithm = True
+
+	def do_GET(self):
+		query = parse_qs(urlparse(self.path).query)
+		fen = query.get("fen", [""])[0]
+		depth = int(query.get("depth", ["0"])[0])
+		move = "e2e4" if " w " in fen else "e7e5"
+		answer = {"success": True, "evaluation": 0.2, "mate": None, "bestmove": "bestmove %s ponder g8f6" % move}
+		if depth == 13:
+			answer["continuation"] = " ".join(["e2e4 e7e5"] * 4000)
+		elif depth == 14:
+			answer = {"success": False, "data": "Invalid depth"}
+		body = json.dumps(answer, separators=(",", ":")).encode()
+		self.send_response(200)
+		self.send_header("Content-Type", "application/json")
+		self.send_header("Content-Length", str(len(body)))
+		self.end_headers()
+		self.wfile.write(body)
+
+	def log_message(self, format, *args):
+		pass
+
+
+if __name__ == "__main__":
+	ThreadingHTTPServer(("127.0.0.1", int(sys.argv[1])), StockfishHandler).serve_forever()
@@ -0,0 +1,19 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include "../../include/chess.h"
+#include "../../include/chess_log.h"
+#include "../../include/chess_bot.h"
+
+/* @brief Display a check result of a test driver
+ * @param name	Check name
+ * @param ok	TRUE if the check pass
+ * @param start	Check start time (search_time_ms)
+ * @return 0 if the check pass, 1 otherwise
+*/
+FT_INLINE int test_check(const char *name, s8 ok, u64 start) {
+	printf(CYAN"%s"RESET": %s"RESET" (%llu ms)\n", name, ok ? GREEN"OK" : RED"KO", (unsigned long long)(search_time_ms() - start));
+	return (ok ? 0 : 1);
+}
+
+#endif /* TEST_CHECK_H */
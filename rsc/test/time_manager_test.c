@@ -0,0 +1,156 @@
+#include "test_check.h"
+
+/*
+ * Time manager test, the deadlines given by the clock and the search time with a clock.
+ * Usage:
+ *	./chess_tm_test
+*/
+
+#define START_FEN		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define MIDDLE_FEN		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+#define KIWIPETE_FEN	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+#define ENDGAME_FEN		"8/5pk1/6p1/8/8/6P1/r4PK1/1R6 w - - 0 40"
+
+/* Time the search can take over the hard deadline: the check interval and the threads join */
+#define HARD_MARGIN_MS	30
+
+/* @brief Deadlines of a clock, level cap of the Expert level */
+static void clock_limits(BotClock *clock, u16 fullmove_count, SearchInfo *info) {
+	fast_bzero(info, sizeof(SearchInfo));
+	set_bot_skill(info, LEVEL_EXPERT);
+	time_manager_init(info, clock, fullmove_count);
+}
+
+/* @brief Deadlines of a clock, no level cap */
+static void clock_limits_no_cap(BotClock *clock, u16 fullmove_count, SearchInfo *info) {
+	fast_bzero(info, sizeof(SearchInfo));
+	time_manager_init(info, clock, fullmove_count);
+}
+
+/* @brief The deadlines stay in the clock and the level cap, for a range of clocks */
+static int test_deadlines() {
+	static const u64	remaining[] = {0, 50, 500, 2000, 10000, 60000, 300000, 1800000};
+	static const u32	increment[] = {0, 1000, 5000};
+	static const u16	fullmove[] = {1, 20, 45, 120};
+	BotClock			clock;
+	SearchInfo			info;
+	u64					avail = 0, start = search_time_ms();
+	s8					ok = TRUE;
+
+	for (u32 r = 0; r < sizeof(remaining) / sizeof(u64); r++) {
+		for (u32 i = 0; i < sizeof(increment) / sizeof(u32); i++) {
+			for (u32 m = 0; m < sizeof(fullmove) / sizeof(u16); m++) {
+				clock = (BotClock){remaining[r], increment[i], 0};
+				clock_limits(&clock, fullmove[m], &info);
+				avail = remaining[r] > TM_MOVE_OVERHEAD_MS ? remaining[r] - TM_MOVE_OVERHEAD_MS : 0;
+				ok = ok && info.soft_limit_ms >= TM_MIN_TIME_MS && info.soft_limit_ms <= info.time_limit_ms;
+				ok = ok && info.time_limit_ms <= get_bot_skill(LEVEL_EXPERT)->time_ms;
+				ok = ok && (info.time_limit_ms == TM_MIN_TIME_MS || info.time_limit_ms <= avail / TM_HARD_MAX_DIV);
+			}
+		}
+	}
+	return (test_check("Deadlines in the clock", ok, start));
+}
+
+/* @brief Less time per move early in the game and with less clock, more with an increment */
+static int test_budget_shape() {
+	BotClock	clock = {300000, 0, 0};
+	SearchInfo	a, b;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	clock_limits_no_cap(&clock, 1, &a);
+	clock_limits_no_cap(&clock, 40, &b);
+	ok = ok && a.soft_limit_ms < b.soft_limit_ms;
+	clock.increment_ms = 2000;
+	clock_limits_no_cap(&clock, 1, &b);
+	ok = ok && a.soft_limit_ms < b.soft_limit_ms;
+	clock = (BotClock){30000, 0, 0};
+	clock_limits_no_cap(&clock, 1, &b);
+	ok = ok && b.soft_limit_ms < a.soft_limit_ms;
+	/* moves_to_go replace the estimation */
+	clock = (BotClock){30000, 0, 2};
+	clock_limits_no_cap(&clock, 1, &a);
+	ok = ok && a.soft_limit_ms > b.soft_limit_ms;
+	/* No clock, the level limits only */
+	clock_limits(NULL, 1, &a);
+	ok = ok && a.soft_limit_ms == 0 && a.time_limit_ms == get_bot_skill(LEVEL_EXPERT)->time_ms;
+	return (test_check("Budget shape", ok, start));
+}
+
+/* @brief Search a position with a clock, no node limit
+ * @return The search time
+*/
+static u64 clock_search(TranspositionTable *tt, const char *fen, BotClock *clock, SearchInfo *info) {
+	ChessBoard b;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, (char *)fen);
+	clock_limits(clock, b.fullmove_count, info);
+	info->node_limit = 0;
+	info->tt = tt;
+	tt_clear(tt);
+	search_best_move(&b, info);
+	return (search_time_ms() - info->start_ms);
+}
+
+/* @brief A search never pass the hard deadline, a short clock still give a move */
+static int test_search_time(TranspositionTable *tt) {
+	static const char	*fen[] = {START_FEN, MIDDLE_FEN, KIWIPETE_FEN, ENDGAME_FEN};
+	static const u64	remaining[] = {0, 300, 3000, 20000};
+	BotClock			clock;
+	SearchInfo			info;
+	u64					elapsed = 0, start = search_time_ms();
+	s8					ok = TRUE;
+
+	for (u32 i = 0; i < sizeof(fen) / sizeof(char *); i++) {
+		for (u32 r = 0; r < sizeof(remaining) / sizeof(u64); r++) {
+			clock = (BotClock){remaining[r], 0, 0};
+			elapsed = clock_search(tt, fen[i], &clock, &info);
+			ok = ok && info.best_move != MOVE_NONE && elapsed <= info.time_limit_ms + HARD_MARGIN_MS;
+			if (elapsed > info.time_limit_ms + HARD_MARGIN_MS) {
+				printf("Hard deadline passed: %s, clock %llu ms, %llu ms for %u ms\n", fen[i], (unsigned long long)remaining[r]
+					, (unsigned long long)elapsed, info.time_limit_ms);
+			}
+		}
+	}
+	return (test_check("Hard deadline", ok, start));
+}
+
+/* @brief A stable best move stop the search sooner, a new best move later, no depth after half the hard deadline */
+static int test_stable_stop() {
+	SearchInfo	info;
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	fast_bzero(&info, sizeof(SearchInfo));
+	info.soft_limit_ms = 1000;
+	info.time_limit_ms = 3000;
+	/* 600 ms spent: over the soft deadline scaled for a stable move, under it for a new one */
+	info.start_ms = search_time_ms() - 600;
+	ok = ok && time_manager_stop_depth(&info, TM_STABILITY_MAX) && !time_manager_stop_depth(&info, 0);
+	/* 1600 ms spent: over half the hard deadline, even with a new best move */
+	info.start_ms = search_time_ms() - 1600;
+	ok = ok && time_manager_stop_depth(&info, 0);
+	/* The ponder search never stop on the time */
+	info.ponder = TRUE;
+	ok = ok && !time_manager_stop_depth(&info, TM_STABILITY_MAX);
+	return (test_check("Stable move stop", ok, start));
+}
+
+int main() {
+	TranspositionTable	tt;
+	int					ret = 0;
+
+	set_log_level(LOG_ERROR);
+	if (!tt_init(&tt, TT_DEFAULT_SIZE_MB)) {
+		return (1);
+	}
+	ret |= test_deadlines();
+	ret |= test_budget_shape();
+	ret |= test_search_time(&tt);
+	ret |= test_stable_stop();
+	tt_free(&tt);
+	printf("%s"RESET"\n", ret == 0 ? GREEN"Time manager OK" : RED"Time manager KO");
+	return (ret);
+}
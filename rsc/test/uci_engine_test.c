@@ -0,0 +1,114 @@
+#include "test_check.h"
+
+/*
+ * UCI engine adapter test, run against the stand-in engine (rsc/test/fake_uci_engine.sh)
+ * or any UCI engine for the first checks.
+ * Usage:
+ *	./chess_uci_test <engine>
+*/
+
+#define START_FEN		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define PROMOTION_FEN	"4k3/1P6/8/8/8/8/8/4K3 w - - 0 1"
+#define TEST_MOVETIME	50
+
+/* @brief Check if the move is from -> to */
+static s8 is_move(Move move, ChessTile from, ChessTile to) {
+	return (move != MOVE_NONE && move_from(move) == from && move_to(move) == to);
+}
+
+/* @brief Check the UCI move notation, no engine needed */
+static int test_move_notation() {
+	ChessBoard	b;
+	Move		move = MOVE_NONE;
+	char		buff[UCI_MOVE_SIZE];
+	u64			start = search_time_ms();
+	s8			ok = TRUE;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, PROMOTION_FEN);
+	move = uci_parse_move(&b, "b7b8n");
+	uci_move_to_str(move, buff);
+	ok = move_is_promotion(move) && ft_strncmp(buff, "b7b8n", UCI_MOVE_SIZE) == 0;
+	/* Promotion char needed, no char after a quiet move */
+	ok = ok && uci_parse_move(&b, "b7b8") == MOVE_NONE && uci_parse_move(&b, "e1e2q") == MOVE_NONE;
+	ok = ok && is_move(uci_parse_move(&b, "e1e2 ponder e8e7"), E1, E2);
+	return (test_check("Move notation", ok, start));
+}
+
+/* @brief Ask a move, the stand-in engine play the BestMove option */
+static Move engine_move(UciEngine *e, const char *fen, const char *moves, s8 *stop) {
+	ChessBoard	b;
+	Undo		undo;
+	char		*tmp = NULL, *token = NULL;
+
+	fast_bzero(&b, sizeof(ChessBoard));
+	load_FEN_notation(&b, fen);
+	/* The move is checked on the board after the moves */
+	if (moves && (tmp = ft_strdup(moves))) {
+		for (token = strtok(tmp, " "); token; token = strtok(NULL, " ")) {
+			make_move(&b, uci_parse_move(&b, token), &undo);
+		}
+		free(tmp);
+	}
+	return (uci_engine_go(e, &b, fen, moves, TEST_MOVETIME, stop));
+}
+
+int main(int argc, char **argv) {
+	UciEngine	e;
+	u64			start = 0;
+	s32			pid = 0;
+	s8			stop = TRUE;
+	int			ret = 0;
+
+	set_log_level(LOG_ERROR);
+	if (argc != 2) {
+		printf("Usage: %s <engine>\n", argv[0]);
+		return (1);
+	}
+	ret |= test_move_notation();
+
+	start = search_time_ms();
+	ret |= test_check("Missing engine", !uci_engine_start(&e, "rsc/test/no_engine"), start);
+
+	start = search_time_ms();
+	if (!uci_engine_start(&e, argv[1])) {
+		test_check("Engine start", FALSE, start);
+		return (1);
+	}
+	ret |= test_check("Engine start", TRUE, start);
+
+	start = search_time_ms();
+	ret |= test_check("Start position", is_move(engine_move(&e, START_FEN, NULL, NULL), E2, E4), start);
+
+	start = search_time_ms();
+	uci_engine_send(&e, "setoption name BestMove value g1f3");
+	ret |= test_check("Position with moves", is_move(engine_move(&e, START_FEN, "e2e4 e7e5", NULL), G1, F3), start);
+
+	start = search_time_ms();
+	uci_engine_send(&e, "setoption name BestMove value e2e5");
+	ret |= test_check("Illegal best move", engine_move(&e, START_FEN, NULL, NULL) == MOVE_NONE && e.pid > 0, start);
+
+	/* The engine exit on go, the adapter restart it and send the position again */
+	start = search_time_ms();
+	pid = e.pid;
+	uci_engine_send(&e, "setoption name Crash");
+	ret |= test_check("Crash restart", is_move(engine_move(&e, START_FEN, NULL, NULL), E2, E4) && e.pid != pid && e.restart_count == 0, start);
+
+	/* A cancelled search send stop, read the bestmove and give no move */
+	start = search_time_ms();
+	pid = e.pid;
+	ret |= test_check("Cancel", engine_move(&e, START_FEN, NULL, &stop) == MOVE_NONE && e.pid == pid, start);
+
+	/* No answer after movetime, stop is sent after the margin */
+	start = search_time_ms();
+	uci_engine_send(&e, "setoption name Hang");
+	ret |= test_check("Stop after the margin", is_move(engine_move(&e, START_FEN, NULL, NULL), E2, E4)
+		&& search_time_ms() - start >= UCI_MOVE_MARGIN_MS, start);
+
+	start = search_time_ms();
+	uci_engine_stop(&e);
+	ret |= test_check("Engine stop", e.pid == 0 && e.path == NULL, start);
+
+	printf("%s"RESET"\n", ret == 0 ? GREEN"UCI engine OK" : RED"UCI engine KO");
+	return (ret);
+}
@@ -0,0 +1,200 @@
+#include "../include/chess.h"
+
+/*
+ * Precomputed attack tables.
+ * Knight, king and pawn attacks are simple 64 entries tables.
+ * Sliding pieces use magic bitboard:
+ * for each tile the relevant occupancy (board edges excluded) is multiplied by a
+ * magic number, the high bits of the product give the index of the precomputed
+ * attack set in a shared table. The magic numbers below are generated offline
+ * (sparse random search), they only need to be collision free for their tile.
+*/
+
+/* Rook magic numbers, index by ChessTile */
+static const Bitboard rook_magic_number[TILE_MAX] = {
+	0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+	0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+	0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+	0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+	0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+	0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+	0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+	0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+	0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+	0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+	0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+	0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+	0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+	0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+	0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+	0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL,
+};
+
+/* Bishop magic numbers, index by ChessTile */
+static const Bitboard bishop_magic_number[TILE_MAX] = {
+	0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+	0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+	0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+	0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+	0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+	0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+	0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+	0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+	0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+	0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+	0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+	0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+	0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+	0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+	0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+	0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL,
+};
+
+/* Shared attack tables (rook: sum of 2^bits is 102400, bishop: 5248) */
+#define ROOK_ATTACK_TABLE_SIZE 102400
+#define BISHOP_ATTACK_TABLE_SIZE 5248
+
+static Bitboard rook_attack_table[ROOK_ATTACK_TABLE_SIZE];
+static Bitboard bishop_attack_table[BISHOP_ATTACK_TABLE_SIZE];
+
+MagicEntry g_rook_magic[TILE_MAX];
+MagicEntry g_bishop_magic[TILE_MAX];
+
+/* Leaper attack tables, pawn attacks are index by color (IS_WHITE, IS_BLACK) */
+Bitboard g_knight_attack[TILE_MAX];
+Bitboard g_king_attack[TILE_MAX];
+Bitboard g_pawn_attack[2][TILE_MAX];
+
+/* Line tables: tiles strictly between two aligned tiles, and the full line through them */
+Bitboard g_line_between[TILE_MAX][TILE_MAX];
+Bitboard g_line_through[TILE_MAX][TILE_MAX];
+
+/* Rook and bishop directions, as file and rank delta */
+static const s8 rook_direction[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+static const s8 bishop_direction[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+/* @brief Compute sliding attacks by walking each ray, only used to fill the tables
+ * @param tile		ChessTile enum
+ * @param occupied	Bitboard of the occupied tiles
+ * @param direction	Array of 4 direction (file delta, rank delta)
+ * @param mask_only	TRUE to build the relevant occupancy mask (stop before the board edge)
+ * @return Bitboard of the attacked tiles
+*/
+static Bitboard slow_slider_attacks(ChessTile tile, Bitboard occupied, const s8 direction[4][2], s8 mask_only) {
+	Bitboard	attacks = 0, mask = 0;
+	s32			file = 0, rank = 0;
+
+	for (s32 i = 0; i < 4; i++) {
+		file = (tile & 7) + direction[i][0];
+		rank = (tile >> 3) + direction[i][1];
+		while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+			/* The last tile of the ray is never relevant for the occupancy mask */
+			if (mask_only && (file + direction[i][0] < 0 || file + direction[i][0] > 7 \
+				|| rank + direction[i][1] < 0 || rank + direction[i][1] > 7)) {
+				break ;
+			}
+			mask = 1ULL << ((rank << 3) + file);
+			attacks |= mask;
+			if (!mask_only && (occupied & mask)) { break ; }
+			file += direction[i][0];
+			rank += direction[i][1];
+		}
+	}
+	return (attacks);
+}
+
+/* @brief Fill the magic entries and the shared attack table of a slider
+ * @param entry			MagicEntry array to fill (TILE_MAX)
+ * @param magic_number	Magic number array (TILE_MAX)
+ * @param table			Shared attack table
+ * @param direction		Array of 4 direction of the slider
+*/
+static void init_slider_table(MagicEntry *entry, const Bitboard *magic_number, Bitboard *table, const s8 direction[4][2]) {
+	Bitboard	*attacks = table;
+	Bitboard	subset = 0;
+	u64			idx = 0;
+
+	for (ChessTile tile = A1; tile < TILE_MAX; tile++) {
+		entry[tile].mask = slow_slider_attacks(tile, 0, direction, TRUE);
+		entry[tile].magic = magic_number[tile];
+		entry[tile].shift = 64 - __builtin_popcountll(entry[tile].mask);
+		entry[tile].attacks = attacks;
+
+		/* Enumerate all subsets of the mask (Carry-Rippler trick) */
+		subset = 0;
+		do {
+			idx = (subset * entry[tile].magic) >> entry[tile].shift;
+			attacks[idx] = slow_slider_attacks(tile, subset, direction, FALSE);
+			subset = (subset - entry[tile].mask) & entry[tile].mask;
+		} while (subset);
+
+		attacks += 1ULL << (64 - entry[tile].shift);
+	}
+}
+
+/* @brief Compute leaper attacks from a list of jumps, only used to fill the tables
+ * @param tile		ChessTile enum
+ * @param jump		Array of jump (file delta, rank delta)
+ * @param nb_jump	Number of jump in the array
+ * @return Bitboard of the attacked tiles
+*/
+static Bitboard slow_leaper_attacks(ChessTile tile, const s8 jump[][2], s32 nb_jump) {
+	Bitboard	attacks = 0;
+	s32			file = 0, rank = 0;
+
+	for (s32 i = 0; i < nb_jump; i++) {
+		file = (tile & 7) + jump[i][0];
+		rank = (tile >> 3) + jump[i][1];
+		if (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+			attacks |= 1ULL << ((rank << 3) + file);
+		}
+	}
+	return (attacks);
+}
+
+/* @brief Fill the knight, king and pawn attack tables */
+static void init_leaper_table() {
+	static const s8 knight_jump[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+	static const s8 king_jump[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+	static const s8 white_pawn_jump[2][2] = {{-1, 1}, {1, 1}};
+	static const s8 black_pawn_jump[2][2] = {{-1, -1}, {1, -1}};
+
+	for (ChessTile tile = A1; tile < TILE_MAX; tile++) {
+		g_knight_attack[tile] = slow_leaper_attacks(tile, knight_jump, 8);
+		g_king_attack[tile] = slow_leaper_attacks(tile, king_jump, 8);
+		g_pawn_attack[IS_WHITE][tile] = slow_leaper_attacks(tile, white_pawn_jump, 2);
+		g_pawn_attack[IS_BLACK][tile] = slow_leaper_attacks(tile, black_pawn_jump, 2);
+	}
+}
+
+/* @brief Fill the line tables from the slider attacks, must be called after init_slider_table */
+static void init_line_table() {
+	Bitboard	to_mask = 0;
+
+	for (ChessTile from = A1; from < TILE_MAX; from++) {
+		for (ChessTile to = A1; to < TILE_MAX; to++) {
+			to_mask = 1ULL << to;
+			if (get_rook_attacks(from, 0) & to_mask) {
+				g_line_between[from][to] = get_rook_attacks(from, to_mask) & get_rook_attacks(to, 1ULL << from);
+				g_line_through[from][to] = (get_rook_attacks(from, 0) & get_rook_attacks(to, 0)) | (1ULL << from) | to_mask;
+			} else if (get_bishop_attacks(from, 0) & to_mask) {
+				g_line_between[from][to] = get_bishop_attacks(from, to_mask) & get_bishop_attacks(to, 1ULL << from);
+				g_line_through[from][to] = (get_bishop_attacks(from, 0) & get_bishop_attacks(to, 0)) | (1ULL << from) | to_mask;
+			}
+		}
+	}
+}
+
+/* @brief Initialise the attack tables, only done once */
+void init_attack_table() {
+	static s8 initialised = FALSE;
+
+	if (initialised) {
+		return ;
+	}
+	init_slider_table(g_rook_magic, rook_magic_number, rook_attack_table, rook_direction);
+	init_slider_table(g_bishop_magic, bishop_magic_number, bishop_attack_table, bishop_direction);
+	init_leaper_table();
+	init_line_table();
+	initialised = TRUE;
+}
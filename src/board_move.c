@@ -0,0 +1,219 @@
+#include "../include/chess.h"
+
+/* @brief Update special info byte for the king and rook
+ * @param b		ChessBoard struct
+ * @param type	ChessPiece enum
+ * @param tile_from	ChessTile enum
+*/
+void board_special_info_handler(ChessBoard *b, ChessPiece type, ChessTile tile_from) {
+	
+	static const SpecialInfo special_info[SPECIAL_INFO_SIZE] = {
+		{WHITE_KING, WHITE_KING_MOVED, WHITE_KING_START_POS},
+		{WHITE_ROOK, WHITE_KING_ROOK_MOVED, WHITE_KING_ROOK_START_POS},
+		{WHITE_ROOK, WHITE_QUEEN_ROOK_MOVED, WHITE_QUEEN_ROOK_START_POS},
+		{BLACK_KING, BLACK_KING_MOVED, BLACK_KING_START_POS},
+		{BLACK_ROOK, BLACK_KING_ROOK_MOVED, BLACK_KING_ROOK_START_POS},
+		{BLACK_ROOK, BLACK_QUEEN_ROOK_MOVED, BLACK_QUEEN_ROOK_START_POS},
+	};
+	u64 castle_key = zobrist_castle_key(b->info);
+	s32 idx = -1;
+
+	for (s32 i = 0; i < SPECIAL_INFO_SIZE; i++) {
+		idx = special_info[i].info_idx;
+		/* Check if the piece is the king or rook and if the piece is at the start position */
+		if (special_info[i].type == type && special_info[i].tile_from == tile_from && u8ValueGet(b->info, idx) == FALSE) {
+			b->info = u8ValueSet(b->info, idx, TRUE);
+		}
+	}
+	/* Only the castle rights are hashed, a moved bit can be set without any right change */
+	b->hash_key ^= castle_key ^ zobrist_castle_key(b->info);
+}
+
+/* @brief Handle castle move (move rook if needed)
+ * @param b		ChessBoard struct
+ * @param type	ChessPiece enum
+ * @param tile_from	ChessTile enum
+ * @param tile_to	ChessTile enum
+ * @note The rook move is part of the king move, it's not saved in the move list
+*/
+void handle_castle_move(ChessBoard *b, ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
+	ChessTile rook_from = 0, rook_to = 0;
+	ChessPiece rook_type = EMPTY;
+	if (type == BLACK_KING || type == WHITE_KING) {
+		/* Check if the king is moving 2 tiles (Castle move) */
+		if (INT_ABS_DIFF(tile_from, tile_to) == 2) {
+			/* Check if the king is moving to the right or left */
+			if (tile_to == tile_from + 2) {
+				rook_from = tile_from + 3;
+				rook_to = tile_from + 1;
+			} else {
+				rook_from = tile_from - 4;
+				rook_to = tile_from - 1;
+			}
+			rook_type = (type == BLACK_KING) ? BLACK_ROOK : WHITE_ROOK;
+			board_move_piece(b, rook_type, rook_from, rook_to);
+			board_special_info_handler(b, rook_type, rook_from);
+		}
+	}
+}
+
+/* @brief Verify if the move is a double step move for a pawn
+ * @param type		ChessPiece enum
+ * @param tile_from	ChessTile enum
+ * @param tile_to	ChessTile enum
+ * @return TRUE if the move is a double step move, FALSE otherwise
+*/
+static s8 is_pawn_double_step_move(ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
+	return ((type == WHITE_PAWN || type == BLACK_PAWN) && INT_ABS_DIFF(tile_from, tile_to) == 16);
+}
+
+/* @brief Update 'en passant' Bitboard if needed
+ * @param b			ChessBoard struct
+ * @param type		ChessPiece enum
+ * @param tile_from	ChessTile enum
+ * @param tile_to	ChessTile enum
+ * @note The 'en passant' key depend on the side to move, it's updated by board_apply_move
+*/
+static void update_en_passant_bitboard(ChessBoard *b, ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
+	b->en_passant = 0;
+	b->en_passant_tile = INVALID_TILE;
+	if (is_pawn_double_step_move(type, tile_from, tile_to)) {
+		b->en_passant = (1ULL << (tile_from + tile_to) / 2);
+		b->en_passant_tile = tile_to;
+	}
+}
+
+/**
+ * @brief Handle turn count variable
+ * @param b				ChessBoard struct
+ * @param piece_type	ChessPiece enumm the piece type just moved
+ * @param kill			TRUE if a piece is killed, FALSE otherwise
+ */
+void handle_turn_count(ChessBoard *b, ChessPiece piece_type, s8 kill) {
+	if (kill == TRUE || (piece_type == BLACK_PAWN || piece_type == WHITE_PAWN)) {
+		b->halfmove_count = 0;
+	} else {
+		b->halfmove_count++;
+	}
+	if (piece_type >= BLACK_PAWN) {
+		b->fullmove_count++;
+	}
+}
+
+/* @brief Apply a move on the board without any UI or move list update
+ * @param b			ChessBoard struct
+ * @param tile_from	ChessTile enum
+ * @param tile_to	ChessTile enum
+ * @param type		ChessPiece enum, the piece moved
+ * @param promotion	ChessPiece enum, the promotion piece or EMPTY
+ * @return The captured piece, 'en passant' capture included, EMPTY if no piece is captured
+ * @note Handle capture, castle rook move, promotion, castle flags, 'en passant' tile,
+ *		turn counters, side to move, zobrist key, position history and check flags
+*/
+ChessPiece board_apply_move(ChessBoard *b, ChessTile tile_from, ChessTile tile_to, ChessPiece type, ChessPiece promotion) {
+	ChessPiece	captured = b->mailbox[tile_to];
+	ChessTile	captured_tile = tile_to;
+
+	/* Remove the 'en passant' key while the pawns and the side to move are the ones it was computed with */
+	b->hash_key ^= zobrist_en_passant_key(b);
+
+	/* 'En passant' capture, the captured pawn is not on the destination tile */
+	if (captured == EMPTY && (type == WHITE_PAWN || type == BLACK_PAWN) && (1ULL << tile_to) == b->en_passant) {
+		captured = (type == WHITE_PAWN) ? BLACK_PAWN : WHITE_PAWN;
+		captured_tile = b->en_passant_tile;
+	}
+
+	/* Remove the captured piece, a rook captured on his start tile lose the castle right */
+	if (captured != EMPTY) {
+		board_remove_piece(b, captured, captured_tile);
+		board_special_info_handler(b, captured, captured_tile);
+	}
+
+	/* Check if the move is a castle move and move rook if needed */
+	handle_castle_move(b, type, tile_from, tile_to);
+
+	/* Move the piece, only the from/to tiles are updated */
+	board_move_piece(b, type, tile_from, tile_to);
+	if (promotion != EMPTY) {
+		board_remove_piece(b, type, tile_to);
+		board_add_piece(b, promotion, tile_to);
+	}
+
+	/* Set special info for the king and rook */
+	board_special_info_handler(b, type, tile_from);
+
+	/* Update 'en passant' Bitboard if needed */
+	update_en_passant_bitboard(b, type, tile_from, tile_to);
+
+	/* Handle turn count and side to move */
+	handle_turn_count(b, type, captured != EMPTY);
+	if (b->turn != !(type >= BLACK_PAWN)) {
+		b->hash_key ^= g_zobrist_turn;
+	}
+	b->turn = !(type >= BLACK_PAWN);
+	b->hash_key ^= zobrist_en_passant_key(b);
+	board_history_push(b);
+
+	/* Update the check flags of both kings */
+	update_check_flags(b);
+	return (captured);
+}
+
+/* @brief Play a move and save the state needed to take it back
+ * @param b		ChessBoard struct
+ * @param move	Legal move for the side to move
+ * @param undo	Undo struct filled for unmake_move
+*/
+void make_move(ChessBoard *b, Move move, Undo *undo) {
+	ChessTile from = move_from(move);
+
+	undo->en_passant = b->en_passant;
+	undo->en_passant_tile = b->en_passant_tile;
+	undo->fullmove_count = b->fullmove_count;
+	undo->halfmove_count = b->halfmove_count;
+	undo->info = b->info;
+	undo->hash_key = b->hash_key;
+	undo->captured = board_apply_move(b, from, move_to(move), b->mailbox[from], move_promotion_piece(move, b->turn));
+}
+
+/* @brief Take back a move played with make_move
+ * @param b		ChessBoard struct
+ * @param move	Move given to make_move
+ * @param undo	Undo struct filled by make_move
+*/
+void unmake_move(ChessBoard *b, Move move, Undo *undo) {
+	ChessTile	from = move_from(move), to = move_to(move);
+	ChessPiece	type = b->mailbox[to];
+	s8			is_black = (type >= BLACK_PAWN);
+	u16			flag = move_flag(move);
+
+	/* Promoted piece goes back to a pawn */
+	if (move_is_promotion(move)) {
+		board_remove_piece(b, type, to);
+		type = is_black ? BLACK_PAWN : WHITE_PAWN;
+		board_add_piece(b, type, to);
+	}
+	board_move_piece(b, type, to, from);
+
+	/* Castle rook goes back to his corner */
+	if (flag == MOVE_KING_CASTLE) {
+		board_move_piece(b, is_black ? BLACK_ROOK : WHITE_ROOK, from + 1, from + 3);
+	} else if (flag == MOVE_QUEEN_CASTLE) {
+		board_move_piece(b, is_black ? BLACK_ROOK : WHITE_ROOK, from - 1, from - 4);
+	}
+
+	/* Restore the captured piece, the 'en passant' pawn is on the saved 'en passant' tile */
+	if (undo->captured != EMPTY) {
+		board_add_piece(b, undo->captured, flag == MOVE_EN_PASSANT ? undo->en_passant_tile : to);
+	}
+
+	b->en_passant = undo->en_passant;
+	b->en_passant_tile = undo->en_passant_tile;
+	b->fullmove_count = undo->fullmove_count;
+	b->halfmove_count = undo->halfmove_count;
+	b->info = undo->info;
+	b->turn = is_black;
+	/* The piece helpers above already xor back the piece keys, restore the full key */
+	b->hash_key = undo->hash_key;
+	b->history_ply--;
+}
@@ -0,0 +1,347 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/chess_bot.h"
+
+#include <pthread.h>
+
+/*
+ * Bot worker thread, the bot search run outside the SDL loop.
+ * The main thread push board snapshots in a job queue (mutex + condition, only held to push or pop),
+ * the worker search them and publish the result in a single slot mailbox: the result is written
+ * under the lock then the ready flag is set, the main thread poll the flag each frame and copy the
+ * result under the lock. An unread result is overwritten, the poll drop the results of the old jobs.
+ * A cancel empty the queue, stop the running search and drop the result of the old jobs.
+ * If the thread can't be started the job is searched in the caller (blocking).
+ *
+ * Ponder: after a bot move the worker search the position after the expected reply, the search
+ * keep the level node budget but ignore the time (SearchInfo.ponder). When the turn is handed over
+ * a hit clear the ponder flag, the time counts from the ponder start so a long ponder give an instant
+ * move of the same budget, a miss cancel it.
+ * The ponder result is kept by the worker until the main thread claim it (bot move asked) or drop it.
+*/
+
+typedef struct s_bot_job {
+	ChessBoard	board;			/* Position snapshot, the list pointers are cleared */
+	BotLevel	level;			/* Bot level */
+	BotClock	clock;			/* Game clock of the bot side */
+	s8			has_clock;		/* FALSE for a game without clock */
+	u32			id;				/* Job id */
+} BotJob;
+
+typedef struct s_bot_worker {
+	pthread_t		thread;
+	pthread_mutex_t	lock;						/* Protect the queue, search and quit */
+	pthread_cond_t	cond;						/* Signal a new job or the quit */
+	BotJob			queue[BOT_JOB_QUEUE_SIZE];	/* Job ring */
+	u32				head;						/* Next job to search */
+	u32				count;						/* Number of queued jobs */
+	SearchInfo		*search;					/* Running search, NULL if none */
+	u32				search_id;					/* Job id of the running search */
+	u32				ponder_id;					/* Id of the ponder job, 0 for none */
+	u64				ponder_key;					/* Key of the pondered position */
+	s8				ponder_hit;					/* TRUE once the expected reply is played */
+	s8				quit;						/* TRUE to stop the worker */
+	s8				started;					/* TRUE if the thread is running */
+
+	/* Mailbox, written by the worker, read by the main thread, both under the lock */
+	BotResult		result;
+	s8				ready;						/* TRUE when result can be read, atomic */
+
+	/* Main thread only */
+	u32				last_id;					/* Id of the last job pushed */
+	u32				waiting_id;					/* Id of the job the main thread wait for, 0 for none */
+} BotWorker;
+
+static BotWorker worker = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* @brief Search a job and fill the result
+ * @param job		BotJob struct
+ * @param info		SearchInfo struct, zeroed
+ * @param result	BotResult struct, filled
+*/
+static void bot_job_search(BotJob *job, SearchInfo *info, BotResult *result) {
+	u64 start = search_time_ms();
+
+	ft_bzero(result, sizeof(BotResult));
+	result->id = job->id;
+	result->hash_key = job->board.hash_key;
+	result->move = bot_search_move(&job->board, job->level, job->has_clock ? &job->clock : NULL, info, &result->from_book);
+	result->score = info->score;
+	result->depth = info->depth;
+	result->nodes = info->nodes;
+	result->time_ms = search_time_ms() - start;
+}
+
+/* @brief Publish a result in the mailbox, overwrite the previous one if it is not read
+ * @param result	BotResult struct
+*/
+static void bot_mailbox_publish(BotResult *result) {
+	pthread_mutex_lock(&worker.lock);
+	worker.result = *result;
+	__atomic_store_n(&worker.ready, TRUE, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&worker.lock);
+}
+
+/* @brief Worker thread routine, search the jobs until quit */
+static void *bot_worker_routine(void *arg) {
+	BotJob		job;
+	SearchInfo	info;
+	BotResult	result;
+
+	(void)arg;
+	while (TRUE) {
+		pthread_mutex_lock(&worker.lock);
+		while (worker.count == 0 && !worker.quit) {
+			pthread_cond_wait(&worker.cond, &worker.lock);
+		}
+		if (worker.quit) {
+			pthread_mutex_unlock(&worker.lock);
+			break ;
+		}
+		job = worker.queue[worker.head];
+		worker.head = (worker.head + 1) % BOT_JOB_QUEUE_SIZE;
+		worker.count--;
+		/* The search is visible to the cancel before it start */
+		ft_bzero(&info, sizeof(SearchInfo));
+		info.ponder = job.id == worker.ponder_id && !worker.ponder_hit;
+		worker.search = &info;
+		worker.search_id = job.id;
+		pthread_mutex_unlock(&worker.lock);
+
+		bot_job_search(&job, &info, &result);
+
+		pthread_mutex_lock(&worker.lock);
+		worker.search = NULL;
+		/* A ponder result wait for the claim or the drop */
+		while (worker.ponder_id == job.id && !worker.quit) {
+			pthread_cond_wait(&worker.cond, &worker.lock);
+		}
+		pthread_mutex_unlock(&worker.lock);
+		bot_mailbox_publish(&result);
+	}
+	return (NULL);
+}
+
+/* @brief Start the worker thread, only the first call start it
+ * @return TRUE if the thread is running, FALSE otherwise
+*/
+static s8 bot_worker_start() {
+	if (worker.started) {
+		return (TRUE);
+	}
+	worker.quit = FALSE;
+	if (pthread_create(&worker.thread, NULL, bot_worker_routine, NULL) != 0) {
+		CHESS_LOG(LOG_ERROR, "Failed to start the bot worker thread, the bot search will block\n");
+		return (FALSE);
+	}
+	worker.started = TRUE;
+	return (TRUE);
+}
+
+/* @brief Fill the next job of the queue, the lock must be held
+ * @param b		ChessBoard struct, a snapshot is taken
+ * @param level	BotLevel enum
+ * @param clock	BotClock struct, copied, NULL for no clock
+ * @return The job, not counted in the queue yet, NULL if the queue is full
+*/
+static BotJob *bot_job_fill(ChessBoard *b, BotLevel level, const BotClock *clock) {
+	BotJob *job = NULL;
+
+	if (worker.count == BOT_JOB_QUEUE_SIZE) {
+		CHESS_LOG(LOG_ERROR, "Bot job queue full\n");
+		return (NULL);
+	}
+	job = &worker.queue[(worker.head + worker.count) % BOT_JOB_QUEUE_SIZE];
+	job->board = *b;
+	/* The lists belong to the game board, the search never read them */
+	job->board.lst = NULL;
+	job->board.white_kill_lst = NULL;
+	job->board.black_kill_lst = NULL;
+	job->board.fen = NULL;
+	job->level = level;
+	job->has_clock = clock != NULL;
+	if (clock) {
+		job->clock = *clock;
+	}
+	job->id = ++worker.last_id;
+	return (job);
+}
+
+/* @brief Ask a bot move for a position, the result is read with bot_worker_poll
+ * @param b		ChessBoard struct, a snapshot is taken
+ * @param level	BotLevel enum
+ * @param clock	BotClock struct, copied, NULL for no clock
+ * @return TRUE if the job is queued, FALSE otherwise (queue full)
+ * @note A new job replace the job the main thread wait for
+*/
+s8 bot_worker_submit(ChessBoard *b, BotLevel level, const BotClock *clock) {
+	BotJob		*job = NULL;
+	SearchInfo	info;
+	BotResult	result;
+
+	pthread_mutex_lock(&worker.lock);
+	if (!(job = bot_job_fill(b, level, clock))) {
+		pthread_mutex_unlock(&worker.lock);
+		return (FALSE);
+	}
+	worker.waiting_id = job->id;
+
+	if (!bot_worker_start()) {
+		/* No thread, search now and publish the result for the next poll, the main thread is the reader */
+		pthread_mutex_unlock(&worker.lock);
+		__atomic_store_n(&worker.ready, FALSE, __ATOMIC_RELEASE);
+		ft_bzero(&info, sizeof(SearchInfo));
+		bot_job_search(job, &info, &result);
+		bot_mailbox_publish(&result);
+		return (TRUE);
+	}
+	worker.count++;
+	pthread_cond_signal(&worker.cond);
+	pthread_mutex_unlock(&worker.lock);
+	return (TRUE);
+}
+
+/* @brief Ponder a position, the search run without time limit until the hit or the drop
+ * @param b		ChessBoard struct, position after the expected reply, a snapshot is taken
+ * @param level	BotLevel enum, its limits apply after the hit
+ * @param clock	BotClock struct, copied, NULL for no clock
+ * @return TRUE if the ponder job is queued, FALSE otherwise (no thread, queue full)
+*/
+s8 bot_worker_ponder(ChessBoard *b, BotLevel level, const BotClock *clock) {
+	BotJob *job = NULL;
+
+	pthread_mutex_lock(&worker.lock);
+	/* Never in the caller, it would block until the hit */
+	if (!bot_worker_start() || !(job = bot_job_fill(b, level, clock))) {
+		pthread_mutex_unlock(&worker.lock);
+		return (FALSE);
+	}
+	worker.ponder_id = job->id;
+	worker.ponder_key = b->hash_key;
+	worker.ponder_hit = FALSE;
+	worker.count++;
+	pthread_cond_signal(&worker.cond);
+	pthread_mutex_unlock(&worker.lock);
+	return (TRUE);
+}
+
+/* @brief The ponder search become the real search, the lock must be held */
+static void bot_ponder_promote() {
+	worker.ponder_hit = TRUE;
+	if (worker.search && worker.search_id == worker.ponder_id) {
+		__atomic_store_n(&worker.search->ponder, FALSE, __ATOMIC_RELAXED);
+	}
+}
+
+/* @brief Check the pondering when the turn is handed over
+ * @param hash_key	Key of the game position
+ * @return TRUE on a ponder hit, FALSE otherwise (no ponder or miss, a missed ponder is cancelled)
+ * @note On a hit the ponder search use its limits, counted from the ponder start
+*/
+s8 bot_worker_ponder_hit(u64 hash_key) {
+	s8 hit = FALSE;
+
+	pthread_mutex_lock(&worker.lock);
+	if (worker.ponder_id == 0 || worker.ponder_hit) {
+		pthread_mutex_unlock(&worker.lock);
+		return (FALSE);
+	}
+	hit = worker.ponder_key == hash_key;
+	if (hit) {
+		bot_ponder_promote();
+	}
+	pthread_mutex_unlock(&worker.lock);
+	if (!hit) {
+		CHESS_LOG(LOG_DEBUG, "Ponder miss\n");
+		bot_worker_cancel();
+	}
+	return (hit);
+}
+
+/* @brief Wait for the ponder result when a bot move is asked for the pondered position
+ * @param hash_key	Key of the game position
+ * @return TRUE if the ponder result is the awaited result (read with bot_worker_poll), FALSE otherwise
+ * @note A ponder of another position is cancelled
+*/
+s8 bot_worker_ponder_claim(u64 hash_key) {
+	s8 claim = FALSE;
+
+	pthread_mutex_lock(&worker.lock);
+	if (worker.ponder_id == 0) {
+		pthread_mutex_unlock(&worker.lock);
+		return (FALSE);
+	}
+	claim = worker.ponder_key == hash_key;
+	if (claim) {
+		bot_ponder_promote();
+		worker.waiting_id = worker.ponder_id;
+		worker.ponder_id = 0;
+		pthread_cond_signal(&worker.cond);
+	}
+	pthread_mutex_unlock(&worker.lock);
+	if (!claim) {
+		bot_worker_cancel();
+	}
+	return (claim);
+}
+
+/* @brief Get the result of the last job, never block
+ * @param out	BotResult struct, filled if a result is available
+ * @return TRUE if the result of the last job is available, FALSE otherwise
+ * @note The results of the old and cancelled jobs are dropped
+*/
+s8 bot_worker_poll(BotResult *out) {
+	if (!__atomic_load_n(&worker.ready, __ATOMIC_ACQUIRE)) {
+		return (FALSE);
+	}
+	/* The worker can publish a newer result at any time, the copy is done under the lock */
+	pthread_mutex_lock(&worker.lock);
+	*out = worker.result;
+	__atomic_store_n(&worker.ready, FALSE, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&worker.lock);
+	if (out->id != worker.waiting_id) {
+		CHESS_LOG(LOG_DEBUG, "Drop bot result of job %u\n", out->id);
+		return (FALSE);
+	}
+	worker.waiting_id = 0;
+	return (TRUE);
+}
+
+/* @brief Check if the main thread wait for a bot move */
+s8 bot_worker_busy() {
+	return (worker.waiting_id != 0);
+}
+
+/* @brief Cancel the queued jobs and the running search, their result will be dropped */
+void bot_worker_cancel() {
+	pthread_mutex_lock(&worker.lock);
+	worker.head = 0;
+	worker.count = 0;
+	if (worker.search) {
+		__atomic_store_n(&worker.search->stop, TRUE, __ATOMIC_RELAXED);
+	}
+	worker.waiting_id = 0;
+	/* A ponder result is dropped */
+	worker.ponder_id = 0;
+	worker.ponder_hit = FALSE;
+	pthread_cond_signal(&worker.cond);
+	pthread_mutex_unlock(&worker.lock);
+}
+
+/* @brief Cancel the jobs and stop the worker thread */
+void bot_worker_destroy() {
+	if (!worker.started) {
+		return ;
+	}
+	bot_worker_cancel();
+	pthread_mutex_lock(&worker.lock);
+	__atomic_store_n(&worker.quit, TRUE, __ATOMIC_RELAXED);
+	pthread_cond_signal(&worker.cond);
+	pthread_mutex_unlock(&worker.lock);
+	pthread_join(worker.thread, NULL);
+	worker.started = FALSE;
+	worker.ready = FALSE;
+}
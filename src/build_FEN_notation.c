@@ -1,7 +1,6 @@
 #include "../include/chess.h"
 #include "../include/chess_log.h"
 #include "../include/FEN_notation.h"
-#include "../include/handle_sdl.h"
 
 /**
  * @brief Check if the rook is alive on the given tile
@@ -148,7 +147,7 @@ static char *concat_FEN(FenFormat *fen) {
 
 	/* Concat the halfmove */
 	str_fen = ft_strjoin_free(str_fen, " ", 'f');
-	str_fen = ft_strjoin_free(str_fen, (char[2]){fen->halfmove, '\0'}, 'f');
+	str_fen = ft_strjoin_free(str_fen, ft_itoa(fen->halfmove), 'a');
 	str_fen = ft_strjoin_free(str_fen, " ", 'f');
 
 	/* Concat the fullmove */
@@ -170,7 +169,7 @@ static void display_FEN_notation(FenFormat *fen) {
 	printf (" %s", fen->color_turn);
 	printf (" %s", fen->castling);
 	printf (" %s", fen->en_passant);
-	printf (" %c %s", fen->halfmove, fen->fullmove);
+	printf (" %u %s", fen->halfmove, fen->fullmove);
 	printf("\n"RESET);
 
 }
@@ -200,9 +199,10 @@ ChessTile find_enable_tile(u64 value) {
 
 /**
  * @brief Build the FEN notation
- * @param h The SDLHandle pointer
+ * @param b The ChessBoard pointer
+ * @return The allocated FEN string
  */
-char *build_FEN_notation(SDLHandle *h) {
+char *build_FEN_notation(ChessBoard *b) {
 	ChessPiece	piece = EMPTY;
 	FenFormat	*fen = ft_calloc(1, sizeof(FenFormat));
 	char		fen_char = EMPTY_PIECE;
@@ -215,7 +215,7 @@ char *build_FEN_notation(SDLHandle *h) {
 		line_idx = 0;
 		empty_count = 0;
 		for (int i = 0; i < 8; i++) {
-			piece = get_piece_from_tile(h->board, (raw * 8) + i);
+			piece = get_piece_from_tile(b, (raw * 8) + i);
 			fen_char = chess_piece_to_fen(piece, &empty_count);
 			/* If not empty piece */
 			if (fen_char != EMPTY_PIECE) {
@@ -239,25 +239,25 @@ char *build_FEN_notation(SDLHandle *h) {
 	}
 
 	/* Set the color turn */
-	fen->color_turn[0] = h->player_info.piece_start == WHITE_PAWN ? 'w' : 'b';
+	fen->color_turn[0] = b->turn == IS_WHITE ? 'w' : 'b';
 
 	/* Set the castling permission */
-	compute_castling_perm(h->board, fen, h->board->info);
+	compute_castling_perm(b, fen, b->info);
 
 	/* Set the en passant value */
 	fen->en_passant[0] = '-';
 	fen->en_passant[1] = '\0';
-	ChessTile tile = find_enable_tile(h->board->en_passant);
+	ChessTile tile = find_enable_tile(b->en_passant);
 	if (tile != INVALID_TILE) {
 		fen->en_passant[0] = ChessTile_to_str(tile)[0] + 32; // Lowercase
 		fen->en_passant[1] = ChessTile_to_str(tile)[1];
 	}
 
 	/* Set the halfmove */
-	fen->halfmove = h->board->halfmove_count + '0';
+	fen->halfmove = b->halfmove_count;
 
 	/* Set the fullmove */
-	fen->fullmove = ft_itoa(h->board->fullmove_count);
+	fen->fullmove = ft_itoa(b->fullmove_count);
 
 	/* Print the FEN notation */
 	display_FEN_notation(fen);
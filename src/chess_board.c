@@ -1,24 +1,35 @@
 #include "../include/chess.h"
-#include "../include/handle_sdl.h"
 #include "../include/chess_log.h"
-#include "../include/network.h"
 
-/* Update control bitboard */
-void update_piece_control(ChessBoard *b) {
-	b->white_control = get_piece_color_control(b, IS_WHITE);
-	b->black_control = get_piece_color_control(b, IS_BLACK);
+/* @brief Update the check bits of the info byte with a direct attack query on both kings
+ * @param b		ChessBoard struct
+*/
+void update_check_flags(ChessBoard *b) {
+	ChessTile white_king = get_tile_from_mask(b->piece[WHITE_KING]);
+	ChessTile black_king = get_tile_from_mask(b->piece[BLACK_KING]);
 
-	/* Check for king in check */
-	b->info = u8ValueSet(b->info, WHITE_CHECK, (b->black_control & b->piece[WHITE_KING]) != 0);
-	b->info = u8ValueSet(b->info, BLACK_CHECK, (b->white_control & b->piece[BLACK_KING]) != 0);
+	b->info = u8ValueSet(b->info, WHITE_CHECK, white_king != INVALID_TILE && is_tile_attacked(b, white_king, IS_BLACK, b->occupied));
+	b->info = u8ValueSet(b->info, BLACK_CHECK, black_king != INVALID_TILE && is_tile_attacked(b, black_king, IS_WHITE, b->occupied));
 }
 
 /* Update occupied bitboard */
 void update_piece_state(ChessBoard *b) {
+	Bitboard pieces = 0;
+
 	b->occupied = 0;
 	b->white = 0;
 	b->black = 0;
+	for (ChessTile tile = A1; tile < TILE_MAX; tile++) {
+		b->mailbox[tile] = EMPTY;
+	}
 	for (s32 i = 0; i < PIECE_MAX; i++) {
+		/* Rebuild the mailbox */
+		pieces = b->piece[i];
+		while (pieces) {
+			b->mailbox[get_tile_from_mask(pieces)] = i;
+			pieces &= pieces - 1;
+		}
+
 		b->occupied |= b->piece[i];
 		if (i < BLACK_PAWN) {
 			b->white |= b->piece[i];
@@ -27,8 +38,16 @@ void update_piece_state(ChessBoard *b) {
 		}
 	}
 
-	/* Update control bitboard */
-	update_piece_control(b);
+	/* Incremental evaluation of the new position */
+	compute_board_eval(b);
+
+	/* Zobrist key of the new position, the history restart from it */
+	b->hash_key = compute_zobrist_key(b);
+	b->history_ply = 0;
+	b->hash_history[0] = b->hash_key;
+
+	/* Check for king in check */
+	update_check_flags(b);
 }
 
 void init_board(ChessBoard *b, u32 *app_flag) {
@@ -51,6 +70,12 @@ void init_board(ChessBoard *b, u32 *app_flag) {
 		unset_flag(app_flag, FLAG_FIRST_MOVE_PLAYED);
 	}
 
+	/* Build the attack, zobrist, evaluation and endgame tables (only done on the first call) */
+	init_attack_table();
+	init_zobrist_table();
+	init_eval_table();
+	init_endgame_table();
+
 	/* Set all pieces to 0 */
 	fast_bzero(b, sizeof(ChessBoard));
 	CHESS_LOG(LOG_INFO, ORANGE"sizeof(ChessBoard) = %lu\n"RESET, sizeof(ChessBoard));
@@ -79,7 +104,7 @@ void init_board(ChessBoard *b, u32 *app_flag) {
 	// b->half_turn_count = 0;
 	b->fullmove_count = 1;
 
-	/* Update occupied and control bitboard */
+	/* Update occupied bitboard */
 	update_piece_state(b);
 }
 
@@ -89,21 +114,10 @@ void init_board(ChessBoard *b, u32 *app_flag) {
  * @return ChessPiece enum
  */
 ChessPiece get_piece_from_tile(ChessBoard *b, ChessTile tile) {
-	Bitboard mask = 1ULL << tile;
-	ChessPiece piece = EMPTY;
-	
 	if (tile == INVALID_TILE) {
-		return (piece);
-	}
-	if (b->occupied & mask) {
-		for (s32 i = 0; i < PIECE_MAX; i++) {
-			if (b->piece[i] & mask) {
-				piece = i;
-				break;
-			}
-		}
+		return (EMPTY);
 	}
-	return (piece);
+	return (b->mailbox[tile]);
 }
 
 /* @brief Get piece from mask
@@ -112,151 +126,58 @@ ChessPiece get_piece_from_tile(ChessBoard *b, ChessTile tile) {
  * @return ChessPiece enum
  */
 ChessPiece get_piece_from_mask(ChessBoard *b, Bitboard mask) {
-	ChessPiece piece = EMPTY;
-	if (b->occupied & mask) {
-		for (s32 i = 0; i < PIECE_MAX; i++) {
-			if (b->piece[i] & mask) {
-				piece = i;
-				break;
-			}
-		}
-	}
-	return (piece);
+	return (get_piece_from_tile(b, get_tile_from_mask(mask)));
 }
 
-
-void exit_func(SDLHandle *h) {
-	CHESS_LOG(LOG_INFO, "exit_func\n");
-	chess_destroy(h);
-}
-
-void replay_func(SDLHandle *h) {
-	s8 network_flag = FALSE;
-
-	CHESS_LOG(LOG_INFO, "Replay game\n");
-	// init_board(h->board, &h->flag);
-	reset_board(h);
-
-
-	if (has_flag(h->flag, FLAG_NETWORK)) {
-		network_flag = TRUE;
-		send_game_end_to_server(h->player_info.nt_info->sockfd, h->player_info.nt_info->servaddr);
-		/* Disconect from the server */
-		unset_flag(&h->flag, FLAG_NETWORK);
-		destroy_network_info(h);
+/* @brief Verify the mailbox, color and occupied bitboards match the piece bitboards
+ * @param b		ChessBoard struct
+ * @return TRUE if the board is consistent, FALSE otherwise
+ */
+s8 board_check_consistency(ChessBoard *b) {
+	Bitboard	white = 0, black = 0, mask = 0;
+	ChessPiece	expected = EMPTY;
+	s8			ret = TRUE;
+
+	for (ChessTile tile = A1; tile < TILE_MAX; tile++) {
+		mask = 1ULL << tile;
+		expected = EMPTY;
+		for (ChessPiece type = WHITE_PAWN; type < PIECE_MAX; type++) {
+			if (!(b->piece[type] & mask)) {
+				continue ;
+			}
+			if (expected != EMPTY) {
+				CHESS_LOG(LOG_ERROR, "Tile %s hold two pieces %s and %s\n", ChessTile_to_str(tile), ChessPiece_to_str(expected), ChessPiece_to_str(type));
+				ret = FALSE;
+			}
+			expected = type;
+		}
+		if (b->mailbox[tile] != expected) {
+			CHESS_LOG(LOG_ERROR, "Mailbox tile %s hold %s instead of %s\n", ChessTile_to_str(tile), ChessPiece_to_str(b->mailbox[tile]), ChessPiece_to_str(expected));
+			ret = FALSE;
+		}
 	}
-	h->game_start = TRUE;
-	center_text_function_set(h, h->center_text, (BtnCenterText){"Cancel", cancel_search_func}, (BtnCenterText){NULL, NULL});
-	update_graphic_board(h);
-	if (network_flag) {
-		search_game(h);
-	} else {
-		/* Remove center text and his flag */
-		center_text_string_set(h, NULL, NULL);
-		unset_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
+	for (ChessPiece type = WHITE_PAWN; type < PIECE_MAX; type++) {
+		if (type < BLACK_PAWN) {
+			white |= b->piece[type];
+		} else {
+			black |= b->piece[type];
+		}
 	}
-}
-
-/* @brief Verify if the king is check and mat or PAT
- * @param b			ChessBoard struct
- * @param is_black	Flag to check if the piece is black
- * @return TRUE if the game is end, FALSE otherwise
-*/
-s8 verify_check_and_mat(ChessBoard *b, s8 is_black) {
-
-	Bitboard	enemy_pieces, piece, possible_moves;
-	ChessPiece	enemy_piece_start = is_black ? BLACK_PAWN : WHITE_PAWN;
-    ChessPiece	enemy_piece_end = is_black ? PIECE_MAX : BLACK_PAWN;
-	char		*color = is_black ? "Black" : "White";
-	s8 			check = FALSE, mat = TRUE;
-
-	/* Check if the king is in check */
-	if ((is_black && u8ValueGet(b->info, BLACK_CHECK)) || (!is_black && u8ValueGet(b->info, WHITE_CHECK))) {
-		check = TRUE;
+	if (white != b->white || black != b->black || (white | black) != b->occupied) {
+		CHESS_LOG(LOG_ERROR, "Color or occupied bitboard out of sync\n");
+		ret = FALSE;
 	}
-	
-	for (ChessPiece type = enemy_piece_start; type < enemy_piece_end; type++) {
-		enemy_pieces = b->piece[type];
-		while (enemy_pieces) {
-
-			/* Get the first bit set */
-			piece = enemy_pieces & -enemy_pieces;
-
-			/* Clear the first bit set */
-			enemy_pieces &= enemy_pieces - 1;
-
-			/* Get the possible moves */
-			possible_moves = get_piece_move(b, piece, type, TRUE);
-			if (possible_moves != 0) {
-				CHESS_LOG(LOG_DEBUG, "Piece %s on [%s] has possible moves\n", ChessPiece_to_str(type), ChessTile_to_str(piece));
-				mat = FALSE;
-				break ;
-			}
-		}
+	if (!board_check_eval(b)) {
+		CHESS_LOG(LOG_ERROR, "Incremental evaluation out of sync\n");
+		ret = FALSE;
 	}
-
-	SDLHandle *h = get_SDL_handle();
-
-	if (check && mat) {
-
-		char *checkmate_msg = ft_strjoin(color, " is checkmate");
-
-		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
-		
-		/* Set game_start bool to false */
-		h->game_start = FALSE;
-		center_text_string_set(h, checkmate_msg, "Do you want to replay ?");
-		free(checkmate_msg);
-		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
-		return (TRUE);
-	} else if (!check && mat) {
-		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
-		CHESS_LOG(LOG_ERROR, PURPLE"PAT detected Egality for %s\n"RESET, color);
-
-		/* Set game_start bool to false */
-		h->game_start = FALSE;
-		center_text_string_set(h, "Pat", "Game Over");
-		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
-		return (TRUE);	
+	if (b->hash_key != compute_zobrist_key(b)) {
+		CHESS_LOG(LOG_ERROR, "Zobrist key out of sync\n");
+		ret = FALSE;
 	}
-	return (FALSE);
-}
-
-
-/* @brief Get the piece color control
- * @param b			ChessBoard struct
- * @param is_black	Flag to check if the piece is black
- * @return Bitboard of the controled tiles
- */
-Bitboard get_piece_color_control(ChessBoard *b, s8 is_black) {
-	Bitboard control = 0, possible_moves = 0, enemy_pieces = 0, piece = 0;
-    ChessPiece enemy_piece_start = is_black ? BLACK_PAWN : WHITE_PAWN;
-    ChessPiece enemy_piece_end = is_black ? PIECE_MAX : BLACK_PAWN;
-
-    for (ChessPiece type = enemy_piece_start; type < enemy_piece_end; type++) {
-        enemy_pieces = b->piece[type];
-
-		/* For each enemy piece */
-        while (enemy_pieces) {
-			/* Get the first bit set */
-            piece = enemy_pieces & -enemy_pieces;
-            
-			/* Clear the first bit set */
-			enemy_pieces &= enemy_pieces - 1;
-
-			/* Get the possible moves */
-			possible_moves = get_piece_move(b, piece, type, FALSE);
-			
-			/* Add the possible moves to the control bitboard */
-			control |= possible_moves;
-        }
-    }
-	return (control);
+	return (ret);
 }
 
-
-
-
 /* Display bitboard for debug */
 void display_bitboard(Bitboard bitboard, const char *msg) {
 	printf("%s", msg);
@@ -0,0 +1,316 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/handle_sdl.h"
+#include "../include/chess_bot.h"
+#include "../include/FEN_notation.h"
+
+/* Transposition table of the local bot, kept between the moves */
+static TranspositionTable bot_tt;
+
+/* Opening book of the local bot, mapped on the first bot move */
+static OpeningBook bot_book;
+static s8 bot_book_loaded = FALSE;
+
+/* Syzygy tablebases of the local bot, registered on the first bot search if C_CHESS_SYZYGY is set */
+static s8 bot_syzygy_loaded = FALSE;
+
+/* UCI engine of the local bot, started on the first bot move if C_CHESS_ENGINE is set */
+static UciEngine bot_engine;
+static s8 bot_engine_loaded = FALSE;
+
+/* Remote engine request the main thread wait for, 0 for none */
+static u32 remote_id = 0;
+static u64 remote_key = 0;
+static BotLevel remote_level = BOT_DEFAULT_LEVEL;
+static BotClock remote_clock;
+static s8 remote_has_clock = FALSE;
+
+/* @brief Get the bot transposition table, allocated on the first call
+ * @return The table, NULL if the allocation failed
+*/
+static TranspositionTable *get_bot_tt() {
+	if (!bot_tt.bucket && !tt_init(&bot_tt, TT_DEFAULT_SIZE_MB)) {
+		return (NULL);
+	}
+	return (&bot_tt);
+}
+
+/* @brief Get the bot opening book, opened on the first call
+ * @return The book, an empty book (no move) if the file can't be opened
+*/
+static OpeningBook *get_bot_book() {
+	if (!bot_book_loaded) {
+		if (!book_open(&bot_book, BOOK_PATH)) {
+			CHESS_LOG(LOG_INFO, "No opening book found at %s\n", BOOK_PATH);
+		}
+		bot_book_loaded = TRUE;
+	}
+	return (&bot_book);
+}
+
+/* @brief Register the bot tablebases on the first call, the table files are mapped on their first probe */
+static void load_bot_syzygy() {
+	if (!bot_syzygy_loaded) {
+		bot_syzygy_loaded = TRUE;
+		syzygy_init(getenv(SYZYGY_PATH_ENV));
+	}
+}
+
+/* @brief Get the bot UCI engine, started on the first call
+ * @return The engine, NULL if no engine is configured or it can't be started
+*/
+static UciEngine *get_bot_engine() {
+	char *path = NULL;
+
+	if (!bot_engine_loaded) {
+		bot_engine_loaded = TRUE;
+		if ((path = getenv(UCI_ENGINE_ENV)) && path[0] && !uci_engine_start(&bot_engine, path)) {
+			CHESS_LOG(LOG_ERROR, "Can't start the UCI engine %s, the bot search is used\n", path);
+		}
+	}
+	return (bot_engine.path ? &bot_engine : NULL);
+}
+
+/* @brief Ask the move to the UCI engine
+ * @param engine	UciEngine struct
+ * @param b			ChessBoard struct
+ * @param info		SearchInfo struct, the soft deadline (the time limit without clock) is the engine move time,
+ *					stop cancel the engine search
+ * @return The engine move, MOVE_NONE on failure
+*/
+static Move bot_engine_move(UciEngine *engine, ChessBoard *b, SearchInfo *info) {
+	char	*fen = build_FEN_notation(b);
+	Move	move = MOVE_NONE;
+
+	if (!fen) {
+		return (MOVE_NONE);
+	}
+	info->start_ms = search_time_ms();
+	move = uci_engine_go(engine, b, fen, NULL, info->soft_limit_ms != 0 ? info->soft_limit_ms : info->time_limit_ms, &info->stop);
+	free(fen);
+	if (move != MOVE_NONE) {
+		CHESS_LOG(LOG_INFO, "Engine move: %s -> %s in %llu ms\n", ChessTile_to_str(move_from(move)), ChessTile_to_str(move_to(move))
+			, (unsigned long long)(search_time_ms() - info->start_ms));
+	}
+	return (move);
+}
+
+/* @brief Resize the bot transposition table
+ * @param size_mb	New size in MB
+ * @return TRUE on success, FALSE otherwise (the bot search without table)
+*/
+s8 bot_set_hash_size(u32 size_mb) {
+	return (tt_resize(&bot_tt, size_mb));
+}
+
+/* @brief Free the bot resources */
+void bot_destroy() {
+	/* The worker use the table, the book and the tablebases, stop it first */
+	bot_worker_destroy();
+	tt_free(&bot_tt);
+	book_close(&bot_book);
+	bot_book_loaded = FALSE;
+	syzygy_free();
+	bot_syzygy_loaded = FALSE;
+	uci_engine_stop(&bot_engine);
+	bot_engine_loaded = FALSE;
+	stockfish_client_destroy();
+	remote_id = 0;
+}
+
+/* @brief Get the bot move for the side to move, book move first then the UCI engine or the search
+ * @param b			ChessBoard struct, not modified
+ * @param level		BotLevel enum
+ * @param clock		BotClock struct of the side to move, NULL for no clock
+ * @param info		SearchInfo struct, stop must be FALSE, set it from another thread to cancel the search
+ * @param from_book	Set to TRUE if the move come from the opening book
+ * @return The move, MOVE_NONE if there is no legal move
+*/
+Move bot_search_move(ChessBoard *b, BotLevel level, const BotClock *clock, SearchInfo *info, s8 *from_book) {
+	Move move = MOVE_NONE;
+
+	/* The book is checked first, a book move don't start any search */
+	move = book_probe(get_bot_book(), b);
+	*from_book = move != MOVE_NONE;
+	if (*from_book) {
+		CHESS_LOG(LOG_INFO, "Bot book move: %s -> %s\n", ChessTile_to_str(move_from(move)), ChessTile_to_str(move_to(move)));
+		return (move);
+	}
+	set_bot_skill(info, level);
+	time_manager_init(info, clock, b->fullmove_count);
+	/* The bot search play if the engine fail */
+	if (get_bot_engine()) {
+		move = bot_engine_move(get_bot_engine(), b, info);
+		if (move != MOVE_NONE || __atomic_load_n(&info->stop, __ATOMIC_RELAXED)) {
+			return (move);
+		}
+	}
+	info->tt = get_bot_tt();
+	load_bot_syzygy();
+	move = search_best_move(b, info);
+	if (move != MOVE_NONE) {
+		CHESS_LOG(LOG_INFO, "Bot move: %s -> %s, depth %d, score %d, %llu nodes in %llu ms\n", ChessTile_to_str(move_from(move)), ChessTile_to_str(move_to(move))
+			, info->depth, info->score, (unsigned long long)info->nodes, (unsigned long long)(search_time_ms() - info->start_ms));
+	}
+	return (move);
+}
+
+/* @brief Play a bot move on the game board
+ * @param h		SDLHandle pointer
+ * @param move	Legal move of the board
+ * @return TRUE if the move is played, FALSE otherwise (no move)
+*/
+s8 bot_apply_move(SDLHandle *h, Move move) {
+	ChessBoard	*b = h->board;
+	ChessTile	from = INVALID_TILE, to = INVALID_TILE;
+	ChessPiece	type = EMPTY;
+
+	if (move == MOVE_NONE) {
+		return (FALSE);
+	}
+	from = move_from(move);
+	to = move_to(move);
+	type = get_piece_from_tile(b, from);
+
+	reset_selected_tile(h);
+	/* The promotion piece is chosen by the search, no selection menu */
+	if (move_is_promotion(move)) {
+		do_promotion_move(h, from, to, move_promotion_piece(move, type >= BLACK_PAWN), TRUE);
+		verify_check_and_mat(b, !(type >= BLACK_PAWN));
+		if (!has_flag(h->flag, FLAG_FIRST_MOVE_PLAYED)) {
+			set_flag(&h->flag, FLAG_FIRST_MOVE_PLAYED);
+		}
+	} else {
+		move_piece(h, from, to, type);
+	}
+	return (TRUE);
+}
+
+/* @brief Get the game clock of a side, my_remaining_time is the player color one
+ * (always white in local mode, the bottom timer), enemy_remaining_time the other color
+ * @param h		SDLHandle pointer
+ * @param color	IS_WHITE or IS_BLACK
+ * @param clock	BotClock struct, filled
+*/
+void bot_clock_from_handle(SDLHandle *h, s8 color, BotClock *clock) {
+	u32 sec = color == h->player_info.color ? h->my_remaining_time : h->enemy_remaining_time;
+
+	ft_bzero(clock, sizeof(BotClock));
+	/* The timer count whole seconds, the last one can be almost spent, no increment in the game */
+	clock->remaining_ms = sec > 0 ? (u64)(sec - 1) * 1000ULL : 0;
+}
+
+/* @brief Ask a bot move for the board, the remote engine if it's set, the bot worker otherwise
+ * @param b		ChessBoard struct
+ * @param level	BotLevel enum
+ * @param clock	BotClock struct of the side to move, copied, NULL for no clock
+ * @return TRUE if the request is sent, the move is read with bot_poll_move
+ * @note The remote engine is skipped when its timeout could spend too much of the clock
+*/
+s8 bot_request_move(ChessBoard *b, BotLevel level, const BotClock *clock) {
+	char	*fen = NULL;
+	s8		remote_time = !clock || clock->remaining_ms > (u64)STOCKFISH_TIMEOUT_MS * TM_HARD_MAX_DIV;
+
+	/* The pondered position, the ponder search give the move */
+	if (bot_worker_ponder_claim(b->hash_key)) {
+		CHESS_LOG(LOG_INFO, "Bot move from the ponder search\n");
+		return (TRUE);
+	}
+	if (remote_time && stockfish_enabled() && (fen = build_FEN_notation(b))) {
+		remote_id = send_stockfish_fen(fen, STOCKFISH_DEPTH);
+		remote_key = b->hash_key;
+		remote_level = level;
+		remote_has_clock = clock != NULL;
+		if (clock) {
+			remote_clock = *clock;
+		}
+		free(fen);
+		if (remote_id != 0) {
+			return (TRUE);
+		}
+	}
+	return (bot_worker_submit(b, level, clock));
+}
+
+/* @brief Get the requested bot move, never block
+ * @param b		ChessBoard struct, the move is dropped if the board changed since the request
+ * @param move	Legal move of the board, filled when TRUE is returned
+ * @return TRUE if the move is ready, FALSE otherwise
+*/
+s8 bot_poll_move(ChessBoard *b, Move *move) {
+	BotResult		result;
+	StockfishResult	remote;
+
+	if (bot_worker_poll(&result) && result.hash_key == b->hash_key) {
+		*move = result.move;
+		return (TRUE);
+	}
+	if (remote_id == 0 || !stockfish_poll(&remote) || remote.id != remote_id) {
+		return (FALSE);
+	}
+	remote_id = 0;
+	if (remote_key != b->hash_key) {
+		return (FALSE);
+	}
+	*move = uci_parse_move(b, remote.move);
+	/* Remote engine failure, the bot search play */
+	if (*move == MOVE_NONE) {
+		CHESS_LOG(LOG_ERROR, "No move from the remote engine, the bot search is used\n");
+		bot_worker_submit(b, remote_level, remote_has_clock ? &remote_clock : NULL);
+		return (FALSE);
+	}
+	return (TRUE);
+}
+
+/* @brief Ponder after a bot move, search the position after the expected reply on the opponent time
+ * @param h		SDLHandle pointer, the bot move is played
+ * @param level	BotLevel enum of the next bot move
+ * @return TRUE if the pondering started, FALSE otherwise (no expected reply, engine backend)
+ * @note The expected reply is the table move of the position, stored by the last bot search
+*/
+s8 bot_ponder(SDLHandle *h, BotLevel level) {
+	ChessBoard	ponder = *h->board;
+	Move		moves[MAX_MOVES];
+	BotClock	clock;
+	TTData		tt_data;
+	Undo		undo;
+	s32			count = 0;
+	char		*engine = getenv(UCI_ENGINE_ENV);
+
+	/* Only the local search can ponder */
+	if (stockfish_enabled() || (engine && engine[0]) || !tt_probe(&bot_tt, ponder.hash_key, 0, &tt_data)) {
+		return (FALSE);
+	}
+	count = generate_legal_moves(&ponder, moves);
+	for (s32 i = 0; i < count; i++) {
+		if (moves[i] == tt_data.move) {
+			make_move(&ponder, moves[i], &undo);
+			bot_clock_from_handle(h, ponder.turn, &clock);
+			CHESS_LOG(LOG_DEBUG, "Ponder on %s -> %s\n", ChessTile_to_str(move_from(moves[i])), ChessTile_to_str(move_to(moves[i])));
+			return (bot_worker_ponder(&ponder, level, &clock));
+		}
+	}
+	return (FALSE);
+}
+
+/* @brief Check the pondering when the turn is handed over, called after each move of the game
+ * @param b	ChessBoard struct, the move is played
+ * @note On a ponder hit the ponder search become the bot search of the position, on a miss it's cancelled
+*/
+void bot_turn_handover(ChessBoard *b) {
+	if (bot_worker_ponder_hit(b->hash_key)) {
+		CHESS_LOG(LOG_INFO, "Ponder hit\n");
+	}
+}
+
+/* @brief Check if the main thread wait for a bot move */
+s8 bot_busy() {
+	return (remote_id != 0 || bot_worker_busy());
+}
+
+/* @brief Cancel the requested bot move */
+void bot_cancel() {
+	stockfish_cancel();
+	remote_id = 0;
+	bot_worker_cancel();
+}
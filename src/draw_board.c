@@ -171,8 +171,6 @@ void draw_board(SDLHandle *handle, s8 player_color) {
 		center_text_draw(handle, handle->center_text);
 	}
 
-	compute_piece_value(handle->board);
-
 	DRAW_PIECE_KILL(handle, TRUE, !handle->player_info.color);
 	DRAW_PIECE_KILL(handle, FALSE, handle->player_info.color);
 }
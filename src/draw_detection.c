@@ -0,0 +1,68 @@
+#include "../include/chess.h"
+
+/*
+ * Draw rules that don't depend on the legal moves (pat is handled with the mat).
+ * The repetition only look at the positions played since the last irreversible move
+ * (capture or pawn move, halfmove_count is reset), a position can't repeat across it.
+*/
+
+/* @brief Count how many time the current position was reached
+ * @param b		ChessBoard struct
+ * @return Number of occurrences of the current position, the current one included
+*/
+s32 repetition_count(ChessBoard *b) {
+	s32 window = b->halfmove_count;
+	s32 count = 1;
+
+	/* The ring only hold the positions played on this board */
+	if (window > b->history_ply) {
+		window = b->history_ply;
+	}
+	if (window > HASH_HISTORY_SIZE - 1) {
+		window = HASH_HISTORY_SIZE - 1;
+	}
+	/* Same side to move only, one position every two plies */
+	for (s32 ply = 4; ply <= window; ply += 2) {
+		if (b->hash_history[(b->history_ply - ply) & (HASH_HISTORY_SIZE - 1)] == b->hash_key) {
+			count++;
+		}
+	}
+	return (count);
+}
+
+/* @brief Check if no sequence of legal moves can lead to a mat
+ * @param b		ChessBoard struct
+ * @return TRUE if the material left can't mat, FALSE otherwise
+ * @note King against king, king and minor piece against king, and kings with bishops all on same color tiles
+*/
+s8 is_insufficient_material(ChessBoard *b) {
+	Bitboard	bishops = b->piece[WHITE_BISHOP] | b->piece[BLACK_BISHOP];
+	Bitboard	knights = b->piece[WHITE_KNIGHT] | b->piece[BLACK_KNIGHT];
+	Bitboard	majors = b->piece[WHITE_PAWN] | b->piece[BLACK_PAWN] | b->piece[WHITE_ROOK]
+						| b->piece[BLACK_ROOK] | b->piece[WHITE_QUEEN] | b->piece[BLACK_QUEEN];
+
+	if (majors) {
+		return (FALSE);
+	}
+	if (bitboard_count(bishops | knights) <= 1) {
+		return (TRUE);
+	}
+	return (knights == 0 && ((bishops & LIGHT_TILES) == 0 || (bishops & ~LIGHT_TILES) == 0));
+}
+
+/* @brief Get the draw rule reached by the current position
+ * @param b		ChessBoard struct
+ * @return DrawReason enum, DRAW_NONE if the game can continue
+*/
+DrawReason get_draw_reason(ChessBoard *b) {
+	if (is_insufficient_material(b)) {
+		return (DRAW_INSUFFICIENT_MATERIAL);
+	} else if (b->halfmove_count >= 100) {
+		return (DRAW_FIFTY_MOVE);
+	} else if (repetition_count(b) >= 3) {
+		return (DRAW_REPETITION);
+	} else if (endgame_probe_known(b) == WDL_DRAW) {
+		return (DRAW_KNOWN_ENDGAME);
+	}
+	return (DRAW_NONE);
+}
@@ -0,0 +1,266 @@
+#include "../include/chess.h"
+
+/*
+ * Known endgames, solved without search.
+ * - King and pawn against king: a bitbase (one bit by position, win or draw) built at init
+ *   with a retrograde analysis, pawn on the A-D files only, the other files are mirrored.
+ * - Bare king against a mating material (queen, rook, bishop pair, bishop and knight): win.
+ * - Insufficient material: draw.
+ * The known endgames only look at positions with at most ENDGAME_MAX_PIECES pieces.
+ * With Syzygy tablebases (src/syzygy.c) registered, endgame_probe ask the tables first and fall back
+ * to the known endgames when no table give a certain result. The draw rules and the game
+ * adjudication only use the known endgames, a game result never depend on the local tables.
+*/
+
+/* KPK positions: side to move (2) * white king (64) * black king (64) * pawn (24 tiles, A2-D7) */
+#define KPK_SIZE (2 * TILE_MAX * TILE_MAX * 24)
+
+/* Result of a KPK position during the generation, bit flags so the successors can be or'ed */
+#define KPK_INVALID	0
+#define KPK_UNKNOWN	1
+#define KPK_DRAW	2
+#define KPK_WIN		4
+
+/* One bit by position, set if white win */
+static u64 kpk_bitbase[KPK_SIZE / 64];
+
+/* @brief Get the KPK index, white has the pawn
+ * @param turn	Side to move, IS_WHITE or IS_BLACK
+ * @param wk	White king tile
+ * @param bk	Black king tile
+ * @param pawn	White pawn tile, on the A-D files and ranks 2-7
+*/
+FT_INLINE u32 kpk_index(s8 turn, ChessTile wk, ChessTile bk, ChessTile pawn) {
+	u32 pawn_idx = (pawn / 8 - 1) * 4 + (pawn & 7);
+
+	return (((pawn_idx * TILE_MAX + wk) * TILE_MAX + bk) * 2 + turn);
+}
+
+/* @brief Classify a KPK position without looking at the successors
+ * @return KPK_INVALID, KPK_WIN, KPK_DRAW or KPK_UNKNOWN
+*/
+static u8 kpk_initial_result(s8 turn, ChessTile wk, ChessTile bk, ChessTile pawn) {
+	Bitboard white_control = g_king_attack[wk] | g_pawn_attack[IS_WHITE][pawn];
+
+	/* Kings next to each other, piece on the same tile or black in check with white to move */
+	if (tile_distance(wk, bk) <= 1 || wk == pawn || bk == pawn
+		|| (turn == IS_WHITE && (g_pawn_attack[IS_WHITE][pawn] & (1ULL << bk)))) {
+		return (KPK_INVALID);
+	}
+	/* The pawn promote and the queen can't be taken */
+	if (turn == IS_WHITE && pawn / 8 == 6 && wk != pawn + 8
+		&& (tile_distance(bk, pawn + 8) > 1 || tile_distance(wk, pawn + 8) == 1)) {
+		return (KPK_WIN);
+	}
+	/* Black has no move (pat) or take the pawn */
+	if (turn == IS_BLACK && ((g_king_attack[bk] & ~white_control) == 0
+		|| (g_king_attack[bk] & (1ULL << pawn) & ~g_king_attack[wk]))) {
+		return (KPK_DRAW);
+	}
+	return (KPK_UNKNOWN);
+}
+
+/* @brief Classify a KPK position from its successors
+ * @param db	Generation results
+ * @return The result, KPK_UNKNOWN if a successor is still unknown
+*/
+static u8 kpk_classify(u8 *db, s8 turn, ChessTile wk, ChessTile bk, ChessTile pawn) {
+	/* White want a winning successor, black a drawing one */
+	u8			good = turn == IS_WHITE ? KPK_WIN : KPK_DRAW;
+	u8			bad = turn == IS_WHITE ? KPK_DRAW : KPK_WIN;
+	u8			result = KPK_INVALID;
+	Bitboard	king_moves = g_king_attack[turn == IS_WHITE ? wk : bk];
+	ChessTile	to = INVALID_TILE;
+
+	while (king_moves) {
+		to = get_tile_from_mask(king_moves);
+		result |= turn == IS_WHITE ? db[kpk_index(IS_BLACK, to, bk, pawn)] : db[kpk_index(IS_WHITE, wk, to, pawn)];
+		king_moves &= king_moves - 1;
+	}
+	/* Pawn push, the promotion is handled by the initial result */
+	if (turn == IS_WHITE && pawn / 8 < 6) {
+		result |= db[kpk_index(IS_BLACK, wk, bk, pawn + 8)];
+		if (pawn / 8 == 1 && pawn + 8 != wk && pawn + 8 != bk) {
+			result |= db[kpk_index(IS_BLACK, wk, bk, pawn + 16)];
+		}
+	}
+	if (result & good) {
+		return (good);
+	}
+	return ((result & KPK_UNKNOWN) ? KPK_UNKNOWN : bad);
+}
+
+/* @brief Build the KPK bitbase, only the first call build it */
+void init_endgame_table() {
+	static s8	initialised = FALSE;
+	u8			*db = NULL;
+	s8			changed = TRUE;
+	ChessTile	pawn = INVALID_TILE;
+	u32			idx = 0;
+
+	if (initialised) {
+		return ;
+	}
+	init_attack_table();
+	if (!(db = ft_calloc(KPK_SIZE, sizeof(u8)))) {
+		return ;
+	}
+	for (s32 pawn_idx = 0; pawn_idx < 24; pawn_idx++) {
+		pawn = (pawn_idx / 4 + 1) * 8 + (pawn_idx & 3);
+		for (ChessTile wk = 0; wk < TILE_MAX; wk++) {
+			for (ChessTile bk = 0; bk < TILE_MAX; bk++) {
+				db[kpk_index(IS_WHITE, wk, bk, pawn)] = kpk_initial_result(IS_WHITE, wk, bk, pawn);
+				db[kpk_index(IS_BLACK, wk, bk, pawn)] = kpk_initial_result(IS_BLACK, wk, bk, pawn);
+			}
+		}
+	}
+	/* Iterate until no unknown position can be classified */
+	while (changed) {
+		changed = FALSE;
+		for (s32 pawn_idx = 0; pawn_idx < 24; pawn_idx++) {
+			pawn = (pawn_idx / 4 + 1) * 8 + (pawn_idx & 3);
+			for (ChessTile wk = 0; wk < TILE_MAX; wk++) {
+				for (ChessTile bk = 0; bk < TILE_MAX; bk++) {
+					for (s8 turn = IS_WHITE; turn <= IS_BLACK; turn++) {
+						idx = kpk_index(turn, wk, bk, pawn);
+						if (db[idx] == KPK_UNKNOWN && (db[idx] = kpk_classify(db, turn, wk, bk, pawn)) != KPK_UNKNOWN) {
+							changed = TRUE;
+						}
+					}
+				}
+			}
+		}
+	}
+	/* The positions still unknown can't be won */
+	for (idx = 0; idx < KPK_SIZE; idx++) {
+		if (db[idx] == KPK_WIN) {
+			kpk_bitbase[idx / 64] |= 1ULL << (idx & 63);
+		}
+	}
+	free(db);
+	initialised = TRUE;
+}
+
+/* @brief Probe the KPK bitbase
+ * @param b		ChessBoard struct, one pawn and the two kings only
+ * @return WDL_WIN or WDL_DRAW for the pawn side, side to move point of view
+*/
+static EndgameWDL kpk_probe(ChessBoard *b) {
+	s8			strong = b->piece[WHITE_PAWN] ? IS_WHITE : IS_BLACK;
+	ChessTile	wk = get_tile_from_mask(b->piece[strong == IS_WHITE ? WHITE_KING : BLACK_KING]);
+	ChessTile	bk = get_tile_from_mask(b->piece[strong == IS_WHITE ? BLACK_KING : WHITE_KING]);
+	ChessTile	pawn = get_tile_from_mask(b->piece[strong == IS_WHITE ? WHITE_PAWN : BLACK_PAWN]);
+	s8			turn = b->turn == strong ? IS_WHITE : IS_BLACK;
+	u32			idx = 0;
+
+	/* The pawn side play white, mirror the board vertically for black */
+	if (strong == IS_BLACK) {
+		wk ^= 56;
+		bk ^= 56;
+		pawn ^= 56;
+	}
+	/* Pawn on the A-D files, mirror the board horizontally */
+	if ((pawn & 7) > 3) {
+		wk ^= 7;
+		bk ^= 7;
+		pawn ^= 7;
+	}
+	idx = kpk_index(turn, wk, bk, pawn);
+	if (!(kpk_bitbase[idx / 64] & (1ULL << (idx & 63)))) {
+		return (WDL_DRAW);
+	}
+	return (turn == IS_WHITE ? WDL_WIN : WDL_LOSS);
+}
+
+/* @brief Check if a side has the material to force the mat against a bare king
+ * @param b			ChessBoard struct
+ * @param is_black	Side to check
+*/
+static s8 has_mating_material(ChessBoard *b, s8 is_black) {
+	ChessPiece	base = is_black ? BLACK_PAWN : WHITE_PAWN;
+	Bitboard	bishops = b->piece[base + 2];
+
+	if (b->piece[base + 4] || b->piece[base + 3]) {
+		return (TRUE);
+	}
+	/* Bishop pair on both tile colors, or bishop and knight */
+	if ((bishops & LIGHT_TILES) && (bishops & ~LIGHT_TILES)) {
+		return (TRUE);
+	}
+	return (bishops && b->piece[base + 1]);
+}
+
+/* @brief Probe a bare king against a mating material
+ * @param b			ChessBoard struct
+ * @param strong	Side with the material
+ * @return WDL_WIN or WDL_LOSS, side to move point of view, WDL_UNKNOWN if the bare king can take a piece or is pat
+*/
+static EndgameWDL kxk_probe(ChessBoard *b, s8 strong) {
+	Bitboard	strong_pieces = strong == IS_WHITE ? b->white : b->black;
+	ChessTile	weak_king = get_tile_from_mask(b->piece[strong == IS_WHITE ? BLACK_KING : WHITE_KING]);
+
+	if (b->turn == strong) {
+		return (WDL_WIN);
+	}
+	/* A piece next to the bare king can be taken, let the search see it */
+	if ((g_king_attack[weak_king] & strong_pieces) || !has_legal_move(b, b->turn == IS_BLACK)) {
+		return (WDL_UNKNOWN);
+	}
+	return (WDL_LOSS);
+}
+
+/* @brief Get the result of a known endgame, without tablebase
+ * @param b		ChessBoard struct
+ * @return WDL result, side to move point of view, WDL_UNKNOWN if the endgame isn't known
+*/
+EndgameWDL endgame_probe_known(ChessBoard *b) {
+	s32 count = bitboard_count(b->occupied);
+
+	if (count > ENDGAME_MAX_PIECES) {
+		return (WDL_UNKNOWN);
+	}
+	if (is_insufficient_material(b)) {
+		return (WDL_DRAW);
+	}
+	if (count == 3 && (b->piece[WHITE_PAWN] | b->piece[BLACK_PAWN])) {
+		init_endgame_table();
+		return (kpk_probe(b));
+	}
+	/* Bare king, the other side must have the mating material */
+	if (b->black == b->piece[BLACK_KING] && has_mating_material(b, IS_WHITE)) {
+		return (kxk_probe(b, IS_WHITE));
+	}
+	if (b->white == b->piece[WHITE_KING] && has_mating_material(b, IS_BLACK)) {
+		return (kxk_probe(b, IS_BLACK));
+	}
+	return (WDL_UNKNOWN);
+}
+
+/* @brief Get the result of an endgame, the Syzygy tables first then the known endgames
+ * @param b		ChessBoard struct, the tables probe play and unplay the captures
+ * @return WDL result, side to move point of view, WDL_UNKNOWN if the endgame isn't known
+*/
+EndgameWDL endgame_probe(ChessBoard *b) {
+	EndgameWDL wdl = WDL_UNKNOWN;
+
+	if (bitboard_count(b->occupied) <= syzygy_max_pieces()) {
+		wdl = syzygy_probe_wdl(b);
+	}
+	return (wdl != WDL_UNKNOWN ? wdl : endgame_probe_known(b));
+}
+
+/* @brief Get the winner of a known won endgame, the game can be adjudicated
+ * @param b			ChessBoard struct
+ * @param winner	Filled with the winning side, IS_WHITE or IS_BLACK
+ * @return TRUE if a side win the endgame, FALSE otherwise
+*/
+s8 endgame_adjudicate(ChessBoard *b, s8 *winner) {
+	EndgameWDL wdl = endgame_probe_known(b);
+
+	if (wdl != WDL_WIN && wdl != WDL_LOSS) {
+		return (FALSE);
+	}
+	/* The probe result is for the side to move */
+	*winner = wdl == WDL_WIN ? b->turn : !b->turn;
+	return (TRUE);
+}
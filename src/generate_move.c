@@ -0,0 +1,137 @@
+#include "../include/chess.h"
+
+/*
+ * Array based legal move generation for the side to move (b->turn).
+ * The out array must hold at least MAX_MOVES moves, the number of moves is returned.
+ * Captures are captures of an enemy piece, 'en passant' and promotion captures,
+ * quiet moves are all the other legal moves (castle and quiet promotion included).
+*/
+
+/* @brief Add the moves of a piece to the array
+ * @param b		ChessBoard struct
+ * @param out	Move array
+ * @param count	Number of moves in the array
+ * @param type	ChessPiece enum
+ * @param from	ChessTile of the piece
+ * @param moves	Bitboard of the destination tiles
+ * @return The new number of moves in the array
+*/
+static s32 add_piece_moves(ChessBoard *b, Move *out, s32 count, ChessPiece type, ChessTile from, Bitboard moves) {
+	Bitboard	enemy = b->turn == IS_BLACK ? b->white : b->black;
+	s8			is_pawn = (type == WHITE_PAWN || type == BLACK_PAWN);
+	s8			is_king = (type == WHITE_KING || type == BLACK_KING);
+	ChessTile	to = INVALID_TILE;
+	u16			flag = MOVE_QUIET;
+
+	while (moves) {
+		to = get_tile_from_mask(moves);
+		flag = (enemy & (1ULL << to)) ? MOVE_CAPTURE : MOVE_QUIET;
+		if (is_pawn) {
+			if ((1ULL << to) & (RANK_1 | RANK_8)) {
+				/* Knight, bishop, rook then queen promotion */
+				flag = flag == MOVE_CAPTURE ? MOVE_PROMOTION_CAPTURE : MOVE_PROMOTION;
+				for (u16 piece = 0; piece < 4; piece++) {
+					out[count++] = move_new(from, to, flag | piece);
+				}
+				moves &= moves - 1;
+				continue ;
+			} else if ((1ULL << to) == b->en_passant) {
+				flag = MOVE_EN_PASSANT;
+			} else if (INT_ABS_DIFF(from, to) == 16) {
+				flag = MOVE_DOUBLE_PAWN;
+			}
+		} else if (is_king && INT_ABS_DIFF(from, to) == 2) {
+			flag = to > from ? MOVE_KING_CASTLE : MOVE_QUEEN_CASTLE;
+		}
+		out[count++] = move_new(from, to, flag);
+		moves &= moves - 1;
+	}
+	return (count);
+}
+
+/* @brief Generate the legal moves of the side to move
+ * @param b			ChessBoard struct
+ * @param out		Move array, at least MAX_MOVES size
+ * @param target	Bitboard of the allowed destination tiles
+ * @param ep		TRUE to keep the 'en passant' capture
+ * @return The number of moves
+*/
+static s32 generate_moves(ChessBoard *b, Move *out, Bitboard target, s8 ep) {
+	ChessPiece	piece_start = b->turn == IS_BLACK ? BLACK_PAWN : WHITE_PAWN;
+	ChessPiece	piece_end = b->turn == IS_BLACK ? PIECE_MAX : BLACK_PAWN;
+	Bitboard	pieces = 0, moves = 0, pawn_target = 0;
+	ChessTile	from = INVALID_TILE;
+	s32			count = 0;
+	CheckInfo	ci;
+
+	compute_check_info(b, b->turn, &ci);
+	/* The 'en passant' destination tile is empty, it's not in the enemy tiles */
+	pawn_target = ep ? (target | b->en_passant) : (target & ~b->en_passant);
+	for (ChessPiece type = piece_start; type < piece_end; type++) {
+		pieces = b->piece[type];
+		while (pieces) {
+			from = get_tile_from_mask(pieces);
+			moves = get_legal_piece_move(b, 1ULL << from, type, &ci);
+			moves &= (type == piece_start) ? pawn_target : target;
+			count = add_piece_moves(b, out, count, type, from, moves);
+			pieces &= pieces - 1;
+		}
+	}
+	return (count);
+}
+
+/* @brief Generate all the legal moves of the side to move
+ * @param b		ChessBoard struct
+ * @param out	Move array, at least MAX_MOVES size
+ * @return The number of moves
+*/
+s32 generate_legal_moves(ChessBoard *b, Move *out) {
+	return (generate_moves(b, out, ~0ULL, TRUE));
+}
+
+/* @brief Generate the legal captures of the side to move, 'en passant' and promotion capture included
+ * @param b		ChessBoard struct
+ * @param out	Move array, at least MAX_MOVES size
+ * @return The number of moves
+*/
+s32 generate_capture_moves(ChessBoard *b, Move *out) {
+	return (generate_moves(b, out, b->turn == IS_BLACK ? b->white : b->black, TRUE));
+}
+
+/* @brief Generate the legal non capture moves of the side to move, castle and quiet promotion included
+ * @param b		ChessBoard struct
+ * @param out	Move array, at least MAX_MOVES size
+ * @return The number of moves
+*/
+s32 generate_quiet_moves(ChessBoard *b, Move *out) {
+	return (generate_moves(b, out, ~b->occupied, FALSE));
+}
+
+/* @brief Check if a move is legal for the side to move, used to validate a move from another position
+ * @param b		ChessBoard struct
+ * @param move	Move to check, the flag must match the move in this position
+ * @return TRUE if the move is legal, FALSE otherwise
+*/
+s8 is_legal_move(ChessBoard *b, Move move) {
+	ChessTile	from = move_from(move), to = move_to(move);
+	ChessPiece	type = b->mailbox[from];
+	Move		moves[4];
+	s32			count = 0;
+	CheckInfo	ci;
+
+	if (move == MOVE_NONE || type == EMPTY || (type >= BLACK_PAWN) != b->turn) {
+		return (FALSE);
+	}
+	compute_check_info(b, b->turn, &ci);
+	if (!(get_legal_piece_move(b, 1ULL << from, type, &ci) & (1ULL << to))) {
+		return (FALSE);
+	}
+	/* Build the move(s) of this position to compare the flag */
+	count = add_piece_moves(b, moves, 0, type, from, 1ULL << to);
+	for (s32 i = 0; i < count; i++) {
+		if (moves[i] == move) {
+			return (TRUE);
+		}
+	}
+	return (FALSE);
+}
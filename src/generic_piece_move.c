@@ -1,178 +1,120 @@
 #include "../include/chess.h"
 #include "../include/handle_sdl.h"
 #include "../include/chess_log.h"
+#include "../include/network.h"
 
-/* @brief Update special info byte for the king and rook
- * @param b		ChessBoard struct
- * @param type	ChessPiece enum
- * @param tile_from	ChessTile enum
-*/
-void board_special_info_handler(ChessBoard *b, ChessPiece type, ChessTile tile_from) {
-	
-	static const SpecialInfo special_info[SPECIAL_INFO_SIZE] = {
-		{WHITE_KING, WHITE_KING_MOVED, WHITE_KING_START_POS},
-		{WHITE_ROOK, WHITE_KING_ROOK_MOVED, WHITE_KING_ROOK_START_POS},
-		{WHITE_ROOK, WHITE_QUEEN_ROOK_MOVED, WHITE_QUEEN_ROOK_START_POS},
-		{BLACK_KING, BLACK_KING_MOVED, BLACK_KING_START_POS},
-		{BLACK_ROOK, BLACK_KING_ROOK_MOVED, BLACK_KING_ROOK_START_POS},
-		{BLACK_ROOK, BLACK_QUEEN_ROOK_MOVED, BLACK_QUEEN_ROOK_START_POS},
-	};
-	s32 idx = -1;
-
-	for (s32 i = 0; i < SPECIAL_INFO_SIZE; i++) {
-		idx = special_info[i].info_idx;
-		/* Check if the piece is the king or rook and if the piece is at the start position */
-		if (special_info[i].type == type && special_info[i].tile_from == tile_from && u8ValueGet(b->info, idx) == FALSE) {
-			b->info = u8ValueSet(b->info, idx, TRUE);
-		}
-	}
+void exit_func(SDLHandle *h) {
+	CHESS_LOG(LOG_INFO, "exit_func\n");
+	chess_destroy(h);
 }
 
-/* @brief Handle castle move (move rook if needed)
- * @param b		ChessBoard struct
- * @param type	ChessPiece enum
- * @param tile_from	ChessTile enum
- * @param tile_to	ChessTile enum
-*/
-void handle_castle_move(SDLHandle *handle, ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
-	ChessTile rook_from = 0, rook_to = 0;
-	ChessPiece rook_type = EMPTY;
-	if (type == BLACK_KING || type == WHITE_KING) {
-		/* Check if the king is moving 2 tiles (Castle move) */
-		if (INT_ABS_DIFF(tile_from, tile_to) == 2) {
-			/* Check if the king is moving to the right or left */
-			if (tile_to == tile_from + 2) {
-				rook_from = tile_from + 3;
-				rook_to = tile_from + 1;
-			} else if (tile_to == tile_from - 2) {
-				rook_from = tile_from - 4;
-				rook_to = tile_from - 1;
-			}
-			rook_type = (type == BLACK_KING) ? BLACK_ROOK : WHITE_ROOK;
-			move_piece(handle, rook_from, rook_to, rook_type);
-		}
-	}
-}
+void replay_func(SDLHandle *h) {
+	s8 network_flag = FALSE;
 
-/* @brief Verify if the move is a double step move for a pawn
- * @param type		ChessPiece enum
- * @param tile_from	ChessTile enum
- * @param tile_to	ChessTile enum
- * @return TRUE if the move is a double step move, FALSE otherwise
-*/
-static s8 is_pawn_double_step_move(ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
-	return ((type == WHITE_PAWN || type == BLACK_PAWN) && INT_ABS_DIFF(tile_from, tile_to) == 16);
-}
+	CHESS_LOG(LOG_INFO, "Replay game\n");
+	// init_board(h->board, &h->flag);
+	reset_board(h);
 
-/* @brief Update 'en passant' Bitboard if needed
- * @param b			ChessBoard struct
- * @param type		ChessPiece enum
- * @param tile_from	ChessTile enum
- * @param tile_to	ChessTile enum
-*/
-static void update_en_passant_bitboard(ChessBoard *b, ChessPiece type, ChessTile tile_from, ChessTile tile_to) {
-	b->en_passant = 0;
-	b->en_passant_tile = INVALID_TILE;
-	if (is_pawn_double_step_move(type, tile_from, tile_to)) {
-		b->en_passant = (1ULL << (tile_from + tile_to) / 2);
-		b->en_passant_tile = tile_to;
-	}
-}
 
-ChessTile get_tile_from_mask(Bitboard mask) {
-	for (s32 i = 0; i < 64; i++) {
-		if (mask & (1ULL << i)) {
-			return ((ChessTile)i);
-		}
+	if (has_flag(h->flag, FLAG_NETWORK)) {
+		network_flag = TRUE;
+		send_game_end_to_server(h->player_info.nt_info->sockfd, h->player_info.nt_info->servaddr);
+		/* Disconect from the server */
+		unset_flag(&h->flag, FLAG_NETWORK);
+		destroy_network_info(h);
+	}
+	h->game_start = TRUE;
+	center_text_function_set(h, h->center_text, (BtnCenterText){"Cancel", cancel_search_func}, (BtnCenterText){NULL, NULL});
+	update_graphic_board(h);
+	if (network_flag) {
+		search_game(h);
+	} else {
+		/* Remove center text and his flag */
+		center_text_string_set(h, NULL, NULL);
+		unset_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
 	}
-	return (INVALID_TILE);
 }
 
-/* @brief Handle enemy piece kill
+/* @brief Verify if the king is check and mat, PAT or if a draw rule is reached
  * @param b			ChessBoard struct
- * @param type		ChessPiece enum
- * @param tile_to	ChessTile enum
- * @param mask_to	Bitboard of the destination tile
+ * @param is_black	Flag to check if the piece is black
+ * @return TRUE if the game is end, FALSE otherwise
 */
-s8 handle_enemy_piece_kill(ChessBoard *b, ChessPiece type, Bitboard mask_to) {
-	ChessPiece	enemy_piece = get_piece_from_mask(b, mask_to);
-	
-	if (enemy_piece != EMPTY) {
-		add_kill_lst(b, enemy_piece);
-		b->piece[enemy_piece] &= ~mask_to;
-		return (TRUE);
-	} else if ((type == WHITE_PAWN || type == BLACK_PAWN) && mask_to == b->en_passant) {
-		mask_to = (1ULL << b->en_passant_tile);
-		enemy_piece = (type == WHITE_PAWN) ? BLACK_PAWN : WHITE_PAWN;
-		CHESS_LOG(LOG_DEBUG, "En passant kill\n");
-		add_kill_lst(b, enemy_piece);
-		b->piece[enemy_piece] &= ~mask_to;
-		return (TRUE);
+s8 verify_check_and_mat(ChessBoard *b, s8 is_black) {
+	static const char	*draw_msg[] = {
+		[DRAW_INSUFFICIENT_MATERIAL] = "Insufficient material",
+		[DRAW_FIFTY_MOVE] = "Fifty moves rule",
+		[DRAW_REPETITION] = "Threefold repetition",
+		[DRAW_KNOWN_ENDGAME] = "Drawn endgame",
+	};
+	char				*color = is_black ? "Black" : "White";
+	s8 					check = FALSE, mat = FALSE;
+	DrawReason			draw = DRAW_NONE;
+	s8					winner = IS_WHITE;
+	char				*win_msg = NULL;
+
+	/* Check if the king is in check */
+	if ((is_black && u8ValueGet(b->info, BLACK_CHECK)) || (!is_black && u8ValueGet(b->info, WHITE_CHECK))) {
+		check = TRUE;
 	}
-	return (FALSE);
-}
 
-/* @brief	Get piece move function
- * @param	piece_move	Array of PieceMove struct
- * @param	piece_type	ChessPiece enum
- * @return	GetMoveFunc function pointer
-*/
-static GetMoveFunc get_piece_move_func(PieceMove *piece_move, ChessPiece piece_type) {
-	for (int i = 0; i < PIECE_MOVE_ARRAY_SIZE; i++) {
-		if (piece_move[i].white_piece_type == piece_type || piece_move[i].black_piece_type == piece_type) {
-			return (piece_move[i].get_move_func);
-		}
-	}
-	return (NULL);
-}
+	/* No legal move is mat if the king is in check, pat otherwise */
+	mat = !has_legal_move(b, is_black);
+
+	SDLHandle *h = get_SDL_handle();
 
-/* @brief	Get piece move generic function
- * @param	board		ChessBoard struct
- * @param	piece		Bitboard of the selected piece
- * @param	piece_type	ChessPiece enum
- * @return	Bitboard of the possible moves
- */
-Bitboard get_piece_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, s8 check_legal) {
- 	
-	static PieceMove	piece_move_array[PIECE_MOVE_ARRAY_SIZE] = {
-		{WHITE_PAWN, BLACK_PAWN, get_pawn_moves},
-		{WHITE_KNIGHT, BLACK_KNIGHT, get_knight_moves},
-		{WHITE_BISHOP, BLACK_BISHOP, get_bishop_moves},
-		{WHITE_ROOK, BLACK_ROOK, get_rook_moves},
-		{WHITE_QUEEN, BLACK_QUEEN, get_queen_moves},
-		{WHITE_KING, BLACK_KING, get_king_moves},
-	}; 
-	GetMoveFunc 		get_move_func = NULL;
-	s8					is_black = (piece_type >= BLACK_PAWN);
-
-	/* Get the piece move function */
-	get_move_func = get_piece_move_func(piece_move_array, piece_type);
-	
-	/* If not get move function found, empty tile is selected reset the possible move variable */
-	if (!get_move_func) {
-		return (0);
+	if (check && mat) {
+
+		char *checkmate_msg = ft_strjoin(color, " is checkmate");
+
+		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
+		
+		/* Set game_start bool to false */
+		h->game_start = FALSE;
+		center_text_string_set(h, checkmate_msg, "Do you want to replay ?");
+		free(checkmate_msg);
+		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
+		return (TRUE);
+	} else if (!check && mat) {
+		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
+		CHESS_LOG(LOG_ERROR, PURPLE"PAT detected Egality for %s\n"RESET, color);
+
+		/* Set game_start bool to false */
+		h->game_start = FALSE;
+		center_text_string_set(h, "Pat", "Game Over");
+		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
+		return (TRUE);	
 	}
-	return (get_move_func(board, piece, piece_type, is_black, check_legal));
-}
 
-/**
- * @brief Handle turn count variable
- * @param b				ChessBoard struct
- * @param piece_type	ChessPiece enumm the piece type just moved
- * @param kill			TRUE if a piece is killed, FALSE otherwise
- */
-void handle_turn_count(ChessBoard *b, ChessPiece piece_type, s8 kill) {
-	if (kill == TRUE || (piece_type == BLACK_PAWN || piece_type == WHITE_PAWN)) {
-		b->halfmove_count = 0;
-	} else {
-		b->halfmove_count++;
+	/* Draw rules, the mat has priority on the fifty moves rule */
+	draw = get_draw_reason(b);
+	if (draw != DRAW_NONE) {
+		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
+		CHESS_LOG(LOG_INFO, PURPLE"Draw detected: %s\n"RESET, DrawReason_to_str(draw));
+
+		/* Set game_start bool to false */
+		h->game_start = FALSE;
+		center_text_string_set(h, "Draw", (char *)draw_msg[draw]);
+		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
+		return (TRUE);
 	}
-	if (piece_type >= BLACK_PAWN) {
-		b->fullmove_count++;
+
+	/* Trivially won endgame, the game is adjudicated for the winning side */
+	if (endgame_adjudicate(b, &winner)) {
+		set_flag(&h->flag, FLAG_CENTER_TEXT_INPUT);
+		win_msg = ft_strjoin(winner == IS_BLACK ? "Black" : "White", " wins");
+		CHESS_LOG(LOG_INFO, PURPLE"Known endgame: %s\n"RESET, win_msg);
+
+		/* Set game_start bool to false */
+		h->game_start = FALSE;
+		center_text_string_set(h, win_msg, "Won endgame");
+		free(win_msg);
+		center_text_function_set(h, h->center_text, (BtnCenterText) {"Replay", replay_func}, (BtnCenterText){"Exit", exit_func});
+		return (TRUE);
 	}
+	return (FALSE);
 }
 
-
 /* @brief Move a piece from a tile to another and update the board state
  * @param board		ChessBoard struct
  * @param tile_from	ChessTile enum
@@ -181,40 +123,22 @@ void handle_turn_count(ChessBoard *b, ChessPiece piece_type, s8 kill) {
  * @return PAWN_PROMOTION if the move is a pawn promotion, CHESS_QUIT if the move is a quit move, TRUE otherwise
 */
 s32 move_piece(SDLHandle *handle, ChessTile tile_from, ChessTile tile_to, ChessPiece piece_type) {
-	Bitboard	mask_from = 1ULL << tile_from;
-	Bitboard	mask_to = 1ULL << tile_to;
 	s32			ret = TRUE;
-	s8			kill = FALSE;
-
-	/* Check if the enemy piece need to be kill, handle 'en passant' kill too */
-	kill = handle_enemy_piece_kill(handle->board, piece_type, mask_to);
-
-	/* Check if the move is a castle move and move rook if needed */
-	handle_castle_move(handle, piece_type, tile_from, tile_to);
+	ChessPiece	captured = EMPTY;
 
-	/* Remove the piece from the from tile */
-	handle->board->piece[piece_type] &= ~mask_from;
-	
-	/* Add the piece to the to tile */
-	handle->board->piece[piece_type] |= mask_to;
-
-	/* Update the piece state */
-	update_piece_state(handle->board);
+	/* Apply the move on the board, handle capture, castle, 'en passant' and turn count */
+	captured = board_apply_move(handle->board, tile_from, tile_to, piece_type, EMPTY);
+	if (captured != EMPTY) {
+		add_kill_lst(handle->board, captured);
+	}
+	BOARD_DEBUG_CHECK(handle->board);
 
-	// s32 pawn_ret = check_pawn_promot;
-	// if (pawn_ret == CHESS_QUIT) { return (CHESS_QUIT); } // toremove
 	/* Check if the pawn need to be promoted */
 	if (check_pawn_promotion(handle, piece_type, tile_to) == TRUE) { ret = PAWN_PROMOTION; }
 
 	/* Check if the enemy king is check and mat or PAT */
 	verify_check_and_mat(handle->board, !(piece_type >= BLACK_PAWN));
 
-	/* Set special info for the king and rook */
-	board_special_info_handler(handle->board, piece_type, tile_from);
-
-	/* Update 'en passant' Bitboard if needed */
-	update_en_passant_bitboard(handle->board, piece_type, tile_from, tile_to);
-
 	/* Update the last move variable */
 	handle->board->last_tile_from = tile_from;
 	handle->board->last_tile_to = tile_to;
@@ -228,9 +152,6 @@ s32 move_piece(SDLHandle *handle, ChessTile tile_from, ChessTile tile_to, ChessP
 		set_flag(&handle->flag, FLAG_FIRST_MOVE_PLAYED);
 	}
 
-	/* Handle turn count */
-	handle_turn_count(handle->board, piece_type, kill);
-
 	// display_move_list(handle->board->lst);
 	return (ret);
-}
\ No newline at end of file
+}
@@ -2,7 +2,7 @@
 #include "../include/handle_sdl.h"
 #include "../include/network.h"
 #include "../include/chess_log.h"
-#include "../include/FEN_notation.h"
+#include "../include/chess_bot.h"
 
 FT_INLINE s8 is_left_click_down(SDL_Event event) {
 	return (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT);
@@ -28,7 +28,10 @@ FT_INLINE s8 is_key_pressed(SDL_Event event, s32 key) {
 	return (event.type == SDL_KEYDOWN && event.key.keysym.sym == key);
 }
 
-FT_INLINE void handle_locale_turn(SDLHandle *h) {
+/* @brief Give the turn to the other color in local mode
+ * @param h		SDLHandle struct
+*/
+void handle_locale_turn(SDLHandle *h) {
 	if (h->player_info.piece_start == WHITE_PAWN) {
 		h->player_info.piece_start = BLACK_PAWN;
 		h->player_info.piece_end = BLACK_KING;
@@ -38,6 +41,10 @@ FT_INLINE void handle_locale_turn(SDLHandle *h) {
 		h->player_info.piece_end = WHITE_KING;
 		// h->player_info.color = IS_WHITE;
 	}
+	/* A promotion is handed over when the piece is chosen */
+	if (!has_flag(h->flag, FLAG_PROMOTION_SELECTION)) {
+		bot_turn_handover(h->board);
+	}
 }
 
 /**
@@ -224,19 +231,20 @@ static void game_handle_left_click_up(SDLHandle *h, s32 x, s32 y, s8 player_colo
 	}
 }
 
-#include "../include/chess_bot.h"
-
 static void game_event_handling(SDLHandle *h, SDL_Event event, s8 player_color) {
-	s32 x = 0, y = 0;
+	s32			x = 0, y = 0;
+	BotClock	clock;
 
 	if (ESCAPE_PRESSED(event)) {
 		h->menu.is_open = TRUE;
 	}
 
-	if (is_key_pressed(event, SDLK_p)) {
-		char *fen = build_FEN_notation(h);
-		send_stockfish_fen(fen);
-		free(fen);
+	/* Local bot plays the side to move, the move is read in local_chess_routine */
+	if (is_key_pressed(event, SDLK_p) && is_locale_mode(h->flag) && h->game_start && !bot_busy()) {
+		/* The clocks run from the first bot move */
+		set_flag(&h->flag, FLAG_BOT_GAME);
+		bot_clock_from_handle(h, h->board->turn, &clock);
+		bot_request_move(h->board, BOT_DEFAULT_LEVEL, &clock);
 	}
 
 	if (h->player_info.turn == FALSE) { return ; }
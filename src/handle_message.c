@@ -1,6 +1,7 @@
 #include "../include/network.h"
 #include "../include/handle_sdl.h"
 #include "../include/chess_log.h"
+#include "../include/chess_bot.h"
 
 /*
  * Potential struct :
@@ -181,6 +182,7 @@ void process_message_receive(SDLHandle *handle, char *msg) {
 		}
 		handle->player_info.turn = TRUE;
 		handle->enemy_remaining_time = *(u64 *)&msg[IDX_MY_TIMER];
+		bot_turn_handover(handle->board);
 	} else if (msg_type == MSG_TYPE_RECONNECT)  {
 		process_reconnect_message(handle, msg);
 		update_msg_store(handle->player_info.last_msg, msg);
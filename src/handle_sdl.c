@@ -168,8 +168,8 @@ SDLHandle *create_sdl_handle(const char* title) {
 		return (NULL);
 	}
 	fast_bzero(handle->timer_str, TIME_STR_SIZE);
-	handle->my_remaining_time = 60 * 30;
-	handle->enemy_remaining_time = 60 * 30;
+	handle->my_remaining_time = GAME_TIME_SEC;
+	handle->enemy_remaining_time = GAME_TIME_SEC;
 
 	/* Init name rect */
 	handle->name_rect_bot = BUILD_NAME_RECT(handle, TRUE);
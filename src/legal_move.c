@@ -0,0 +1,249 @@
+#include "../include/chess.h"
+
+/*
+ * Legal move filtering with check and pin masks.
+ * The checkers and pinned pieces of the side to move are computed once per
+ * position (compute_check_info), then each pseudo legal move set is masked:
+ * - king moves: destination must not be attacked once the king left its tile
+ * - double check: only the king can move
+ * - single check: the move must capture the checker or block the check line
+ * - pinned piece: the move must stay on the line through the king and the piece
+ * 'En passant' captures remove two pawns from the same rank, so they are verified
+ * with a full attack test on the resulting occupancy.
+*/
+
+/* @brief Get all pieces (both colors) attacking a tile
+ * @param b			ChessBoard struct
+ * @param tile		ChessTile enum
+ * @param occupied	Bitboard of the occupied tiles used for sliding pieces
+ * @return Bitboard of the attackers
+*/
+Bitboard get_attackers_to(ChessBoard *b, ChessTile tile, Bitboard occupied) {
+	Bitboard rook_like = b->piece[WHITE_ROOK] | b->piece[BLACK_ROOK] | b->piece[WHITE_QUEEN] | b->piece[BLACK_QUEEN];
+	Bitboard bishop_like = b->piece[WHITE_BISHOP] | b->piece[BLACK_BISHOP] | b->piece[WHITE_QUEEN] | b->piece[BLACK_QUEEN];
+
+	return ((g_pawn_attack[IS_BLACK][tile] & b->piece[WHITE_PAWN])
+		| (g_pawn_attack[IS_WHITE][tile] & b->piece[BLACK_PAWN])
+		| (g_knight_attack[tile] & (b->piece[WHITE_KNIGHT] | b->piece[BLACK_KNIGHT]))
+		| (g_king_attack[tile] & (b->piece[WHITE_KING] | b->piece[BLACK_KING]))
+		| (get_rook_attacks(tile, occupied) & rook_like)
+		| (get_bishop_attacks(tile, occupied) & bishop_like));
+}
+
+/* @brief Check if a tile is attacked by a color
+ * @param b			ChessBoard struct
+ * @param tile		ChessTile enum
+ * @param by_black	TRUE to check black attackers, FALSE for white
+ * @param occupied	Bitboard of the occupied tiles used for sliding pieces
+ * @return TRUE if the tile is attacked, FALSE otherwise
+*/
+s8 is_tile_attacked(ChessBoard *b, ChessTile tile, s8 by_black, Bitboard occupied) {
+	ChessPiece	start = by_black ? BLACK_PAWN : WHITE_PAWN;
+	Bitboard	queen = b->piece[start + 4];
+
+	/* Leapers first, they are the cheapest test */
+	if ((g_pawn_attack[!by_black][tile] & b->piece[start])
+		|| (g_knight_attack[tile] & b->piece[start + 1])
+		|| (g_king_attack[tile] & b->piece[start + 5])) {
+		return (TRUE);
+	}
+	return ((get_bishop_attacks(tile, occupied) & (b->piece[start + 2] | queen))
+		|| (get_rook_attacks(tile, occupied) & (b->piece[start + 3] | queen)));
+}
+
+/* @brief Compute the checkers, check mask and pinned pieces of a color
+ * @param b			ChessBoard struct
+ * @param is_black	Color of the king to check
+ * @param ci		CheckInfo struct to fill
+*/
+void compute_check_info(ChessBoard *b, s8 is_black, CheckInfo *ci) {
+	Bitboard	ally = is_black ? b->black : b->white;
+	Bitboard	enemy = is_black ? b->white : b->black;
+	ChessPiece	enemy_start = is_black ? WHITE_PAWN : BLACK_PAWN;
+	Bitboard	snipers = 0, blockers = 0;
+	ChessTile	sniper_tile = INVALID_TILE;
+
+	ci->is_black = is_black;
+	ci->checkers = 0;
+	ci->pinned = 0;
+	ci->check_mask = UINT64_MAX;
+	ci->king_tile = get_tile_from_mask(b->piece[is_black ? BLACK_KING : WHITE_KING]);
+	if (ci->king_tile == INVALID_TILE) {
+		return ;
+	}
+
+	/* Get checkers */
+	ci->checkers = get_attackers_to(b, ci->king_tile, b->occupied) & enemy;
+	if (ci->checkers) {
+		/* With more than one checker only king moves are legal */
+		if (ci->checkers & (ci->checkers - 1)) {
+			ci->check_mask = 0;
+		} else {
+			ci->check_mask = ci->checkers | g_line_between[ci->king_tile][get_tile_from_mask(ci->checkers)];
+		}
+	}
+
+	/* Enemy sliders aligned with the king on an empty board */
+	snipers = (get_rook_attacks(ci->king_tile, 0) & (b->piece[enemy_start + 3] | b->piece[enemy_start + 4]))
+		| (get_bishop_attacks(ci->king_tile, 0) & (b->piece[enemy_start + 2] | b->piece[enemy_start + 4]));
+
+	/* A sniper with a single ally piece between it and the king pins this piece */
+	while (snipers) {
+		sniper_tile = get_tile_from_mask(snipers);
+		blockers = g_line_between[ci->king_tile][sniper_tile] & b->occupied;
+		if (blockers && !(blockers & (blockers - 1)) && (blockers & ally)) {
+			ci->pinned |= blockers;
+		}
+		snipers &= snipers - 1;
+	}
+}
+
+/* @brief Check if an 'en passant' capture leave the king safe
+ * @param b		ChessBoard struct
+ * @param from	ChessTile of the capturing pawn
+ * @param to	ChessTile of the 'en passant' destination
+ * @param ci	CheckInfo of the capturing color
+ * @return TRUE if the capture is legal, FALSE otherwise
+*/
+static s8 is_legal_en_passant(ChessBoard *b, ChessTile from, ChessTile to, CheckInfo *ci) {
+	Bitboard	captured = 1ULL << b->en_passant_tile;
+	Bitboard	occupied = (b->occupied ^ (1ULL << from) ^ captured) | (1ULL << to);
+	Bitboard	enemy = (ci->is_black ? b->white : b->black) & ~captured;
+
+	if (ci->king_tile == INVALID_TILE) {
+		return (TRUE);
+	}
+	/* Both pawns left the rank and the capturing pawn block its destination */
+	return ((get_attackers_to(b, ci->king_tile, occupied) & enemy) == 0);
+}
+
+/* @brief Keep only the legal moves of a pseudo legal move set
+ * @param b		ChessBoard struct
+ * @param tile	ChessTile of the piece
+ * @param type	ChessPiece enum
+ * @param moves	Bitboard of the pseudo legal moves
+ * @param ci	CheckInfo of the piece color
+ * @return Bitboard of the legal moves
+*/
+Bitboard keep_legal_moves(ChessBoard *b, ChessTile tile, ChessPiece type, Bitboard moves, CheckInfo *ci) {
+	Bitboard	from = 1ULL << tile;
+	Bitboard	legal = 0, occupied = 0, en_passant = 0;
+	ChessTile	to = INVALID_TILE;
+
+	/* King moves, the king itself can't block a slider attack behind him */
+	if (type == WHITE_KING || type == BLACK_KING) {
+		occupied = b->occupied ^ from;
+		while (moves) {
+			to = get_tile_from_mask(moves);
+			if (!is_tile_attacked(b, to, !ci->is_black, occupied)) {
+				legal |= 1ULL << to;
+			}
+			moves &= moves - 1;
+		}
+		return (legal);
+	}
+
+	/* 'En passant' capture is verified apart, the captured pawn is not on the destination */
+	if ((type == WHITE_PAWN || type == BLACK_PAWN) && (moves & b->en_passant)) {
+		en_passant = b->en_passant;
+		moves &= ~en_passant;
+		if (!is_legal_en_passant(b, tile, get_tile_from_mask(en_passant), ci)) {
+			en_passant = 0;
+		}
+	}
+
+	legal = moves & ci->check_mask;
+	if (ci->pinned & from) {
+		legal &= g_line_through[ci->king_tile][tile];
+	}
+	return (legal | en_passant);
+}
+
+/* @brief	Get piece pseudo legal move, king safety is not verified
+ * @param	board		ChessBoard struct
+ * @param	piece		Bitboard of the selected piece
+ * @param	piece_type	ChessPiece enum
+ * @param	check_legal	TRUE for pseudo legal moves, FALSE for control tiles
+ * @return	Bitboard of the possible moves
+ */
+static Bitboard get_piece_pseudo_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, s8 check_legal) {
+	s8 is_black = (piece_type >= BLACK_PAWN);
+
+	switch (piece_type) {
+		case WHITE_PAWN: case BLACK_PAWN:
+			return (get_pawn_moves(board, piece, piece_type, is_black, check_legal));
+		case WHITE_KNIGHT: case BLACK_KNIGHT:
+			return (get_knight_moves(board, piece, piece_type, is_black, check_legal));
+		case WHITE_BISHOP: case BLACK_BISHOP:
+			return (get_bishop_moves(board, piece, piece_type, is_black, check_legal));
+		case WHITE_ROOK: case BLACK_ROOK:
+			return (get_rook_moves(board, piece, piece_type, is_black, check_legal));
+		case WHITE_QUEEN: case BLACK_QUEEN:
+			return (get_queen_moves(board, piece, piece_type, is_black, check_legal));
+		case WHITE_KING: case BLACK_KING:
+			return (get_king_moves(board, piece, piece_type, is_black, check_legal));
+		default:
+			/* Empty tile is selected, no possible move */
+			return (0);
+	}
+}
+
+/* @brief	Get piece legal move with precomputed check info
+ * @param	board		ChessBoard struct
+ * @param	piece		Bitboard of the selected piece
+ * @param	piece_type	ChessPiece enum
+ * @param	ci			CheckInfo of the piece color, see compute_check_info
+ * @return	Bitboard of the legal moves
+ */
+Bitboard get_legal_piece_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, CheckInfo *ci) {
+	Bitboard moves = get_piece_pseudo_move(board, piece, piece_type, TRUE);
+
+	if (moves == 0) {
+		return (0);
+	}
+	return (keep_legal_moves(board, get_tile_from_mask(piece), piece_type, moves, ci));
+}
+
+/* @brief	Get piece move generic function
+ * @param	board		ChessBoard struct
+ * @param	piece		Bitboard of the selected piece
+ * @param	piece_type	ChessPiece enum
+ * @param	check_legal	TRUE for legal moves, FALSE for control tiles
+ * @return	Bitboard of the possible moves
+ */
+Bitboard get_piece_move(ChessBoard *board, Bitboard piece, ChessPiece piece_type, s8 check_legal) {
+	CheckInfo ci;
+
+	if (!check_legal || piece_type == EMPTY) {
+		return (get_piece_pseudo_move(board, piece, piece_type, FALSE));
+	}
+	compute_check_info(board, piece_type >= BLACK_PAWN, &ci);
+	return (get_legal_piece_move(board, piece, piece_type, &ci));
+}
+
+/* @brief Check if a color has at least one legal move
+ * @param b			ChessBoard struct
+ * @param is_black	Color to check
+ * @return TRUE if a legal move exists, FALSE if the color is mat or pat
+*/
+s8 has_legal_move(ChessBoard *b, s8 is_black) {
+	ChessPiece	piece_start = is_black ? BLACK_PAWN : WHITE_PAWN;
+	ChessPiece	piece_end = is_black ? PIECE_MAX : BLACK_PAWN;
+	Bitboard	pieces = 0;
+	CheckInfo	ci;
+
+	/* Compute checkers and pinned pieces once for all the pieces */
+	compute_check_info(b, is_black, &ci);
+
+	for (ChessPiece type = piece_start; type < piece_end; type++) {
+		pieces = b->piece[type];
+		while (pieces) {
+			if (get_legal_piece_move(b, pieces & -pieces, type, &ci) != 0) {
+				return (TRUE);
+			}
+			/* Clear the first bit set */
+			pieces &= pieces - 1;
+		}
+	}
+	return (FALSE);
+}
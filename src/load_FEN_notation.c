@@ -0,0 +1,156 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+
+/**
+ * @brief Convert a FEN piece char to ChessPiece
+ * @param c The FEN char
+ * @return The ChessPiece or EMPTY if the char is not a piece
+ */
+static ChessPiece fen_to_chess_piece(char c) {
+	static const char fen_piece[PIECE_MAX + 1] = "PNBRQKpnbrqk";
+
+	for (ChessPiece piece = WHITE_PAWN; piece < PIECE_MAX; piece++) {
+		if (fen_piece[piece] == c) {
+			return (piece);
+		}
+	}
+	return (EMPTY);
+}
+
+/**
+ * @brief Parse the piece placement field
+ * @param b The ChessBoard pointer
+ * @param fen The FEN string, updated to the end of the field
+ * @return TRUE if the field is valid, FALSE otherwise
+ */
+static s8 parse_fen_board(ChessBoard *b, const char **fen) {
+	const char	*str = *fen;
+	ChessPiece	piece = EMPTY;
+	s32			rank = 7, file = 0;
+
+	for (; *str && *str != ' '; str++) {
+		if (*str == '/') {
+			if (file != 8 || rank == 0) {
+				return (FALSE);
+			}
+			rank--;
+			file = 0;
+		} else if (*str >= '1' && *str <= '8') {
+			file += *str - '0';
+		} else {
+			piece = fen_to_chess_piece(*str);
+			if (piece == EMPTY || file > 7) {
+				return (FALSE);
+			}
+			b->piece[piece] |= 1ULL << (rank * 8 + file);
+			file++;
+		}
+		if (file > 8) {
+			return (FALSE);
+		}
+	}
+	*fen = str;
+	return (rank == 0 && file == 8);
+}
+
+/**
+ * @brief Parse the castling field, set the moved flags of the lost castle rights
+ * @param b The ChessBoard pointer
+ * @param str The castling field
+ */
+static void parse_fen_castling(ChessBoard *b, const char *str) {
+	s8 white_king = FALSE, white_queen = FALSE, black_king = FALSE, black_queen = FALSE;
+
+	for (; *str && *str != ' '; str++) {
+		white_king |= (*str == 'K');
+		white_queen |= (*str == 'Q');
+		black_king |= (*str == 'k');
+		black_queen |= (*str == 'q');
+	}
+	b->info = u8ValueSet(b->info, WHITE_KING_ROOK_MOVED, !white_king);
+	b->info = u8ValueSet(b->info, WHITE_QUEEN_ROOK_MOVED, !white_queen);
+	b->info = u8ValueSet(b->info, WHITE_KING_MOVED, !white_king && !white_queen);
+	b->info = u8ValueSet(b->info, BLACK_KING_ROOK_MOVED, !black_king);
+	b->info = u8ValueSet(b->info, BLACK_QUEEN_ROOK_MOVED, !black_queen);
+	b->info = u8ValueSet(b->info, BLACK_KING_MOVED, !black_king && !black_queen);
+}
+
+/**
+ * @brief Go to the next field of the FEN string
+ * @param str The FEN string
+ * @return The start of the next field or NULL if there is no next field
+ */
+static const char *next_fen_field(const char *str) {
+	while (*str && *str != ' ') {
+		str++;
+	}
+	while (*str == ' ') {
+		str++;
+	}
+	return (*str ? str : NULL);
+}
+
+/**
+ * @brief Load a board from a FEN notation, the move lists of the board are not touched
+ * @param b The ChessBoard pointer
+ * @param fen The FEN string, halfmove and fullmove fields are optional
+ * @return TRUE if the FEN is valid, FALSE otherwise (the board is left empty)
+ */
+s8 load_FEN_notation(ChessBoard *b, const char *fen) {
+	const char	*str = fen;
+	ChessTile	tile = INVALID_TILE;
+
+	init_attack_table();
+	init_zobrist_table();
+	init_eval_table();
+	init_endgame_table();
+
+	/* Reset the board state */
+	for (ChessPiece piece = WHITE_PAWN; piece < PIECE_MAX; piece++) {
+		b->piece[piece] = 0;
+	}
+	b->info = 0;
+	b->en_passant = 0;
+	b->en_passant_tile = INVALID_TILE;
+	b->halfmove_count = 0;
+	b->fullmove_count = 1;
+	b->selected_piece = EMPTY;
+	b->selected_tile = INVALID_TILE;
+	b->last_tile_from = INVALID_TILE;
+	b->last_tile_to = INVALID_TILE;
+	b->possible_moves = 0;
+
+	/* Piece placement and color to play */
+	if (!parse_fen_board(b, &str) || !(str = next_fen_field(str)) || (*str != 'w' && *str != 'b')) {
+		CHESS_LOG(LOG_ERROR, "Invalid FEN notation: %s\n", fen);
+		fast_bzero(b->piece, sizeof(b->piece));
+		update_piece_state(b);
+		return (FALSE);
+	}
+	b->turn = (*str == 'b') ? IS_BLACK : IS_WHITE;
+
+	/* Castling */
+	if ((str = next_fen_field(str))) {
+		parse_fen_castling(b, str);
+		str = next_fen_field(str);
+	}
+
+	/* 'En passant' target tile, the pawn to capture is one rank behind */
+	if (str && str[0] >= 'a' && str[0] <= 'h' && (str[1] == '3' || str[1] == '6')) {
+		tile = (str[1] - '1') * 8 + (str[0] - 'a');
+		b->en_passant = 1ULL << tile;
+		b->en_passant_tile = b->turn == IS_BLACK ? tile + 8 : tile - 8;
+	}
+
+	/* Halfmove and fullmove counters */
+	if (str && (str = next_fen_field(str))) {
+		b->halfmove_count = (u8)ft_atoi(str);
+		if ((str = next_fen_field(str))) {
+			b->fullmove_count = (u16)ft_atoi(str);
+		}
+	}
+
+	/* Update occupied, mailbox and check flags */
+	update_piece_state(b);
+	return (TRUE);
+}
@@ -3,6 +3,7 @@
 #include "../include/network.h"
 #include "../include/handle_signal.h"
 #include "../include/chess_log.h"
+#include "../include/chess_bot.h"
 
 #ifdef _EMSCRIPTEN_VERSION_
 	#include <emscripten.h>
@@ -29,6 +30,11 @@ void set_local_info(SDLHandle *h) {
 
 
 void reset_board(SDLHandle *h) {
+	/* The bot move of the old game is dropped */
+	bot_cancel();
+	unset_flag(&h->flag, FLAG_BOT_GAME);
+	h->my_remaining_time = GAME_TIME_SEC;
+	h->enemy_remaining_time = GAME_TIME_SEC;
 	set_local_info(h);
 	init_board(h->board, &h->flag);
 }
@@ -56,6 +62,8 @@ SDLHandle *init_game() {
 		return (NULL);
 	}
 	init_board(handle->board, &handle->flag);
+	/* Seed the bot random choice of the weighted book move */
+	srand(time(NULL));
 
 	return (handle);
 }
@@ -66,11 +74,20 @@ SDLHandle *init_game() {
 */
 void local_chess_routine() {
 	SDLHandle	*h = get_SDL_handle();
+	Move		bot_move = MOVE_NONE;
 	s32			event = 0;
 	
 	event = event_handler(h, h->player_info.color);
 	/* If the quit button is pressed */
 	if (event == CHESS_QUIT) { chess_destroy(h) ; }
+
+	/* Bot move from the worker or the remote engine, dropped if the board changed since the request */
+	if (bot_poll_move(h->board, &bot_move) && h->game_start) {
+		if (bot_apply_move(h, bot_move)) {
+			handle_locale_turn(h);
+			bot_ponder(h, BOT_DEFAULT_LEVEL);
+		}
+	}
 	
 	if (has_flag(h->flag, FLAG_PROMOTION_SELECTION)) {
 		pawn_selection_event(h);
@@ -85,6 +102,7 @@ void chess_destroy(SDLHandle *h) {
 	CHESS_LOG(LOG_INFO, RED"Destroy chess game%s\n", RESET);
 
 	register_data(h, DATA_SAVE_FILE);
+	bot_destroy();
 
 	if (h->board->lst) {
 		ft_lstclear(&h->board->lst, free);
@@ -0,0 +1,161 @@
+#include "../include/chess.h"
+#include "../include/chess_bot.h"
+
+/* @brief Get the piece kind of a ChessPiece, pawn (0) to king (5), the CHESS_PIECE_ENUM order is the value order */
+FT_INLINE s32 piece_kind(ChessPiece type) {
+	return (type >= BLACK_PAWN ? type - BLACK_PAWN : type);
+}
+
+/* @brief Score a capture, most valuable victim first then least valuable attacker
+ * @param b		ChessBoard struct
+ * @param move	Capture move
+ * @return Ordering score, higher is searched first
+*/
+static s32 mvv_lva_score(ChessBoard *b, Move move) {
+	ChessPiece	victim = b->mailbox[move_to(move)];
+	s32			score = 0;
+
+	/* The 'en passant' destination tile is empty, the victim is a pawn */
+	score = (victim == EMPTY ? 0 : piece_kind(victim)) * 8 + (7 - piece_kind(b->mailbox[move_from(move)]));
+	if (move_is_promotion(move)) {
+		score += (move_flag(move) & 3) * 8;
+	}
+	return (score);
+}
+
+/* @brief Init a picker for all the legal moves
+ * @param mp		MovePicker struct
+ * @param b			ChessBoard struct
+ * @param hash_move	Transposition table move, MOVE_NONE if none
+ * @param killer	Killer moves of the ply (KILLER_SIZE), NULL if none
+ * @param history	History table, NULL if none
+*/
+void move_picker_init(MovePicker *mp, ChessBoard *b, Move hash_move, Move *killer, s32 (*history)[TILE_MAX]) {
+	mp->b = b;
+	mp->hash_move = hash_move;
+	for (s32 i = 0; i < KILLER_SIZE; i++) {
+		mp->killer[i] = killer ? killer[i] : MOVE_NONE;
+	}
+	mp->history = history;
+	mp->count = 0;
+	mp->idx = 0;
+	mp->stage = STAGE_HASH;
+	mp->last_stage = STAGE_QUIET;
+}
+
+/* @brief Init a picker for the captures only (quiescence search)
+ * @param mp		MovePicker struct
+ * @param b			ChessBoard struct
+*/
+void move_picker_init_capture(MovePicker *mp, ChessBoard *b) {
+	move_picker_init(mp, b, MOVE_NONE, NULL, NULL);
+	mp->stage = STAGE_CAPTURE_GEN;
+	mp->last_stage = STAGE_CAPTURE;
+}
+
+/* @brief Check if a move is already given by the hash or killer stage */
+static s8 is_special_move(MovePicker *mp, Move move) {
+	if (move == mp->hash_move) {
+		return (TRUE);
+	}
+	for (s32 i = 0; i < KILLER_SIZE && mp->stage == STAGE_QUIET; i++) {
+		if (move == mp->killer[i] && move != MOVE_NONE) {
+			return (TRUE);
+		}
+	}
+	return (FALSE);
+}
+
+/* @brief Get the best scored move left in the current stage
+ * @param mp	MovePicker struct
+ * @return The move, MOVE_NONE if the stage is done
+*/
+static Move pick_best(MovePicker *mp) {
+	s32		best = 0;
+	Move	move = MOVE_NONE;
+	s32		score = 0;
+
+	while (mp->idx < mp->count) {
+		best = mp->idx;
+		for (s32 i = mp->idx + 1; i < mp->count; i++) {
+			if (mp->score[i] > mp->score[best]) {
+				best = i;
+			}
+		}
+		/* Swap the best move at idx */
+		move = mp->moves[best];
+		score = mp->score[best];
+		mp->moves[best] = mp->moves[mp->idx];
+		mp->score[best] = mp->score[mp->idx];
+		mp->moves[mp->idx] = move;
+		mp->score[mp->idx] = score;
+		mp->idx++;
+		if (!is_special_move(mp, move)) {
+			return (move);
+		}
+	}
+	return (MOVE_NONE);
+}
+
+/* @brief Get the next move to search
+ * @param mp	MovePicker struct
+ * @return The next legal move, MOVE_NONE when all the moves are given
+*/
+Move move_picker_next(MovePicker *mp) {
+	Move move = MOVE_NONE;
+
+	while (mp->stage <= mp->last_stage) {
+		switch (mp->stage) {
+			case STAGE_HASH:
+				mp->stage++;
+				if (is_legal_move(mp->b, mp->hash_move)) {
+					return (mp->hash_move);
+				}
+				mp->hash_move = MOVE_NONE;
+				break ;
+			case STAGE_CAPTURE_GEN:
+				mp->count = generate_capture_moves(mp->b, mp->moves);
+				mp->idx = 0;
+				for (s32 i = 0; i < mp->count; i++) {
+					mp->score[i] = mvv_lva_score(mp->b, mp->moves[i]);
+				}
+				mp->stage++;
+				break ;
+			case STAGE_CAPTURE:
+				if ((move = pick_best(mp)) != MOVE_NONE) {
+					return (move);
+				}
+				mp->stage++;
+				mp->idx = 0;
+				break ;
+			case STAGE_KILLER:
+				/* idx is the next killer to try, a killer must be a legal quiet move here */
+				while (mp->idx < KILLER_SIZE) {
+					move = mp->killer[mp->idx++];
+					if (move != mp->hash_move && is_legal_move(mp->b, move) && !move_is_capture(move)) {
+						return (move);
+					}
+				}
+				mp->stage++;
+				break ;
+			case STAGE_QUIET_GEN:
+				mp->count = generate_quiet_moves(mp->b, mp->moves);
+				mp->idx = 0;
+				for (s32 i = 0; i < mp->count; i++) {
+					mp->score[i] = mp->history ? mp->history[mp->b->mailbox[move_from(mp->moves[i])]][move_to(mp->moves[i])] : 0;
+				}
+				mp->stage++;
+				break ;
+			case STAGE_QUIET:
+				if ((move = pick_best(mp)) != MOVE_NONE) {
+					return (move);
+				}
+				mp->stage++;
+				break ;
+			default:
+				mp->stage = STAGE_DONE;
+				break ;
+		}
+	}
+	return (MOVE_NONE);
+}
@@ -40,52 +40,6 @@ int sort_chess_piece(void *a, void *b) {
 }
 
 
-s8 count_piece_value(ChessBoard *b, ChessPiece start, ChessPiece end) {
-	static const struct piece_value {
-		ChessPiece	piece;
-		s8			value;
-	} piece_val_array[] = {
-		{WHITE_PAWN, 1},
-		{WHITE_KNIGHT, 3},
-		{WHITE_BISHOP, 3},
-		{WHITE_ROOK, 5},
-		{WHITE_QUEEN, 9},
-		{WHITE_KING, 0},
-		{BLACK_PAWN, 1},
-		{BLACK_KNIGHT, 3},
-		{BLACK_BISHOP, 3},
-		{BLACK_ROOK, 5},
-		{BLACK_QUEEN, 9},
-		{BLACK_KING, 0},
-		{EMPTY, 0}
-	};
-	s8 value = 0;
-	Bitboard all_piece = 0;
-	// Bitboard piece = 0;
-
-	for (ChessPiece type = start; type < end; type++) {
-		all_piece = b->piece[type];
-		while (all_piece) {
-
-			/* Clear the first bit set */
-			all_piece &= all_piece - 1;
-
-			/* Get the value */
-			value += piece_val_array[type].value;
-			// CHESS_LOG(LOG_INFO, "Add [%d] to %s for %s\n",
-				// piece_val_array[type].value, type >= BLACK_PAWN ? "BLACK" : "WHITE", ChessPiece_to_str(type));
-		}
-	}
-	return (value);
-}
-
-void compute_piece_value(ChessBoard *b) {
-
-	/* We need to check all piece on board to add value */
-	b->white_piece_val = count_piece_value(b, WHITE_PAWN, WHITE_KING);
-	b->black_piece_val = count_piece_value(b, BLACK_PAWN, BLACK_KING);
-}
-
 void add_kill_lst(ChessBoard *b, ChessPiece killed_piece) {
 	ChessPieceList	*node = NULL;
 	ChessPiece		*piece = malloc(sizeof(ChessPiece));
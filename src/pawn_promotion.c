@@ -2,6 +2,7 @@
 #include "../include/network.h"
 #include "../include/handle_sdl.h"
 #include "../include/chess_log.h"
+#include "../include/chess_bot.h"
 
 /* @brief Promot the pawn
  * @param board The ChessBoard structure
@@ -10,13 +11,15 @@
  * @param pawn_type The pawn type to remove
 */
 static void promote_pawn(ChessBoard *board, ChessTile tile, ChessPiece new_piece, ChessPiece pawn_type) {
-	Bitboard mask = 1ULL << tile;
 	/* Remove the pawn */
-	board->piece[pawn_type] &= ~mask;
+	board_remove_piece(board, pawn_type, tile);
 	/* Add the new piece */
-	board->piece[new_piece] |= mask;
-	/* Update the piece state */
-	update_piece_state(board);
+	board_add_piece(board, new_piece, tile);
+	/* The pawn move is already in the position history, replace it by the promoted position */
+	board_history_replace(board);
+	/* Update the check flags */
+	update_check_flags(board);
+	BOARD_DEBUG_CHECK(board);
 
 	/* Add the move to the list */
 	move_save_add(&board->lst, board->last_tile_from, tile, pawn_type, new_piece);
@@ -71,6 +74,8 @@ void pawn_selection_event(SDLHandle *h) {
 			build_message(h, h->player_info.msg_tosend, MSG_TYPE_PROMOTION, h->board->last_tile_from, tile_to, piece_selected);
 			chess_msg_send(h->player_info.nt_info, h->player_info.msg_tosend, MSG_SIZE);
 			h->player_info.turn = FALSE;
+		} else {
+			bot_turn_handover(h->board);
 		}
 		unset_flag(&h->flag, FLAG_PROMOTION_SELECTION);
 	}
@@ -117,18 +122,14 @@ void display_promotion_selection(SDLHandle *h) {
 void do_promotion_move(SDLHandle *h, ChessTile tile_from, ChessTile tile_to, ChessPiece new_piece_type, s8 add_list) {
 	/* If the message is a promotion message, promote the pawn */
 	ChessPiece	opponent_pawn = new_piece_type >= BLACK_KNIGHT ? BLACK_PAWN : WHITE_PAWN;
-	ChessPiece	piece_to_remove = get_piece_from_tile(h->board, tile_to);
-	s8			kill = FALSE;
+	ChessPiece	captured = EMPTY;
 
-	/* Remove the opponent pawn */
-	h->board->piece[opponent_pawn] &= ~(1ULL << tile_from);
-
-	/* Remove the piece if there is one on the tile */
-	kill = handle_enemy_piece_kill(h->board, piece_to_remove, (1ULL << tile_to));
+	/* Move and promote the pawn, the board state and zobrist key follow the move */
+	captured = board_apply_move(h->board, tile_from, tile_to, opponent_pawn, new_piece_type);
+	if (captured != EMPTY) {
+		add_kill_lst(h->board, captured);
+	}
 
-	/* Add the new piece */
-	h->board->piece[new_piece_type] |= (1ULL << tile_to);
-	
 	/* Update the last move */
 	h->board->last_tile_from = tile_from;
 	h->board->last_tile_to = tile_to;
@@ -136,11 +137,7 @@ void do_promotion_move(SDLHandle *h, ChessTile tile_from, ChessTile tile_to, Che
 	if (add_list) {
 		move_save_add(&h->board->lst, tile_from, tile_to, opponent_pawn, new_piece_type);
 	}
-
-	handle_turn_count(h->board, new_piece_type, kill);
-
-
-	update_piece_state(h->board);
+	BOARD_DEBUG_CHECK(h->board);
 }
 
 
@@ -0,0 +1,570 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/chess_bot.h"
+
+#include <pthread.h>
+
+#ifdef CHESS_WINDOWS_VERSION
+	#include <windows.h>
+#else
+	#include <unistd.h>
+#endif
+
+/*
+ * Local bot search: negamax alpha-beta with iterative deepening.
+ * Each depth is searched with the best root move of the previous depth searched first,
+ * the transposition table give the cutoffs and the best move of the positions already seen.
+ * The search stop when the depth, node or time limit is reached, the move of the last
+ * finished depth is kept. With a game clock (src/time_manager.c) no new depth start after
+ * the soft deadline. A ponder search (SearchInfo.ponder) keep its node limit and ignore the time until the ponder hit.
+ * At the horizon a quiescence search play the captures until the position is quiet.
+ * The moves are given by a staged move picker: hash move, captures (MVV-LVA), killer moves,
+ * then the quiet moves ordered by the history table.
+ * With few pieces left the known endgames (src/endgame.c) replace the evaluation, the drawn
+ * ones stop the search, and at the root only the moves that keep the endgame result are searched.
+ * With Syzygy tablebases (src/syzygy.c) the root moves are the ones with the best DTZ.
+ *
+ * Lazy SMP: the helper threads run the same iterative deepening on their own board copy,
+ * only the transposition table is shared. They start with a different root move or one
+ * depth deeper, so they fill the table with positions the main thread will need.
+ * The main thread check the time, any thread can reach the node limit, when the search stop all the threads stop.
+*/
+
+/* The time limit is checked every (TIME_CHECK_MASK + 1) nodes */
+#define TIME_CHECK_MASK 2047
+
+/* Nodes a thread add to the shared count at once, the node limit is checked on each node */
+#define NODE_COUNT_BLOCK 256
+
+/* History score limit, the table is halved when a score reach it */
+#define HISTORY_MAX 16384
+
+/* Search state of one thread */
+typedef struct s_search_thread {
+	SearchInfo	*info;			/* Shared limits and stop flag */
+	ChessBoard	board;			/* Board copy of the thread */
+	pthread_t	thread;			/* Thread id, unused for the main thread */
+	s32			id;				/* Thread index, 0 for the main thread */
+	u64			nodes;			/* Nodes searched by this thread */
+	u64			counted;		/* Nodes already added to the shared count */
+	Move		best_move;		/* Best move of the last finished depth */
+	s32			score;			/* Score of the best move */
+	s32			depth;			/* Last finished depth */
+	Move		root_moves[MAX_MOVES];			/* Root moves, best move of the last depth first */
+	s32			root_count;						/* Number of root moves */
+	Move		killer[MAX_PLY][KILLER_SIZE];	/* Quiet moves that caused a beta cutoff, by ply */
+	s32			history[PIECE_MAX][TILE_MAX];	/* Quiet cutoff bonus by piece and destination */
+} SearchThread;
+
+FT_INLINE s8 search_stopped(SearchInfo *info) {
+	return (__atomic_load_n(&info->stop, __ATOMIC_RELAXED));
+}
+
+FT_INLINE void search_stop(SearchInfo *info) {
+	__atomic_store_n(&info->stop, TRUE, __ATOMIC_RELAXED);
+}
+
+/* @brief Get a monotonic time in milliseconds */
+u64 search_time_ms() {
+#ifdef CHESS_WINDOWS_VERSION
+	return ((u64)GetTickCount64());
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((u64)ts.tv_sec * 1000ULL + (u64)ts.tv_nsec / 1000000ULL);
+#endif
+}
+
+/* @brief Get the number of CPU cores, at least 1 */
+s32 get_cpu_count() {
+	s32 count = 1;
+
+#ifdef CHESS_WINDOWS_VERSION
+	SYSTEM_INFO sys_info;
+
+	GetSystemInfo(&sys_info);
+	count = (s32)sys_info.dwNumberOfProcessors;
+#else
+	count = (s32)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (count < 1 ? 1 : count);
+}
+
+/* @brief Get the skill of a bot level
+ * @param level	BotLevel enum
+ * @return The skill, the first level if the level is unknown
+*/
+const BotSkillLevel *get_bot_skill(BotLevel level) {
+	static const BotSkillLevel skill_level[SKILL_LEVEL_ARRAY_SIZE] = SKILL_LVL_ARRAY;
+
+	for (s32 i = 0; i < SKILL_LEVEL_ARRAY_SIZE; i++) {
+		if (skill_level[i].level == level) {
+			return (&skill_level[i]);
+		}
+	}
+	return (&skill_level[0]);
+}
+
+/* @brief Set the search budget and thread count of a bot level
+ * @param info	SearchInfo struct
+ * @param level	BotLevel enum
+*/
+void set_bot_skill(SearchInfo *info, BotLevel level) {
+	const BotSkillLevel *skill = get_bot_skill(level);
+
+	info->max_depth = SEARCH_MAX_DEPTH;
+	info->node_limit = skill->nodes;
+	info->time_limit_ms = skill->time_ms;
+	info->threads = skill->threads == 0 ? get_cpu_count() : skill->threads;
+}
+
+/* @brief Check if the search must stop, only the main thread check the time
+ * @param t		SearchThread struct
+ * @return TRUE if the search must stop, FALSE otherwise
+ * @note The nodes are added to the shared count by blocks, the node limit is checked against
+ *		the shared count plus the nodes of the thread not added yet: with one thread the search
+ *		stop exactly at the limit. A ponder search stop at the node limit, the time limit
+ *		only apply after the ponder hit.
+*/
+static s8 search_should_stop(SearchThread *t) {
+	SearchInfo	*info = t->info;
+	u64			pending = t->nodes - t->counted;
+
+	if (pending >= NODE_COUNT_BLOCK) {
+		__atomic_add_fetch(&info->node_count, pending, __ATOMIC_RELAXED);
+		t->counted = t->nodes;
+		pending = 0;
+	}
+	if (info->node_limit != 0 && __atomic_load_n(&info->node_count, __ATOMIC_RELAXED) + pending >= info->node_limit) {
+		search_stop(info);
+	}
+	/* The ponder search is on the opponent time, only its node budget count */
+	if (t->id == 0 && (t->nodes & TIME_CHECK_MASK) == 0 && info->time_limit_ms != 0
+		&& !__atomic_load_n(&info->ponder, __ATOMIC_RELAXED) && search_time_ms() - info->start_ms >= info->time_limit_ms) {
+		search_stop(info);
+	}
+	return (search_stopped(info));
+}
+
+/* @brief Check the draw rules inside the search
+ * @param b		ChessBoard struct
+ * @return TRUE if the position is a draw, FALSE otherwise
+ * @note A single repetition is enough, the side that repeat can always repeat again
+*/
+static s8 is_search_draw(ChessBoard *b) {
+	return (b->halfmove_count >= 100 || is_insufficient_material(b) || repetition_count(b) >= 2);
+}
+
+/* @brief Probe the known endgames and the tablebases, only with few pieces on the board
+ * @param b		ChessBoard struct
+ * @return WDL result, side to move point of view
+*/
+FT_INLINE EndgameWDL search_endgame_probe(ChessBoard *b) {
+	s32 count = bitboard_count(b->occupied);
+
+	return (count <= ENDGAME_MAX_PIECES || count <= syzygy_max_pieces() ? endgame_probe(b) : WDL_UNKNOWN);
+}
+
+/* @brief Static evaluation, a known endgame replace the evaluation
+ * @param b		ChessBoard struct
+ * @return Score of the position, side to move point of view
+ * @note A known win is SCORE_KNOWN_WIN plus the evaluation of the winning side, the bare king
+ * pushed to the edge and the kings close, so the search make progress to the mat
+*/
+static s32 search_evaluate(ChessBoard *b) {
+	EndgameWDL	wdl = search_endgame_probe(b);
+	s8			winner = b->turn;
+	ChessTile	strong_king = INVALID_TILE, weak_king = INVALID_TILE;
+	s32			score = 0, file = 0, rank = 0;
+
+	if (wdl == WDL_UNKNOWN) {
+		return (evaluate(b));
+	} else if (wdl == WDL_DRAW) {
+		return (SCORE_DRAW);
+	}
+	if (wdl == WDL_LOSS) {
+		winner = !b->turn;
+	}
+	strong_king = get_tile_from_mask(b->piece[winner == IS_WHITE ? WHITE_KING : BLACK_KING]);
+	weak_king = get_tile_from_mask(b->piece[winner == IS_WHITE ? BLACK_KING : WHITE_KING]);
+	file = (weak_king & 7) < 4 ? 3 - (weak_king & 7) : (weak_king & 7) - 4;
+	rank = (weak_king / 8) < 4 ? 3 - (weak_king / 8) : (weak_king / 8) - 4;
+	score = (winner == b->turn ? evaluate(b) : -evaluate(b));
+	score += SCORE_KNOWN_WIN + 20 * (file > rank ? file : rank) + 10 * (7 - tile_distance(strong_king, weak_king));
+	return (wdl == WDL_WIN ? score : -score);
+}
+
+/* @brief Generate the legal moves, captures first
+ * @param b		ChessBoard struct
+ * @param out	Move array of at least MAX_MOVES
+ * @return Number of moves
+*/
+static s32 generate_ordered_moves(ChessBoard *b, Move *out) {
+	s32 count = generate_capture_moves(b, out);
+
+	return (count + generate_quiet_moves(b, out + count));
+}
+
+/* @brief Move a move to the front of the list if it's in the list
+ * @param moves	Move array
+ * @param count	Number of moves
+ * @param move	Move to search first
+*/
+static void move_to_front(Move *moves, s32 count, Move move) {
+	for (s32 i = 1; i < count && move != MOVE_NONE; i++) {
+		if (moves[i] == move) {
+			moves[i] = moves[0];
+			moves[0] = move;
+			return ;
+		}
+	}
+}
+
+/* @brief Store a quiet move that caused a beta cutoff
+ * @param t		SearchThread struct
+ * @param move	Quiet move, not played on the board
+ * @param depth	Depth left
+ * @param ply	Distance from the root
+*/
+static void update_quiet_cutoff(SearchThread *t, Move move, s32 depth, s32 ply) {
+	ChessPiece	type = t->board.mailbox[move_from(move)];
+	s32			*history = &t->history[type][move_to(move)];
+
+	if (t->killer[ply][0] != move) {
+		t->killer[ply][1] = t->killer[ply][0];
+		t->killer[ply][0] = move;
+	}
+	*history += depth * depth;
+	/* Keep the history scores bounded, halve the whole table on overflow */
+	if (*history > HISTORY_MAX) {
+		for (s32 p = 0; p < PIECE_MAX; p++) {
+			for (s32 tile = 0; tile < TILE_MAX; tile++) {
+				t->history[p][tile] /= 2;
+			}
+		}
+	}
+}
+
+/* @brief Quiescence search, only the captures are searched unless the side to move is in check
+ * @param t		SearchThread struct
+ * @param ply	Distance from the root
+ * @param alpha	Lower bound
+ * @param beta	Upper bound
+ * @return Score of the position, side to move point of view
+*/
+static s32 qsearch(SearchThread *t, s32 ply, s32 alpha, s32 beta) {
+	ChessBoard	*b = &t->board;
+	MovePicker	mp;
+	Move		move = MOVE_NONE;
+	Undo		undo;
+	s32			score = 0, played = 0;
+	s8			in_check = u8ValueGet(b->info, b->turn == IS_BLACK ? BLACK_CHECK : WHITE_CHECK);
+
+	t->nodes++;
+	if (search_should_stop(t)) {
+		return (0);
+	}
+	if (is_search_draw(b)) {
+		return (SCORE_DRAW);
+	}
+	if (ply >= MAX_PLY) {
+		return (search_evaluate(b));
+	}
+
+	/* In check all the evasions are searched, no stand pat */
+	if (in_check) {
+		move_picker_init(&mp, b, MOVE_NONE, NULL, NULL);
+	} else {
+		score = search_evaluate(b);
+		if (score >= beta) {
+			return (score);
+		}
+		if (score > alpha) {
+			alpha = score;
+		}
+		move_picker_init_capture(&mp, b);
+	}
+
+	while ((move = move_picker_next(&mp)) != MOVE_NONE) {
+		played++;
+		make_move(b, move, &undo);
+		score = -qsearch(t, ply + 1, -beta, -alpha);
+		unmake_move(b, move, &undo);
+		if (search_stopped(t->info)) {
+			return (0);
+		}
+		if (score >= beta) {
+			return (score);
+		}
+		if (score > alpha) {
+			alpha = score;
+		}
+	}
+	if (in_check && played == 0) {
+		return (-SCORE_MATE + ply);
+	}
+	return (alpha);
+}
+
+/* @brief Negamax alpha-beta search
+ * @param t		SearchThread struct
+ * @param depth	Depth left
+ * @param ply	Distance from the root
+ * @param alpha	Lower bound
+ * @param beta	Upper bound
+ * @return Score of the position, side to move point of view
+*/
+static s32 negamax(SearchThread *t, s32 depth, s32 ply, s32 alpha, s32 beta) {
+	ChessBoard			*b = &t->board;
+	TranspositionTable	*tt = t->info->tt;
+	MovePicker			mp;
+	Move				move = MOVE_NONE, best_move = MOVE_NONE;
+	Undo				undo;
+	TTData				tt_data;
+	s32					played = 0, score = 0, alpha_start = alpha;
+	s8					in_check = u8ValueGet(b->info, b->turn == IS_BLACK ? BLACK_CHECK : WHITE_CHECK);
+
+	if (depth <= 0 || ply >= MAX_PLY) {
+		return (qsearch(t, ply, alpha, beta));
+	}
+	t->nodes++;
+	if (search_should_stop(t)) {
+		return (0);
+	}
+	if (is_search_draw(b) || search_endgame_probe(b) == WDL_DRAW) {
+		return (SCORE_DRAW);
+	}
+
+	/* Transposition table cutoff */
+	tt_data.move = MOVE_NONE;
+	if (tt_probe(tt, b->hash_key, ply, &tt_data) && tt_data.depth >= depth) {
+		if (tt_data.bound == TT_BOUND_EXACT
+			|| (tt_data.bound == TT_BOUND_LOWER && tt_data.score >= beta)
+			|| (tt_data.bound == TT_BOUND_UPPER && tt_data.score <= alpha)) {
+			return (tt_data.score);
+		}
+	}
+
+	move_picker_init(&mp, b, tt_data.move, t->killer[ply], t->history);
+	while ((move = move_picker_next(&mp)) != MOVE_NONE) {
+		played++;
+		make_move(b, move, &undo);
+		score = -negamax(t, depth - 1, ply + 1, -beta, -alpha);
+		unmake_move(b, move, &undo);
+		if (search_stopped(t->info)) {
+			return (0);
+		}
+		if (score >= beta) {
+			if (!move_is_capture(move)) {
+				update_quiet_cutoff(t, move, depth, ply);
+			}
+			tt_store(tt, b->hash_key, ply, depth, TT_BOUND_LOWER, beta, move);
+			return (beta);
+		}
+		if (score > alpha) {
+			alpha = score;
+			best_move = move;
+		}
+	}
+	/* No legal move, mat or pat */
+	if (played == 0) {
+		return (in_check ? -SCORE_MATE + ply : SCORE_DRAW);
+	}
+	tt_store(tt, b->hash_key, ply, depth, alpha > alpha_start ? TT_BOUND_EXACT : TT_BOUND_UPPER, alpha, best_move);
+	return (alpha);
+}
+
+/* @brief Search the root moves at a given depth
+ * @param t			SearchThread struct
+ * @param moves		Root moves, the best move is moved first
+ * @param count		Number of root moves
+ * @param depth		Depth to search
+ * @return Score of the best move
+*/
+static s32 search_root(SearchThread *t, Move *moves, s32 count, s32 depth) {
+	ChessBoard	*b = &t->board;
+	Undo		undo;
+	Move		best = MOVE_NONE;
+	s32			alpha = -SCORE_INF, score = 0, best_idx = 0;
+
+	for (s32 i = 0; i < count; i++) {
+		make_move(b, moves[i], &undo);
+		score = -negamax(t, depth - 1, 1, -SCORE_INF, -alpha);
+		unmake_move(b, moves[i], &undo);
+		if (search_stopped(t->info)) {
+			break ;
+		}
+		if (score > alpha) {
+			alpha = score;
+			best_idx = i;
+		}
+	}
+
+	/* Search the best move first at the next depth */
+	best = moves[best_idx];
+	moves[best_idx] = moves[0];
+	moves[0] = best;
+	if (!search_stopped(t->info)) {
+		tt_store(t->info->tt, b->hash_key, 0, depth, TT_BOUND_EXACT, alpha, best);
+	}
+	return (alpha);
+}
+
+/* @brief Iterative deepening of one thread
+ * @param t		SearchThread struct, best_move, score and depth are filled
+*/
+static void search_iterate(SearchThread *t) {
+	Move	*moves = t->root_moves;
+	s32		count = t->root_count;
+	s32		score = 0, depth = 1, stable_depths = 0;
+	TTData	tt_data;
+
+	if (tt_probe(t->info->tt, t->board.hash_key, 0, &tt_data)) {
+		move_to_front(moves, count, tt_data.move);
+	}
+	/* Helpers start with another root move, odd helpers one depth deeper */
+	if (t->id > 0) {
+		move_to_front(moves, count, moves[t->id % count]);
+		depth += t->id & 1;
+	}
+
+	t->best_move = moves[0];
+	for (; depth <= t->info->max_depth; depth++) {
+		score = search_root(t, moves, count, depth);
+		if (search_stopped(t->info)) {
+			break ;
+		}
+		stable_depths = t->depth > 0 && moves[0] == t->best_move ? stable_depths + 1 : 0;
+		t->best_move = moves[0];
+		t->score = score;
+		t->depth = depth;
+		/* No need to search deeper once a mat is found */
+		if (IS_MATE_SCORE(score)) {
+			break ;
+		}
+		/* The main thread give up the next depth when the time is spent for this move */
+		if (t->id == 0 && time_manager_stop_depth(t->info, stable_depths)) {
+			break ;
+		}
+	}
+	/* The main thread is done, stop the helpers */
+	if (t->id == 0) {
+		search_stop(t->info);
+	}
+}
+
+/* @brief Helper thread entry point */
+static void *search_thread_routine(void *arg) {
+	search_iterate((SearchThread *)arg);
+	return (NULL);
+}
+
+/* @brief Keep the root moves that keep the result of a known endgame, the best DTZ moves with the tablebases
+ * @param b		ChessBoard struct, not modified
+ * @param moves	Root moves, filtered in place
+ * @param count	Number of root moves
+ * @return Number of moves kept, all the moves if the position isn't a known endgame or no move keep the result
+*/
+static s32 filter_endgame_root_moves(ChessBoard *b, Move *moves, s32 count) {
+	EndgameWDL	root = WDL_UNKNOWN;
+	EndgameWDL	child = WDL_UNKNOWN;
+	ChessBoard	tmp = *b;
+	Undo		undo;
+	s32			kept = syzygy_root_filter(&tmp, moves, count);
+	s8			mate = FALSE;
+
+	if (kept > 0) {
+		return (kept);
+	}
+	root = search_endgame_probe(b);
+	if (root != WDL_WIN && root != WDL_DRAW) {
+		return (count);
+	}
+	for (s32 i = 0; i < count; i++) {
+		make_move(&tmp, moves[i], &undo);
+		child = search_endgame_probe(&tmp);
+		mate = u8ValueGet(tmp.info, tmp.turn == IS_BLACK ? BLACK_CHECK : WHITE_CHECK) && !has_legal_move(&tmp, tmp.turn == IS_BLACK);
+		unmake_move(&tmp, moves[i], &undo);
+		/* The child result is for the opponent */
+		if (mate || child == WDL_LOSS || (root == WDL_DRAW && child == WDL_DRAW)) {
+			moves[kept++] = moves[i];
+		}
+	}
+	return (kept > 0 ? kept : count);
+}
+
+/* @brief Search the best move for the side to move
+ * @param b		ChessBoard struct, not modified
+ * @param info	SearchInfo struct, max_depth, time_limit_ms, soft_limit_ms, node_limit, threads and tt must be set,
+ *				stop must be FALSE, another thread can set it to abort the search
+ * @return The best move, MOVE_NONE if there is no legal move
+ * @note The result of the main thread is kept, unless a helper finished a deeper depth
+*/
+Move search_best_move(ChessBoard *b, SearchInfo *info) {
+	SearchThread	*threads = NULL;
+	SearchThread	*best = NULL;
+	Move			moves[MAX_MOVES];
+	s32				count = generate_ordered_moves(b, moves);
+	s32				thread_nb = info->threads, started = 1;
+
+	init_endgame_table();
+	count = filter_endgame_root_moves(b, moves, count);
+	info->best_move = count > 0 ? moves[0] : MOVE_NONE;
+	info->score = 0;
+	info->depth = 0;
+	info->nodes = 0;
+	info->node_count = 0;
+	info->start_ms = search_time_ms();
+	if (count <= 1) {
+		return (info->best_move);
+	}
+
+	if (thread_nb < 1) {
+		thread_nb = 1;
+	} else if (thread_nb > SEARCH_MAX_THREADS) {
+		thread_nb = SEARCH_MAX_THREADS;
+	}
+	threads = ft_calloc(thread_nb, sizeof(SearchThread));
+	if (!threads) {
+		CHESS_LOG(LOG_ERROR, "Search threads malloc failed\n");
+		return (info->best_move);
+	}
+	if (info->tt) {
+		tt_new_search(info->tt);
+	}
+	for (s32 i = 0; i < thread_nb; i++) {
+		threads[i].info = info;
+		threads[i].board = *b;
+		threads[i].id = i;
+		ft_memcpy(threads[i].root_moves, moves, count * sizeof(Move));
+		threads[i].root_count = count;
+	}
+
+	/* Start the helpers, the search continue with less threads if a thread can't start */
+	for (; started < thread_nb; started++) {
+		if (pthread_create(&threads[started].thread, NULL, search_thread_routine, &threads[started]) != 0) {
+			CHESS_LOG(LOG_ERROR, "Failed to start search thread %d\n", started);
+			break ;
+		}
+	}
+	search_iterate(&threads[0]);
+	for (s32 i = 1; i < started; i++) {
+		pthread_join(threads[i].thread, NULL);
+	}
+
+	best = &threads[0];
+	for (s32 i = 1; i < started; i++) {
+		if (threads[i].depth > best->depth && !IS_MATE_SCORE(best->score)) {
+			best = &threads[i];
+		}
+	}
+	for (s32 i = 0; i < started; i++) {
+		info->nodes += threads[i].nodes;
+	}
+	info->best_move = best->best_move;
+	info->score = best->score;
+	info->depth = best->depth;
+	free(threads);
+	return (info->best_move);
+}
@@ -1,177 +1,135 @@
 #include "../include/chess.h"
 #include "../include/chess_log.h"
-#include "../include/handle_sdl.h"
-#include "../include/network.h"
-#include "../include/FEN_notation.h"
-
 #include "../include/chess_bot.h"
 
-#define STOCKFISH_URL "https://stockfish.online/api/s/v2.php?fen="
-
-
-typedef enum {
-	LEVEL_EASY,
-	LEVEL_MEDIUM,
-	LEVEL_HARD,
-	LEVEL_EXPERT,
-} BotLevel;
-
-typedef struct s_bot_skill_level {
-	BotLevel	level;
-	char		*name;
-	u8			depth_min;
-	u8			depth_max;
-} BotSkillLevel;
-
-#define SKILL_LEVEL_ARRAY_SIZE 4
-
-#define SKILL_LVL_ARRAY { \
-	{LEVEL_EASY, "Easy", 1, 2}, \
-	{LEVEL_MEDIUM, "Medium", 3, 4}, \
-	{LEVEL_HARD, "Hard", 5, 7}, \
-	{LEVEL_EXPERT, "Expert", 8, 12} \
-}
-
-u8 get_random_depth(u8 min_depth, u8 max_depth) {
-	return (rand() % (max_depth - min_depth + 1) + min_depth);
-}
-
-
-ChessTile str_to_chesstile(char *str) {
-    char file = str[0]; // 'a' to 'h'
-    char rank = str[1]; // '1' to '8'
-
-    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') {
-        fprintf(stderr, "Invalid chess tile string: %s\n", str);
-        exit(EXIT_FAILURE);
-    }
+#include <curl/curl.h>
+
+/*
+ * Remote engine client (stockfish.online API or any endpoint with the same answer).
+ * The requests run on a curl multi handle, the main loop call stockfish_poll each frame
+ * and the transfers move forward without blocking. The easy handles are kept in a pool and
+ * reused, the multi handle keep the connections alive between the requests.
+ * The answers are kept in a LRU cache indexed by position (FEN without the move counters)
+ * and depth, a cached position is answered without any request.
+*/
+
+/* Request slot state */
+#define HTTP_SLOT_FREE		0
+#define HTTP_SLOT_RUNNING	1
+#define HTTP_SLOT_DONE		2
+
+typedef struct s_http_slot {
+	CURL		*easy;				/* Easy handle, kept between the requests */
+	s8			state;				/* HTTP_SLOT_FREE, RUNNING or DONE */
+	u32			id;					/* Request id */
+	char		*url;				/* Request URL, must live until the transfer is done */
+	char		*body;				/* Response body, grown by the write callback */
+	u32			body_len;			/* Body length */
+	u32			body_size;			/* Body allocated size */
+	char		*key;				/* Cache key, position part of the FEN */
+	u8			depth;				/* Requested depth */
+	u64			start_ms;			/* Request start time */
+	StockfishResult	result;			/* Result, valid when the slot is done */
+} HttpSlot;
+
+typedef struct s_http_cache_entry {
+	char		*key;				/* Position part of the FEN, NULL for an empty entry */
+	u64			hash;				/* Key hash, compared before the key */
+	u8			depth;				/* Requested depth */
+	char		move[UCI_MOVE_SIZE];/* Best move */
+	u64			last_use;			/* Use tick, the lowest is evicted */
+} HttpCacheEntry;
+
+typedef struct s_stockfish_client {
+	CURLM			*multi;						/* Multi handle, NULL before the init */
+	char			*url;						/* URL prefix, the FEN is appended */
+	HttpSlot		slot[STOCKFISH_POOL_SIZE];	/* Request pool */
+	HttpCacheEntry	cache[STOCKFISH_CACHE_SIZE];/* Answer cache */
+	u64				tick;						/* Cache use counter */
+	u32				last_id;					/* Id of the last request */
+} StockfishClient;
+
+static StockfishClient client;
 
-    int file_index = file - 'a'; // 0 to 7
-    int rank_index = rank - '1'; // 0 to 7
-
-    return (ChessTile)(rank_index * 8 + file_index);
-}
+/**
+ * @brief Get the position part of a FEN (board, turn, castle, en passant), the move counters are not part of the position
+ * @param fen The FEN string
+ * @return The allocated key
+ */
+static char *fen_position_key(const char *fen) {
+	u32		len = 0, field = 0;
+	char	*key = NULL;
 
-typedef struct s_move_struct {
-	ChessTile	from;
-	ChessTile	to;
-	char		promotion_piece;
-} MoveStruct;
-
-char *get_keyword_line(char **split_comma, char *keyword) {
-	
-	
-	for (int i = 0; split_comma[i]; i++) {
-		if (ft_strncmp(split_comma[i], keyword, ft_strlen(keyword)) == 0) {
-			return (ft_strdup(split_comma[i]));
-		}
+	while (fen[len] && !(fen[len] == ' ' && ++field == 4)) {
+		len++;
 	}
-	return (NULL);
+	if ((key = malloc(len + 1))) {
+		ft_memcpy(key, fen, len);
+		key[len] = '\0';
+	}
+	return (key);
 }
 
-s8 verify_request_status(char **split_comma) {
-	int success_len = ft_strlen("\"success\"");
+/**
+ * @brief FNV-1a hash of a cache key
+ */
+static u64 cache_hash(const char *key, u8 depth) {
+	u64 hash = 0xCBF29CE484222325ULL ^ depth;
 
-	for (int i = 0; split_comma[i]; i++) {
-		if (ft_strncmp(split_comma[i], "\"success\"", success_len) == 0) {
-			/* Chess + success_len + 1 for the double dot */
-			if (ft_strncmp(split_comma[i] + success_len + 1, "true", ft_strlen("true")) != 0) {
-				CHESS_LOG(LOG_ERROR, "Failed to get the move, request fail\n");
-				return (FALSE);
-			}
-		}
+	for (u32 i = 0; key[i]; i++) {
+		hash = (hash ^ (u8)key[i]) * 0x100000001B3ULL;
 	}
-	return (TRUE);
+	return (hash);
 }
 
-void extract_move_from_str(char *move_str, MoveStruct *move) {
-	char move_from[3] = {0};
-	char move_to[3] = {0};
-	int move_str_len = ft_strlen(move_str);
-	if (move_str_len < 4) {
-		CHESS_LOG(LOG_ERROR, "Incomplete move string\n");
-		return ;
-	} else if (move_str_len == 5) {
-		move->promotion_piece = move_str[4];
+/**
+ * @brief Find a cached answer, the entry become the most recently used
+ * @param key The position key
+ * @param depth The depth
+ * @return The entry, NULL if the position isn't cached
+ */
+static HttpCacheEntry *cache_find(const char *key, u8 depth) {
+	u64 hash = cache_hash(key, depth);
+
+	for (u32 i = 0; i < STOCKFISH_CACHE_SIZE; i++) {
+		HttpCacheEntry *entry = &client.cache[i];
+		if (entry->key && entry->hash == hash && entry->depth == depth && ft_strncmp(entry->key, key, ft_strlen(key) + 1) == 0) {
+			entry->last_use = ++client.tick;
+			return (entry);
+		}
 	}
-	ft_memcpy(move_from, move_str, 2);
-	ft_memcpy(move_to, move_str + 2, 2);
-	move->from = str_to_chesstile(move_from);
-	move->to = str_to_chesstile(move_to);
-	CHESS_LOG(LOG_INFO, "Receive: from: %s, to: %s\n", ChessTile_to_str(move->from), ChessTile_to_str(move->to));
+	return (NULL);
 }
 
 /**
- * @brief Get the move from the Stockfish response
- * @param response The response from Stockfish
- * @return The move
+ * @brief Store an answer, the least recently used entry is replaced
+ * @param key The position key, copied
+ * @param depth The depth
+ * @param move The best move
  */
-MoveStruct get_move_from_response(char *response) {
-	MoveStruct move = {INVALID_TILE, INVALID_TILE, EMPTY};
-
-	/* Split the response by comma to get field line */
-	char **split_comma = ft_split(response, ',');
-	if (!split_comma) {
-		CHESS_LOG(LOG_ERROR, "Failed to split the response\n");
-		return (move);
-	}
+static void cache_store(const char *key, u8 depth, const char *move) {
+	HttpCacheEntry	*entry = cache_find(key, depth);
+	char			*key_copy = NULL;
 
-	/* Verify the request status (success field) */
-	if (!verify_request_status(split_comma)) {
-		goto free_coma_split;
-	}
-
-	/* Get the best move line */
-	char *best_move_line = get_keyword_line(split_comma, "\"bestmove\"");
-	if (!best_move_line) {
-		CHESS_LOG(LOG_ERROR, "Failed to find the best move line\n");
-		goto free_coma_split;
-	}
-
-	CHESS_LOG(LOG_INFO, "Best move line: %s\n", best_move_line);
-
-	/* Split the best move line by double dot to gey, keyword + value */
-	char **split_double_dot = ft_split(best_move_line, ':');
-	if (!split_double_dot) {
-		CHESS_LOG(LOG_ERROR, "Failed to split the best move line\n");
-		goto free_best_move_line;
-	}
-
-	/* Check if the split is not empty and contain keyword + value */
-	if (double_char_size(split_double_dot) < 2) {
-		CHESS_LOG(LOG_ERROR, "Failed to find the best move\n");
-		goto free_split_double_dot;
-	}
-
-	/* Split the value by space to get the move */
-	char **split_space = ft_split(split_double_dot[1], ' ');
-	if (!split_space) {
-		CHESS_LOG(LOG_ERROR, "Failed to split the best move\n");
-		goto free_split_double_dot;
-	}
-
-	/* Check if the split is not empty and contain the move */
-	if (double_char_size(split_space) < 2) {
-		CHESS_LOG(LOG_ERROR, "Failed to find the best move string\n");
-		goto free_split_space;
+	if (!entry) {
+		if (!(key_copy = ft_strdup(key))) {
+			return ;
+		}
+		entry = &client.cache[0];
+		for (u32 i = 1; i < STOCKFISH_CACHE_SIZE && entry->key; i++) {
+			if (!client.cache[i].key || client.cache[i].last_use < entry->last_use) {
+				entry = &client.cache[i];
+			}
+		}
+		free(entry->key);
+		entry->key = key_copy;
+		entry->hash = cache_hash(key, depth);
+		entry->depth = depth;
+		entry->last_use = ++client.tick;
 	}
-
-	/* Extract the move from the split space string */
-	extract_move_from_str(split_space[1], &move);
-
-	free_split_space:
-		free_double_char(split_space);
-	free_split_double_dot:
-		free_double_char(split_double_dot);
-	free_best_move_line:
-		free(best_move_line);
-	free_coma_split:
-		free_double_char(split_comma);
-
-	return (move);
+	ft_memcpy(entry->move, move, UCI_MOVE_SIZE);
 }
 
-
 /**
  * @brief Replace a character by a string
  * @param str The string to replace character
@@ -203,14 +161,15 @@ char *replace_char_by_str(char *str, char to_replace, char *replace_with, s8 las
 
 /**
  * @brief Build the Stockfish request URL
+ * @param url The URL prefix, the FEN is appended
  * @param fen_str The FEN string
  * @param depth The depth of the search
  * @return The URL
  */
-char *build_stockfish_request(char *fen_str, int depth) {
+char *build_stockfish_request(char *url, char *fen_str, int depth) {
 	char *encode_fen = replace_char_by_str(fen_str, ' ', "%20", FALSE);
 
-	char *url = ft_strjoin_free(STOCKFISH_URL, encode_fen, 's');
+	url = ft_strjoin_free(url, encode_fen, 's');
 
 	url = ft_strjoin_free(url, "&depth=", 'f');
 	url = ft_strjoin_free(url, ft_itoa(depth), 'a');
@@ -221,67 +180,284 @@ char *build_stockfish_request(char *fen_str, int depth) {
 }
 
 /**
- * @brief Write callback for libcurl
+ * @brief Write callback for libcurl, the data is appended to the slot body
  * @param ptr The pointer to the data
  * @param size The size of the data
  * @param nmemb The number of members
- * @param userdata The user data
- * @return The total size
+ * @param userdata The HttpSlot pointer
+ * @return The total size, 0 to abort the transfer on malloc failure
  */
 size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userdata) {
-    size_t total_size = size * nmemb;
-    ft_memcpy(userdata, ptr, total_size);
-    return total_size;
+	HttpSlot	*slot = userdata;
+	size_t		total_size = size * nmemb;
+	u32			new_size = slot->body_size ? slot->body_size : STOCKFISH_BODY_SIZE;
+	char		*tmp = NULL;
+
+	if (slot->body_len + total_size + 1 > STOCKFISH_BODY_MAX) {
+		CHESS_LOG(LOG_ERROR, "Stockfish response too big\n");
+		return (0);
+	}
+	while (slot->body_len + total_size + 1 > new_size) {
+		new_size *= 2;
+	}
+	if (new_size != slot->body_size) {
+		if (!(tmp = realloc(slot->body, new_size))) {
+			return (0);
+		}
+		slot->body = tmp;
+		slot->body_size = new_size;
+	}
+	ft_memcpy(slot->body + slot->body_len, ptr, total_size);
+	slot->body_len += total_size;
+	slot->body[slot->body_len] = '\0';
+	return (total_size);
 }
 
+/**
+ * @brief Get the best move from the Stockfish response
+ * @param response The response body, JSON: {"success":true, ..., "bestmove":"bestmove e2e4 ponder e7e5", ...}
+ * @param move The UCI move, empty string on failure
+ * @return TRUE if the move is found, FALSE otherwise
+ */
+static s8 get_move_from_response(const char *response, char *move) {
+	const char	*best = NULL;
+	u32			len = 0;
+
+	move[0] = '\0';
+	if (!strstr(response, "\"success\":true")) {
+		CHESS_LOG(LOG_ERROR, "Failed to get the move, request fail\n");
+		return (FALSE);
+	}
+	if (!(best = strstr(response, "\"bestmove\":\"bestmove "))) {
+		CHESS_LOG(LOG_ERROR, "Failed to find the best move\n");
+		return (FALSE);
+	}
+	best += ft_strlen("\"bestmove\":\"bestmove ");
+	while (len < UCI_MOVE_SIZE - 1 && best[len] && best[len] != ' ' && best[len] != '"') {
+		len++;
+	}
+	if (len < 4) {
+		CHESS_LOG(LOG_ERROR, "Incomplete move string\n");
+		return (FALSE);
+	}
+	ft_memcpy(move, best, len);
+	move[len] = '\0';
+	return (TRUE);
+}
 
 /**
- * @brief Send the FEN string to the Stockfish API
- * @param fen_str The FEN string
+ * @brief Init the client, only the first call init it
+ * @return TRUE if the client is ready, FALSE otherwise
  */
-void send_stockfish_fen(char *fen_str) {
-	CURL *curl = NULL;
-    CURLcode res = 0;
+static s8 stockfish_client_init() {
 	char *url = NULL;
-	// Create a buffer to store the response data
-	char response_data[4096];
-	ft_bzero(response_data, 4096);
 
-	url = build_stockfish_request(fen_str, get_random_depth(1, 2));
-	if (!url) {
-		CHESS_LOG(LOG_ERROR, "Failed to build the URL\n");
-		return ;
+	if (client.multi) {
+		return (TRUE);
 	}
+	if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK || !(client.multi = curl_multi_init())) {
+		CHESS_LOG(LOG_ERROR, "Failed to init libcurl\n");
+		return (FALSE);
+	}
+	/* Keep one open connection for each slot */
+	curl_multi_setopt(client.multi, CURLMOPT_MAXCONNECTS, (long)STOCKFISH_POOL_SIZE);
+	url = getenv(STOCKFISH_URL_ENV);
+	client.url = ft_strdup(url && url[0] ? url : STOCKFISH_URL);
+	return (client.url != NULL);
+}
 
-    // Initialize libcurl
-    curl = curl_easy_init();
-    if(curl) {
-        // Set the URL with FEN and depth parameters
-        curl_easy_setopt(curl, CURLOPT_URL, url);
+/**
+ * @brief Get a free slot, the easy handle is created on the first use
+ * @return The slot, NULL if all the slots are used
+ */
+static HttpSlot *get_free_slot() {
+	for (u32 i = 0; i < STOCKFISH_POOL_SIZE; i++) {
+		HttpSlot *slot = &client.slot[i];
+		if (slot->state != HTTP_SLOT_FREE) {
+			continue ;
+		}
+		if (!slot->easy && !(slot->easy = curl_easy_init())) {
+			return (NULL);
+		}
+		return (slot);
+	}
+	return (NULL);
+}
 
-		curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+/**
+ * @brief Clear the request data of a slot, the easy handle and the body buffer are kept
+ */
+static void slot_reset(HttpSlot *slot) {
+	free(slot->url);
+	free(slot->key);
+	slot->url = NULL;
+	slot->key = NULL;
+	slot->body_len = 0;
+	slot->state = HTTP_SLOT_FREE;
+}
 
-		curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_data);
+/**
+ * @brief Ask the best move of a position, never block
+ * @param fen_str The FEN string
+ * @param depth The depth of the search
+ * @return The request id, the result is read with stockfish_poll, 0 on failure (all the slots are used)
+ */
+u32 send_stockfish_fen(char *fen_str, u8 depth) {
+	HttpSlot		*slot = NULL;
+	HttpCacheEntry	*entry = NULL;
 
-		#ifdef CHESS_WINDOWS_VERSION
-			curl_easy_setopt(curl, CURLOPT_CAINFO, "./rsc/curl-ca-bundle.crt");
-		#endif
+	if (!stockfish_client_init() || !(slot = get_free_slot())) {
+		CHESS_LOG(LOG_ERROR, "No Stockfish request slot\n");
+		return (0);
+	}
+	ft_bzero(&slot->result, sizeof(StockfishResult));
+	slot->id = ++client.last_id;
+	slot->result.id = slot->id;
+	slot->depth = depth;
+	slot->start_ms = search_time_ms();
+	if (!(slot->key = fen_position_key(fen_str))) {
+		return (0);
+	}
+
+	/* Cached position, the result is given by the next poll */
+	if ((entry = cache_find(slot->key, depth))) {
+		ft_memcpy(slot->result.move, entry->move, UCI_MOVE_SIZE);
+		slot->result.from_cache = TRUE;
+		slot->state = HTTP_SLOT_DONE;
+		return (slot->id);
+	}
+
+	if (!(slot->url = build_stockfish_request(client.url, fen_str, depth))) {
+		slot_reset(slot);
+		return (0);
+	}
+	/* The options set here are kept, the connection of the handle is reused */
+	curl_easy_setopt(slot->easy, CURLOPT_URL, slot->url);
+	curl_easy_setopt(slot->easy, CURLOPT_WRITEFUNCTION, write_callback);
+	curl_easy_setopt(slot->easy, CURLOPT_WRITEDATA, slot);
+	curl_easy_setopt(slot->easy, CURLOPT_TIMEOUT_MS, (long)STOCKFISH_TIMEOUT_MS);
+	curl_easy_setopt(slot->easy, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(slot->easy, CURLOPT_NOSIGNAL, 1L);
+	#ifdef CHESS_WINDOWS_VERSION
+		curl_easy_setopt(slot->easy, CURLOPT_CAINFO, "./rsc/curl-ca-bundle.crt");
+	#endif
+	if (curl_multi_add_handle(client.multi, slot->easy) != CURLM_OK) {
+		CHESS_LOG(LOG_ERROR, "Failed to start the Stockfish request\n");
+		slot_reset(slot);
+		return (0);
+	}
+	slot->state = HTTP_SLOT_RUNNING;
+	return (slot->id);
+}
+
+/**
+ * @brief Read the finished transfers and fill the slot results
+ */
+static void stockfish_read_done() {
+	CURLMsg		*msg = NULL;
+	HttpSlot	*slot = NULL;
+	long		status = 0, connects = 0;
+	s32			left = 0;
+
+	while ((msg = curl_multi_info_read(client.multi, &left))) {
+		if (msg->msg != CURLMSG_DONE) {
+			continue ;
+		}
+		slot = NULL;
+		for (u32 i = 0; !slot && i < STOCKFISH_POOL_SIZE; i++) {
+			slot = client.slot[i].easy == msg->easy_handle ? &client.slot[i] : NULL;
+		}
+		curl_multi_remove_handle(client.multi, msg->easy_handle);
+		if (!slot) {
+			continue ;
+		}
+		curl_easy_getinfo(slot->easy, CURLINFO_RESPONSE_CODE, &status);
+		curl_easy_getinfo(slot->easy, CURLINFO_NUM_CONNECTS, &connects);
+		slot->result.new_connections = (u32)connects;
+		if (msg->data.result != CURLE_OK) {
+			CHESS_LOG(LOG_ERROR, "Stockfish request failed: %s\n", curl_easy_strerror(msg->data.result));
+		} else if (status != 200) {
+			CHESS_LOG(LOG_ERROR, "Stockfish request failed: HTTP %ld\n", status);
+		} else if (slot->body && get_move_from_response(slot->body, slot->result.move)) {
+			cache_store(slot->key, slot->depth, slot->result.move);
+		}
+		slot->state = HTTP_SLOT_DONE;
+	}
+}
 
+/**
+ * @brief Move the requests forward and get a finished one, never block
+ * @param out The result, filled if a request is done
+ * @return TRUE if a result is given, FALSE otherwise
+ * @note A failed request give an empty move
+ */
+s8 stockfish_poll(StockfishResult *out) {
+	HttpSlot	*done = NULL;
+	s32			running = 0;
 
-        // Perform the request, res will get the return code
-        res = curl_easy_perform(curl);
+	if (!client.multi) {
+		return (FALSE);
+	}
+	curl_multi_perform(client.multi, &running);
+	stockfish_read_done();
+	/* Oldest finished request first */
+	for (u32 i = 0; i < STOCKFISH_POOL_SIZE; i++) {
+		if (client.slot[i].state == HTTP_SLOT_DONE && (!done || client.slot[i].id < done->id)) {
+			done = &client.slot[i];
+		}
+	}
+	if (!done) {
+		return (FALSE);
+	}
+	*out = done->result;
+	out->time_ms = search_time_ms() - done->start_ms;
+	CHESS_LOG(LOG_INFO, "Stockfish move |%s| in %llu ms%s\n", out->move, (unsigned long long)out->time_ms, out->from_cache ? " (cache)" : "");
+	slot_reset(done);
+	return (TRUE);
+}
 
-        // Check for errors
-        if(res != CURLE_OK) {
-            CHESS_LOG(LOG_INFO, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
-		} else {
-			CHESS_LOG(LOG_INFO, "Response: %s\n", response_data);
-			MoveStruct move = get_move_from_response(response_data);
-			(void)move;
+/**
+ * @brief Cancel the running requests, their result is never given
+ */
+void stockfish_cancel() {
+	for (u32 i = 0; i < STOCKFISH_POOL_SIZE; i++) {
+		if (client.slot[i].state == HTTP_SLOT_RUNNING) {
+			curl_multi_remove_handle(client.multi, client.slot[i].easy);
 		}
+		if (client.slot[i].state != HTTP_SLOT_FREE) {
+			slot_reset(&client.slot[i]);
+		}
+	}
+}
+
+/**
+ * @brief Check if the remote engine is used by the bot, C_CHESS_STOCKFISH_URL is set
+ */
+s8 stockfish_enabled() {
+	char *url = getenv(STOCKFISH_URL_ENV);
+
+	return (url && url[0]);
+}
 
-        // Libcurl cleanup
-        curl_easy_cleanup(curl);
-    }
-	free(url);
+/**
+ * @brief Free the client, the connections are closed
+ */
+void stockfish_client_destroy() {
+	if (!client.multi) {
+		return ;
+	}
+	stockfish_cancel();
+	for (u32 i = 0; i < STOCKFISH_POOL_SIZE; i++) {
+		if (client.slot[i].easy) {
+			curl_easy_cleanup(client.slot[i].easy);
+		}
+		free(client.slot[i].body);
+	}
+	for (u32 i = 0; i < STOCKFISH_CACHE_SIZE; i++) {
+		free(client.cache[i].key);
+	}
+	curl_multi_cleanup(client.multi);
+	curl_global_cleanup();
+	free(client.url);
+	ft_bzero(&client, sizeof(StockfishClient));
 }
@@ -0,0 +1,1362 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+
+#include <pthread.h>
+
+#ifdef CHESS_WINDOWS_VERSION
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+/*
+ * Syzygy tablebases probe, WDL (win, draw, loss) and DTZ (distance to the next capture or pawn move).
+ * syzygy_init register the tables found in a directory, up to SYZYGY_MAX_PIECES pieces, a table file
+ * is memory mapped on its first probe. The file layout, the position index and the decompression
+ * (canonical Huffman codes of recursive symbol pairs) are the ones of the Syzygy probing code
+ * (Stockfish tbprobe, Fathom).
+ * The tables ignore the castle rights, the 'en passant' captures and the 50 moves counter:
+ * - a position with a castle right is never probed
+ * - the captures are searched before the table probe, the 'en passant' capture is one of them
+ * - a cursed win (blessed loss) is a draw with the 50 moves rule, a win or a loss is only
+ *   certain right after a capture or a pawn move (halfmove count 0), a draw is always certain.
+ * At the root the DTZ ranks the moves: the winning side play the shortest path to the next
+ * capture or pawn move, the losing side the longest one.
+*/
+
+/* Table file type */
+#define SYZYGY_WDL				0
+#define SYZYGY_DTZ				1
+
+#define SYZYGY_NAME_SIZE		16			/* "KRPPvKR" + ".rtbw" + '\0' */
+#define SYZYGY_HASH_SIZE		4096		/* Material key slots, power of two */
+#define SYZYGY_MAX_SYM_LEN		32			/* Max Huffman code length, a 64 bits buffer is refilled by 32 bits */
+#define SYZYGY_MAX_DTZ			(1 << 18)	/* Root rank of a sure win */
+
+/* Table value, side to move point of view */
+#define TB_LOSS					-2
+#define TB_BLESSED_LOSS			-1
+#define TB_DRAW					0
+#define TB_CURSED_WIN			1
+#define TB_WIN					2
+
+/* Probe state */
+#define PROBE_FAIL				0			/* No table or corrupted table */
+#define PROBE_OK				1
+#define PROBE_CHANGE_STM		-1			/* The DTZ table store the other side to move */
+#define PROBE_ZEROING_BEST_MOVE	2			/* The best move is a capture or a pawn move */
+
+/* Flags of the table files header */
+#define FILE_FLAG_SPLIT			1			/* WDL table of both sides to move */
+#define FILE_FLAG_HAS_PAWNS		2
+
+/* Flags of a table part */
+#define PAIRS_FLAG_STM			1			/* DTZ side to move, black if set */
+#define PAIRS_FLAG_MAPPED		2			/* DTZ values are indexes in the value map */
+#define PAIRS_FLAG_WIN_PLIES	4			/* DTZ of the wins in plies, in moves otherwise */
+#define PAIRS_FLAG_LOSS_PLIES	8			/* DTZ of the losses in plies, in moves otherwise */
+#define PAIRS_FLAG_WIDE			16			/* DTZ value map of 16 bits values */
+#define PAIRS_FLAG_SINGLE_VALUE	128			/* All the positions have the same value */
+
+/* Compressed values of a table part, by side to move and leading pawn file */
+typedef struct s_syzygy_pairs {
+	const u8	*data;							/* Blocks of Huffman codes */
+	const u8	*sparse_index;					/* Entries of 6 bytes: block (32 bits) and offset in the block (16 bits) */
+	const u8	*block_length;					/* Number of values - 1 of each block (16 bits) */
+	const u8	*lowest_sym;					/* Lowest symbol of each code length (16 bits) */
+	const u8	*btree;							/* Symbol pairs, 12 bits left and right symbols */
+	u8			*symlen;						/* Number of values - 1 of each symbol */
+	u64			base64[SYZYGY_MAX_SYM_LEN];		/* Lowest code of each length, left aligned */
+	u64			block_size;						/* Block size in bytes */
+	u64			span;							/* Number of values between two sparse index entries */
+	u64			sparse_index_size;				/* Number of sparse index entries */
+	u64			blocks_num;						/* Number of blocks */
+	u64			block_length_size;				/* Number of block length entries, padded */
+	u64			group_idx[SYZYGY_MAX_PIECES + 1];	/* Index factor of each piece group, the last one is the table size */
+	s32			group_len[SYZYGY_MAX_PIECES + 1];	/* Number of pieces of each group, 0 terminated */
+	u16			map_idx[4];						/* DTZ value map offsets of the win, loss, cursed win and blessed loss */
+	u8			pieces[SYZYGY_MAX_PIECES];		/* Piece order of the index, Syzygy piece codes */
+	u8			flags;
+	u8			min_sym_len;					/* The single value with PAIRS_FLAG_SINGLE_VALUE */
+	u8			max_sym_len;
+} SyzygyPairs;
+
+/* Mapped table file */
+typedef struct s_syzygy_file {
+	const u8	*data;			/* Mapped file, NULL if the map failed */
+	u64			size;			/* Mapped size in bytes */
+	s8			ready;			/* TRUE once the map is tried, atomic */
+#ifdef CHESS_WINDOWS_VERSION
+	void		*file;			/* File handle */
+	void		*mapping;		/* File mapping handle */
+#endif
+} SyzygyFile;
+
+typedef struct s_syzygy_table {
+	char		name[SYZYGY_NAME_SIZE];		/* Material, strong side first: "KRPvKR" */
+	u64			key;						/* Material key, the strong side is white */
+	u64			key2;						/* Material key, the strong side is black */
+	s8			piece_count;
+	s8			has_pawns;
+	s8			has_unique_pieces;			/* A side has a single piece of a kind (kings excluded) */
+	s8			pawn_count[2];				/* Pawns of the leading color, pawns of the other color */
+	SyzygyFile	file[2];					/* WDL and DTZ files */
+	SyzygyPairs	wdl[2][4];					/* By side to move and leading pawn file */
+	SyzygyPairs	dtz[4];						/* By leading pawn file, one side to move */
+	const u8	*dtz_map;					/* DTZ value map */
+} SyzygyTable;
+
+typedef struct s_syzygy_entry {
+	u64			key;		/* Material key, 0 for an empty slot */
+	s32			table;		/* Index in the tables array */
+} SyzygyEntry;
+
+typedef struct s_syzygy {
+	char		*path;							/* Tablebase directory */
+	SyzygyTable	*tables;						/* Tables with a WDL file */
+	s32			count;							/* Number of tables */
+	s32			capacity;						/* Allocated tables */
+	s32			max_pieces;						/* Pieces of the largest table, 0 without table */
+	SyzygyEntry	hash[SYZYGY_HASH_SIZE];			/* Both material keys of each table */
+} Syzygy;
+
+static Syzygy tb;
+
+/* Serialize the first map of the table files, the search threads probe concurrently */
+static pthread_mutex_t tb_map_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Index encoding tables, filled by syzygy_init_index */
+static s32 map_b1h1h7[TILE_MAX];			/* Tile below the A1-H8 diagonal to 0..27 */
+static s32 map_a1d1d4[TILE_MAX];			/* Tile of the A1-D1-D4 triangle to 0..9, diagonal last */
+static s32 map_kk[10][TILE_MAX];			/* Both kings to 0..461, first king in the A1-D1-D4 triangle */
+static s32 map_pawns[TILE_MAX];				/* Pawn tile A2-H7 to 0..47, the leading pawn has the highest value */
+static u64 binomial[6][TILE_MAX];			/* Ways to choose k elements from n */
+static u64 lead_pawn_idx[6][TILE_MAX];		/* Index of the leading pawns group by its first pawn */
+static u64 lead_pawns_size[6][4];			/* Size of the leading pawns group by file */
+
+/* Piece letters of the table names, pawn to king */
+static const char tb_piece_char[] = "PNBRQK";
+
+FT_INLINE u16 read_le16(const u8 *p) {
+	return ((u16)(p[0] | (p[1] << 8)));
+}
+
+FT_INLINE u32 read_le32(const u8 *p) {
+	return ((u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24));
+}
+
+FT_INLINE u32 read_be32(const u8 *p) {
+	return (((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3]);
+}
+
+FT_INLINE u64 read_be64(const u8 *p) {
+	return (((u64)read_be32(p) << 32) | read_be32(p + 4));
+}
+
+/* @brief Rank minus file of a tile, 0 on the A1-H8 diagonal, negative below */
+FT_INLINE s32 off_a1h8(ChessTile tile) {
+	return ((tile >> 3) - (tile & 7));
+}
+
+/* @brief Left symbol of a pair, the value of a leaf symbol */
+FT_INLINE u32 btree_left(const SyzygyPairs *d, u32 sym) {
+	const u8 *lr = d->btree + 3 * sym;
+
+	return (((lr[1] & 0xF) << 8) | lr[0]);
+}
+
+/* @brief Right symbol of a pair, 0xFFF for a leaf symbol */
+FT_INLINE u32 btree_right(const SyzygyPairs *d, u32 sym) {
+	const u8 *lr = d->btree + 3 * sym;
+
+	return ((lr[2] << 4) | (lr[1] >> 4));
+}
+
+/* @brief Get the Syzygy piece code of a piece: pawn 1 to king 6, +8 for black */
+FT_INLINE u8 syzygy_piece_code(ChessPiece piece) {
+	return (piece >= BLACK_PAWN ? (piece - BLACK_PAWN + 1) | 8 : piece + 1);
+}
+
+/* @brief Get a table part
+ * @param t		SyzygyTable struct
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @param stm	Side to move of the table, the DTZ store only one
+ * @param file	Leading pawn file (0..3), 0 without pawn
+*/
+static SyzygyPairs *syzygy_pairs(SyzygyTable *t, s32 type, s32 stm, s32 file) {
+	file = t->has_pawns ? file : 0;
+	if (type == SYZYGY_DTZ) {
+		return (&t->dtz[file]);
+	}
+	return (&t->wdl[t->key != t->key2 ? stm : 0][file]);
+}
+
+/* @brief Compute the material key of piece counts
+ * @param white	Number of pawn, knight, bishop, rook and queen of white
+ * @param black	Same for black
+*/
+static u64 syzygy_count_key(const s32 *white, const s32 *black) {
+	u64 key = 0;
+
+	for (s32 type = 0; type < 5; type++) {
+		key |= (u64)white[type] << (4 * type);
+		key |= (u64)black[type] << (4 * type + 32);
+	}
+	return (key);
+}
+
+/* @brief Compute the material key of a board */
+static u64 syzygy_board_key(ChessBoard *b) {
+	s32 white[5], black[5];
+
+	for (s32 type = 0; type < 5; type++) {
+		white[type] = bitboard_count(b->piece[WHITE_PAWN + type]);
+		black[type] = bitboard_count(b->piece[BLACK_PAWN + type]);
+	}
+	return (syzygy_count_key(white, black));
+}
+
+/* @brief Hash slot of a material key */
+FT_INLINE u32 syzygy_hash_slot(u64 key) {
+	return ((u32)((key * 0x9E3779B97F4A7C15ULL) >> 52) & (SYZYGY_HASH_SIZE - 1));
+}
+
+/* @brief Find the table of a material key
+ * @return The table, NULL if no table was found for this material
+*/
+static SyzygyTable *syzygy_find(u64 key) {
+	u32 slot = syzygy_hash_slot(key);
+
+	while (tb.hash[slot].key) {
+		if (tb.hash[slot].key == key) {
+			return (&tb.tables[tb.hash[slot].table]);
+		}
+		slot = (slot + 1) & (SYZYGY_HASH_SIZE - 1);
+	}
+	return (NULL);
+}
+
+/* @brief Insert a material key in the hash table */
+static void syzygy_hash_insert(u64 key, s32 table) {
+	u32 slot = syzygy_hash_slot(key);
+
+	while (tb.hash[slot].key && tb.hash[slot].key != key) {
+		slot = (slot + 1) & (SYZYGY_HASH_SIZE - 1);
+	}
+	tb.hash[slot].key = key;
+	tb.hash[slot].table = table;
+}
+
+/* @brief Fill the index encoding tables */
+static void syzygy_init_index() {
+	s32			code = 0, available = 47, idx = 0;
+	s32			diagonal[4], diagonal_count = 0;
+	s32			both_on_diagonal[64][2], both_count = 0;
+	ChessTile	tile = INVALID_TILE;
+
+	for (ChessTile t = 0; t < TILE_MAX; t++) {
+		if (off_a1h8(t) < 0) {
+			map_b1h1h7[t] = code++;
+		}
+	}
+	/* A1-D1-D4 triangle, the tiles below the diagonal then the diagonal tiles */
+	code = 0;
+	for (ChessTile t = 0; t <= D4; t++) {
+		if (off_a1h8(t) < 0 && (t & 7) <= 3) {
+			map_a1d1d4[t] = code++;
+		} else if (off_a1h8(t) == 0 && (t & 7) <= 3) {
+			diagonal[diagonal_count++] = t;
+		}
+	}
+	for (s32 i = 0; i < diagonal_count; i++) {
+		map_a1d1d4[diagonal[i]] = code++;
+	}
+	/* Legal king pairs, the second king isn't above the diagonal if the first is on it, both on the diagonal last */
+	code = 0;
+	for (s32 i = 0; i < 10; i++) {
+		for (ChessTile k1 = 0; k1 <= D4; k1++) {
+			if (map_a1d1d4[k1] != i || (i == 0 && k1 != B1) || (off_a1h8(k1) > 0 || (k1 & 7) > 3)) {
+				continue ;
+			}
+			for (ChessTile k2 = 0; k2 < TILE_MAX; k2++) {
+				if ((g_king_attack[k1] | (1ULL << k1)) & (1ULL << k2)) {
+					continue ;
+				} else if (!off_a1h8(k1) && off_a1h8(k2) > 0) {
+					continue ;
+				} else if (!off_a1h8(k1) && !off_a1h8(k2)) {
+					both_on_diagonal[both_count][0] = i;
+					both_on_diagonal[both_count++][1] = k2;
+				} else {
+					map_kk[i][k2] = code++;
+				}
+			}
+		}
+	}
+	for (s32 i = 0; i < both_count; i++) {
+		map_kk[both_on_diagonal[i][0]][both_on_diagonal[i][1]] = code++;
+	}
+	binomial[0][0] = 1;
+	for (s32 n = 1; n < TILE_MAX; n++) {
+		for (s32 k = 0; k < 6 && k <= n; k++) {
+			binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+		}
+	}
+	/* The pawn tiles of the A file then the H file, rank 2 first, then the B and G files ... */
+	for (s32 lead_count = 1; lead_count <= 5; lead_count++) {
+		for (s32 file = 0; file < 4; file++) {
+			idx = 0;
+			for (s32 rank = 1; rank <= 6; rank++) {
+				tile = rank * 8 + file;
+				if (lead_count == 1) {
+					map_pawns[tile] = available--;
+					map_pawns[tile ^ 7] = available--;
+				}
+				lead_pawn_idx[lead_count][tile] = idx;
+				idx += binomial[lead_count - 1][map_pawns[tile]];
+			}
+			lead_pawns_size[lead_count][file] = idx;
+		}
+	}
+}
+
+/* @brief Build the table file path
+ * @param t		SyzygyTable struct
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @return Allocated path, NULL on malloc failure
+*/
+static char *syzygy_file_path(SyzygyTable *t, s32 type) {
+	u64		size = ft_strlen(tb.path) + SYZYGY_NAME_SIZE + 8;
+	char	*path = malloc(size);
+
+	if (path) {
+		snprintf(path, size, "%s/%s%s", tb.path, t->name, type == SYZYGY_WDL ? ".rtbw" : ".rtbz");
+	}
+	return (path);
+}
+
+/* @brief Unmap a table file, safe to call on an unmapped file */
+static void syzygy_unmap_file(SyzygyFile *f) {
+#ifdef CHESS_WINDOWS_VERSION
+	if (f->data) {
+		UnmapViewOfFile(f->data);
+	}
+	if (f->mapping) {
+		CloseHandle(f->mapping);
+	}
+	if (f->file) {
+		CloseHandle(f->file);
+	}
+	f->file = NULL;
+	f->mapping = NULL;
+#else
+	if (f->data) {
+		munmap((void *)f->data, f->size);
+	}
+#endif
+	f->data = NULL;
+	f->size = 0;
+}
+
+/* @brief Map a table file
+ * @param f		SyzygyFile struct, filled
+ * @param path	File path
+ * @return TRUE on success, FALSE otherwise (no file)
+*/
+static s8 syzygy_map_file(SyzygyFile *f, const char *path) {
+#ifdef CHESS_WINDOWS_VERSION
+	LARGE_INTEGER	size;
+
+	f->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (f->file == INVALID_HANDLE_VALUE) {
+		f->file = NULL;
+		return (FALSE);
+	}
+	if (!GetFileSizeEx(f->file, &size) || size.QuadPart == 0) {
+		syzygy_unmap_file(f);
+		return (FALSE);
+	}
+	f->size = (u64)size.QuadPart;
+	f->mapping = CreateFileMappingA(f->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (f->mapping) {
+		f->data = MapViewOfFile(f->mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	struct stat	st;
+	void		*data = NULL;
+	s32			fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		return (FALSE);
+	}
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return (FALSE);
+	}
+	f->size = (u64)st.st_size;
+	data = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* The mapping stay valid after the close */
+	close(fd);
+	f->data = data == MAP_FAILED ? NULL : data;
+#endif
+	if (!f->data) {
+		syzygy_unmap_file(f);
+		return (FALSE);
+	}
+	return (TRUE);
+}
+
+/* @brief Set the piece groups of a table part and the index factor of each group
+ * @param t		SyzygyTable struct
+ * @param d		SyzygyPairs struct, pieces set
+ * @param order	Encoding position of the leading group and of the other color pawns group (0xF for none)
+ * @param file	Leading pawn file
+ * @note The index is g1 * N(g2) * N(g3) + g2 * N(g3) + g3, N(g) the number of placements of the group g,
+ * the groups are in the order given by the table
+*/
+static void syzygy_set_groups(SyzygyTable *t, SyzygyPairs *d, const s32 *order, s32 file) {
+	s32	n = 0, first_len = t->has_pawns ? 0 : t->has_unique_pieces ? 3 : 2;
+	s8	pp = t->has_pawns && t->pawn_count[1];
+	s32	next = pp ? 2 : 1, free_tiles = 0;
+	u64	idx = 1;
+
+	/* Same pieces next to each other are a group, the first group is the leading pieces */
+	d->group_len[n] = 1;
+	for (s32 i = 1; i < t->piece_count; i++) {
+		if (--first_len > 0 || d->pieces[i] == d->pieces[i - 1]) {
+			d->group_len[n]++;
+		} else {
+			d->group_len[++n] = 1;
+		}
+	}
+	d->group_len[++n] = 0;
+	free_tiles = 64 - d->group_len[0] - (pp ? d->group_len[1] : 0);
+	for (s32 k = 0; next < n || k == order[0] || k == order[1]; k++) {
+		if (k == order[0]) {
+			d->group_idx[0] = idx;
+			idx *= t->has_pawns ? lead_pawns_size[d->group_len[0]][file] : t->has_unique_pieces ? 31332 : 462;
+		} else if (k == order[1]) {
+			d->group_idx[1] = idx;
+			idx *= binomial[d->group_len[1]][48 - d->group_len[0]];
+		} else {
+			d->group_idx[next] = idx;
+			idx *= binomial[d->group_len[next]][free_tiles];
+			free_tiles -= d->group_len[next++];
+		}
+	}
+	d->group_idx[n] = idx;
+}
+
+/* @brief Compute the number of values of a symbol, recursively for its pair
+ * @return Number of values - 1 of the symbol
+*/
+static u8 syzygy_set_symlen(SyzygyPairs *d, u32 sym, u32 sym_count, u8 *visited) {
+	u32 left = 0, right = btree_right(d, sym);
+
+	visited[sym] = TRUE;
+	if (right == 0xFFF) {
+		return (0);
+	}
+	left = btree_left(d, sym);
+	if (left >= sym_count || right >= sym_count) {
+		return (0);
+	}
+	if (!visited[left]) {
+		d->symlen[left] = syzygy_set_symlen(d, left, sym_count, visited);
+	}
+	if (!visited[right]) {
+		d->symlen[right] = syzygy_set_symlen(d, right, sym_count, visited);
+	}
+	return (d->symlen[left] + d->symlen[right] + 1);
+}
+
+/* @brief Read the sizes and the Huffman code of a table part
+ * @param d		SyzygyPairs struct, groups set
+ * @param data	Table data
+ * @return The data after the part header, NULL if the header is corrupted
+*/
+static const u8 *syzygy_set_sizes(SyzygyPairs *d, const u8 *data) {
+	u64	tb_size = 0;
+	u32	sym_count = 0, len_count = 0, padding = 0;
+	u8	*visited = NULL;
+	s32	n = 0;
+
+	d->flags = *data++;
+	if (d->flags & PAIRS_FLAG_SINGLE_VALUE) {
+		d->blocks_num = 0;
+		d->block_length_size = 0;
+		d->span = 0;
+		d->sparse_index_size = 0;
+		d->min_sym_len = *data++;
+		return (data);
+	}
+	while (d->group_len[n]) {
+		n++;
+	}
+	tb_size = d->group_idx[n];
+	d->block_size = 1ULL << *data++;
+	d->span = 1ULL << *data++;
+	d->sparse_index_size = (tb_size + d->span - 1) / d->span;
+	padding = *data++;
+	d->blocks_num = read_le32(data);
+	data += 4;
+	d->block_length_size = d->blocks_num + padding;
+	d->max_sym_len = *data++;
+	d->min_sym_len = *data++;
+	d->lowest_sym = data;
+	if (d->min_sym_len == 0 || d->max_sym_len < d->min_sym_len || d->max_sym_len > SYZYGY_MAX_SYM_LEN) {
+		return (NULL);
+	}
+	/* The longer codes have the lower values, base64[i] is the lowest code of length min_sym_len + i */
+	len_count = d->max_sym_len - d->min_sym_len + 1;
+	d->base64[len_count - 1] = 0;
+	for (s32 i = len_count - 2; i >= 0; i--) {
+		d->base64[i] = (d->base64[i + 1] + read_le16(d->lowest_sym + 2 * i) - read_le16(d->lowest_sym + 2 * (i + 1))) / 2;
+	}
+	for (u32 i = 0; i < len_count; i++) {
+		d->base64[i] <<= 64 - i - d->min_sym_len;
+	}
+	data += len_count * 2;
+	sym_count = read_le16(data);
+	data += 2;
+	d->btree = data;
+	d->symlen = ft_calloc(sym_count + 1, sizeof(u8));
+	visited = ft_calloc(sym_count + 1, sizeof(u8));
+	if (!d->symlen || !visited) {
+		free(visited);
+		return (NULL);
+	}
+	for (u32 sym = 0; sym < sym_count; sym++) {
+		if (!visited[sym]) {
+			d->symlen[sym] = syzygy_set_symlen(d, sym, sym_count, visited);
+		}
+	}
+	free(visited);
+	return (data + sym_count * 3 + (sym_count & 1));
+}
+
+/* @brief Read the DTZ value maps
+ * @param t			SyzygyTable struct
+ * @param data		Table data
+ * @param file_max	Number of table parts
+ * @return The data after the maps
+*/
+static const u8 *syzygy_set_dtz_map(SyzygyTable *t, const u8 *data, s32 file_max) {
+	SyzygyPairs *d = NULL;
+
+	t->dtz_map = data;
+	for (s32 f = 0; f < file_max; f++) {
+		d = syzygy_pairs(t, SYZYGY_DTZ, 0, f);
+		if (!(d->flags & PAIRS_FLAG_MAPPED)) {
+			continue ;
+		}
+		if (d->flags & PAIRS_FLAG_WIDE) {
+			data += (uintptr_t)data & 1;
+			for (s32 i = 0; i < 4; i++) {
+				d->map_idx[i] = (u16)((data - t->dtz_map) / 2 + 1);
+				data += 2 * read_le16(data) + 2;
+			}
+		} else {
+			for (s32 i = 0; i < 4; i++) {
+				d->map_idx[i] = (u16)(data - t->dtz_map + 1);
+				data += *data + 1;
+			}
+		}
+	}
+	return (data + ((uintptr_t)data & 1));
+}
+
+/* @brief Free the symbol lengths of a table */
+static void syzygy_free_pairs(SyzygyTable *t, s32 type) {
+	SyzygyPairs *d = type == SYZYGY_DTZ ? t->dtz : t->wdl[0];
+
+	for (s32 i = 0; i < (type == SYZYGY_DTZ ? 4 : 8); i++) {
+		free(d[i].symlen);
+		d[i].symlen = NULL;
+	}
+}
+
+/* @brief Read the header of a mapped table file
+ * @param t		SyzygyTable struct
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @param data	File data after the magic
+ * @param end	End of the file
+ * @return TRUE on success, FALSE if the file is corrupted
+*/
+static s8 syzygy_setup(SyzygyTable *t, s32 type, const u8 *data, const u8 *end) {
+	s32			sides = type == SYZYGY_WDL && t->key != t->key2 ? 2 : 1;
+	s32			file_max = t->has_pawns ? 4 : 1;
+	s8			pp = t->has_pawns && t->pawn_count[1];
+	s32			order[2][2];
+	SyzygyPairs	*d = NULL;
+
+	if ((*data & FILE_FLAG_HAS_PAWNS) != (t->has_pawns ? FILE_FLAG_HAS_PAWNS : 0)) {
+		return (FALSE);
+	}
+	data++;
+	for (s32 f = 0; f < file_max; f++) {
+		order[0][0] = *data & 0xF;
+		order[0][1] = pp ? data[1] & 0xF : 0xF;
+		order[1][0] = *data >> 4;
+		order[1][1] = pp ? data[1] >> 4 : 0xF;
+		data += 1 + pp;
+		for (s32 k = 0; k < t->piece_count; k++, data++) {
+			for (s32 i = 0; i < sides; i++) {
+				syzygy_pairs(t, type, i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+			}
+		}
+		for (s32 i = 0; i < sides; i++) {
+			syzygy_set_groups(t, syzygy_pairs(t, type, i, f), order[i], f);
+		}
+	}
+	data += (uintptr_t)data & 1;
+	for (s32 f = 0; f < file_max; f++) {
+		for (s32 i = 0; i < sides; i++) {
+			if (data >= end || !(data = syzygy_set_sizes(syzygy_pairs(t, type, i, f), data))) {
+				return (FALSE);
+			}
+		}
+	}
+	if (type == SYZYGY_DTZ) {
+		data = syzygy_set_dtz_map(t, data, file_max);
+	}
+	for (s32 f = 0; f < file_max; f++) {
+		for (s32 i = 0; i < sides; i++) {
+			d = syzygy_pairs(t, type, i, f);
+			d->sparse_index = data;
+			data += d->sparse_index_size * 6;
+		}
+	}
+	for (s32 f = 0; f < file_max; f++) {
+		for (s32 i = 0; i < sides; i++) {
+			d = syzygy_pairs(t, type, i, f);
+			d->block_length = data;
+			data += d->block_length_size * 2;
+		}
+	}
+	for (s32 f = 0; f < file_max; f++) {
+		for (s32 i = 0; i < sides; i++) {
+			/* Blocks are 64 bytes aligned */
+			data = (const u8 *)(((uintptr_t)data + 0x3F) & ~(uintptr_t)0x3F);
+			d = syzygy_pairs(t, type, i, f);
+			d->data = data;
+			data += d->blocks_num * d->block_size;
+		}
+	}
+	return (data <= end);
+}
+
+/* @brief Map a table file on its first probe
+ * @param t		SyzygyTable struct
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @return TRUE if the file is mapped, FALSE otherwise (missing or corrupted file)
+*/
+static s8 syzygy_mapped(SyzygyTable *t, s32 type) {
+	static const u8	magic[2][4] = {{0x71, 0xE8, 0x23, 0x5D}, {0xD7, 0x66, 0x0C, 0xA5}};
+	SyzygyFile		*f = &t->file[type];
+	char			*path = NULL;
+
+	if (__atomic_load_n(&f->ready, __ATOMIC_ACQUIRE)) {
+		return (f->data != NULL);
+	}
+	pthread_mutex_lock(&tb_map_lock);
+	if (!f->ready && (path = syzygy_file_path(t, type))) {
+		/* The files end with a 16 bytes checksum after the 64 bytes aligned blocks */
+		if (syzygy_map_file(f, path) && (f->size % 64 != 16 || ft_memcmp(f->data, magic[type], 4) != 0
+			|| !syzygy_setup(t, type, f->data + 4, f->data + f->size))) {
+			CHESS_LOG(LOG_ERROR, "Corrupted tablebase file %s\n", path);
+			syzygy_free_pairs(t, type);
+			syzygy_unmap_file(f);
+		}
+		free(path);
+		__atomic_store_n(&f->ready, TRUE, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&tb_map_lock);
+	return (f->data != NULL);
+}
+
+/* @brief Decompress the value of an index
+ * @param d		SyzygyPairs struct
+ * @param idx	Position index
+ * @return The stored value
+*/
+static s32 syzygy_decompress(SyzygyPairs *d, u64 idx) {
+	u32			k = 0, block = 0, sym = 0, left = 0;
+	s64			offset = 0;
+	const u8	*ptr = NULL;
+	u64			buf64 = 0;
+	s32			buf64_size = 64, len = 0;
+
+	if (d->flags & PAIRS_FLAG_SINGLE_VALUE) {
+		return (d->min_sym_len);
+	}
+	/* The sparse index give the block and the offset of the value k * span + span / 2 */
+	k = (u32)(idx / d->span);
+	block = read_le32(d->sparse_index + 6 * k);
+	offset = read_le16(d->sparse_index + 6 * k + 4);
+	offset += (s64)(idx % d->span) - (s64)(d->span / 2);
+	/* Each block store block_length + 1 values, move to the block of the index */
+	while (offset < 0) {
+		offset += read_le16(d->block_length + 2 * --block) + 1;
+	}
+	while (offset > read_le16(d->block_length + 2 * block)) {
+		offset -= read_le16(d->block_length + 2 * block++) + 1;
+	}
+	ptr = d->data + (u64)block * d->block_size;
+	buf64 = read_be64(ptr);
+	ptr += 8;
+	/* Skip the symbols before the offset, a symbol expand to symlen + 1 values */
+	while (TRUE) {
+		len = 0;
+		while (buf64 < d->base64[len]) {
+			len++;
+		}
+		sym = (u32)((buf64 - d->base64[len]) >> (64 - len - d->min_sym_len));
+		sym += read_le16(d->lowest_sym + 2 * len);
+		if (offset < d->symlen[sym] + 1) {
+			break ;
+		}
+		offset -= d->symlen[sym] + 1;
+		len += d->min_sym_len;
+		buf64 <<= len;
+		buf64_size -= len;
+		if (buf64_size <= 32) {
+			buf64_size += 32;
+			buf64 |= (u64)read_be32(ptr) << (64 - buf64_size);
+			ptr += 4;
+		}
+	}
+	/* Expand the symbol pairs down to the value of the offset */
+	while (d->symlen[sym]) {
+		left = btree_left(d, sym);
+		if (offset < d->symlen[left] + 1) {
+			sym = left;
+		} else {
+			offset -= d->symlen[left] + 1;
+			sym = btree_right(d, sym);
+		}
+	}
+	return (btree_left(d, sym));
+}
+
+/* @brief Sort tiles by ascending map_pawns value, stable */
+static void sort_pawn_tiles(ChessTile *tiles, s32 count) {
+	ChessTile	tmp = INVALID_TILE;
+	s32			j = 0;
+
+	for (s32 i = 1; i < count; i++) {
+		tmp = tiles[i];
+		for (j = i; j > 0 && map_pawns[tiles[j - 1]] > map_pawns[tmp]; j--) {
+			tiles[j] = tiles[j - 1];
+		}
+		tiles[j] = tmp;
+	}
+}
+
+/* @brief Sort tiles by ascending value */
+static void sort_tiles(ChessTile *tiles, s32 count) {
+	ChessTile	tmp = INVALID_TILE;
+	s32			j = 0;
+
+	for (s32 i = 1; i < count; i++) {
+		tmp = tiles[i];
+		for (j = i; j > 0 && tiles[j - 1] > tmp; j--) {
+			tiles[j] = tiles[j - 1];
+		}
+		tiles[j] = tmp;
+	}
+}
+
+/* @brief Index of the leading group without pawn, the first piece is in the A1-D1-D4 triangle
+ * @param t			SyzygyTable struct
+ * @param tiles		Piece tiles, mirrored in place
+ * @param size		Number of pieces
+ * @param group_len	Number of pieces of the leading group
+*/
+static u64 syzygy_piece_index(SyzygyTable *t, ChessTile *tiles, s32 size, s32 group_len) {
+	s32 adjust1 = 0, adjust2 = 0;
+
+	/* The leading piece below the fifth rank */
+	if (tiles[0] / 8 > 3) {
+		for (s32 i = 0; i < size; i++) {
+			tiles[i] ^= 56;
+		}
+	}
+	/* The first leading piece not on the A1-H8 diagonal is below it */
+	for (s32 i = 0; i < group_len; i++) {
+		if (!off_a1h8(tiles[i])) {
+			continue ;
+		}
+		if (off_a1h8(tiles[i]) > 0) {
+			for (s32 j = i; j < size; j++) {
+				tiles[j] = ((tiles[j] >> 3) | (tiles[j] << 3)) & 63;
+			}
+		}
+		break ;
+	}
+	/* Kings only, the other pieces are in the next groups */
+	if (!t->has_unique_pieces) {
+		return (map_kk[map_a1d1d4[tiles[0]]][tiles[1]]);
+	}
+	/* Three unique pieces, the next tiles skip the tiles already used */
+	adjust1 = tiles[1] > tiles[0];
+	adjust2 = (tiles[2] > tiles[0]) + (tiles[2] > tiles[1]);
+	if (off_a1h8(tiles[0])) {
+		return ((map_a1d1d4[tiles[0]] * 63 + (tiles[1] - adjust1)) * 62 + tiles[2] - adjust2);
+	} else if (off_a1h8(tiles[1])) {
+		return ((6 * 63 + (tiles[0] >> 3) * 28 + map_b1h1h7[tiles[1]]) * 62 + tiles[2] - adjust2);
+	} else if (off_a1h8(tiles[2])) {
+		return (6 * 63 * 62 + 4 * 28 * 62 + (tiles[0] >> 3) * 7 * 28 + ((tiles[1] >> 3) - adjust1) * 28
+			+ map_b1h1h7[tiles[2]]);
+	}
+	return (6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + (tiles[0] >> 3) * 7 * 6 + ((tiles[1] >> 3) - adjust1) * 6
+		+ ((tiles[2] >> 3) - adjust2));
+}
+
+/* @brief Check if a DTZ table part store the side to move */
+static s8 syzygy_dtz_stm(SyzygyTable *t, s32 stm, s32 file) {
+	u8 flags = syzygy_pairs(t, SYZYGY_DTZ, stm, file)->flags;
+
+	return ((flags & PAIRS_FLAG_STM) == stm || (t->key == t->key2 && !t->has_pawns));
+}
+
+/* @brief Convert a stored DTZ value to plies
+ * @param t		SyzygyTable struct
+ * @param file	Leading pawn file
+ * @param value	Stored value
+ * @param wdl	WDL value of the position
+*/
+static s32 syzygy_dtz_score(SyzygyTable *t, s32 file, s32 value, s32 wdl) {
+	static const s32	wdl_map[] = {1, 3, 0, 2, 0};
+	SyzygyPairs			*d = syzygy_pairs(t, SYZYGY_DTZ, 0, file);
+
+	if (d->flags & PAIRS_FLAG_MAPPED) {
+		if (d->flags & PAIRS_FLAG_WIDE) {
+			value = read_le16(t->dtz_map + 2 * (d->map_idx[wdl_map[wdl + 2]] + value));
+		} else {
+			value = t->dtz_map[d->map_idx[wdl_map[wdl + 2]] + value];
+		}
+	}
+	if ((wdl == TB_WIN && !(d->flags & PAIRS_FLAG_WIN_PLIES)) || (wdl == TB_LOSS && !(d->flags & PAIRS_FLAG_LOSS_PLIES))
+		|| wdl == TB_CURSED_WIN || wdl == TB_BLESSED_LOSS) {
+		value *= 2;
+	}
+	return (value + 1);
+}
+
+/* @brief Compute the index of a position in a table
+ * @param b		ChessBoard struct
+ * @param t		SyzygyTable struct of the board material, mapped
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @param pairs	Filled with the table part of the position
+ * @param file	Filled with the leading pawn file
+ * @param state	Filled with PROBE_CHANGE_STM if the DTZ table store the other side to move, not changed otherwise
+ * @return Index of the position in the table part
+*/
+static u64 syzygy_encode(ChessBoard *b, SyzygyTable *t, s32 type, SyzygyPairs **pairs, s32 *file, s8 *state) {
+	ChessTile	tiles[SYZYGY_MAX_PIECES] = {A1}, *group = NULL;
+	u8			pieces[SYZYGY_MAX_PIECES] = {0}, tmp_piece = 0;
+	ChessTile	tmp = INVALID_TILE, lead = 0;
+	Bitboard	pieces_bb = 0, lead_pawns = 0;
+	SyzygyPairs	*d = NULL;
+	u64			key = syzygy_board_key(b), idx = 0, n = 0;
+	s32			size = 0, lead_count = 0, next = 0, stm = 0, flip_color = 0, flip_tiles = 0, adjust = 0;
+	s8			flip = FALSE, remaining_pawns = FALSE;
+
+	*file = 0;
+	/* The tables have the strong side as white, and only white to move for the symmetric materials */
+	flip = key != t->key || (t->key == t->key2 && b->turn == IS_BLACK);
+	flip_color = flip * 8;
+	flip_tiles = flip * 56;
+	stm = flip ^ b->turn;
+	/* The pawns of the leading color first, the leading pawn is the nearest to the edge, then the lowest */
+	if (t->has_pawns) {
+		lead_pawns = pieces_bb = b->piece[(syzygy_pairs(t, type, 0, 0)->pieces[0] ^ flip_color) & 8 ? BLACK_PAWN : WHITE_PAWN];
+		while (pieces_bb) {
+			tiles[size++] = get_tile_from_mask(pieces_bb) ^ flip_tiles;
+			pieces_bb &= pieces_bb - 1;
+		}
+		lead_count = size;
+		for (s32 i = 1; i < lead_count; i++) {
+			lead = map_pawns[tiles[i]] > map_pawns[tiles[lead]] ? i : lead;
+		}
+		tmp = tiles[0];
+		tiles[0] = tiles[lead];
+		tiles[lead] = tmp;
+		*file = (tiles[0] & 7) < 4 ? tiles[0] & 7 : 7 - (tiles[0] & 7);
+	}
+	if (type == SYZYGY_DTZ && !syzygy_dtz_stm(t, stm, *file)) {
+		*state = PROBE_CHANGE_STM;
+		return (0);
+	}
+	pieces_bb = b->occupied ^ lead_pawns;
+	while (pieces_bb) {
+		tmp = get_tile_from_mask(pieces_bb);
+		tiles[size] = tmp ^ flip_tiles;
+		pieces[size++] = syzygy_piece_code(b->mailbox[tmp]) ^ flip_color;
+		pieces_bb &= pieces_bb - 1;
+	}
+	d = syzygy_pairs(t, type, stm, *file);
+	*pairs = d;
+	/* Same piece order as the table */
+	for (s32 i = lead_count; i < size - 1; i++) {
+		for (s32 j = i + 1; j < size; j++) {
+			if (d->pieces[i] == pieces[j]) {
+				tmp_piece = pieces[i];
+				pieces[i] = pieces[j];
+				pieces[j] = tmp_piece;
+				tmp = tiles[i];
+				tiles[i] = tiles[j];
+				tiles[j] = tmp;
+				break ;
+			}
+		}
+	}
+	/* The leading piece on the A-D files */
+	if ((tiles[0] & 7) > 3) {
+		for (s32 i = 0; i < size; i++) {
+			tiles[i] ^= 7;
+		}
+	}
+	if (t->has_pawns) {
+		idx = lead_pawn_idx[lead_count][tiles[0]];
+		sort_pawn_tiles(tiles + 1, lead_count - 1);
+		for (s32 i = 1; i < lead_count; i++) {
+			idx += binomial[i][map_pawns[tiles[i]]];
+		}
+	} else {
+		idx = syzygy_piece_index(t, tiles, size, d->group_len[0]);
+	}
+	/* The next groups, each tile skip the tiles of the previous groups */
+	idx *= d->group_idx[0];
+	group = tiles + d->group_len[0];
+	remaining_pawns = t->has_pawns && t->pawn_count[1];
+	while (d->group_len[++next]) {
+		sort_tiles(group, d->group_len[next]);
+		n = 0;
+		for (s32 i = 0; i < d->group_len[next]; i++) {
+			adjust = 0;
+			for (ChessTile *prev = tiles; prev < group; prev++) {
+				adjust += group[i] > *prev;
+			}
+			n += binomial[i + 1][group[i] - adjust - 8 * remaining_pawns];
+		}
+		remaining_pawns = FALSE;
+		idx += n * d->group_idx[next];
+		group += d->group_len[next];
+	}
+	return (idx);
+}
+
+/* @brief Probe a table file for a position
+ * @param b		ChessBoard struct
+ * @param type	SYZYGY_WDL or SYZYGY_DTZ
+ * @param wdl	WDL value of the position for a DTZ probe
+ * @param state	Filled with PROBE_FAIL or PROBE_CHANGE_STM, not changed on success
+ * @return WDL value or DTZ in plies
+*/
+static s32 syzygy_probe_table(ChessBoard *b, s32 type, s32 wdl, s8 *state) {
+	SyzygyTable	*t = NULL;
+	SyzygyPairs	*d = NULL;
+	u64			idx = 0;
+	s32			file = 0;
+
+	/* King against king */
+	if (b->occupied == (b->piece[WHITE_KING] | b->piece[BLACK_KING])) {
+		return (TB_DRAW);
+	}
+	if (!(t = syzygy_find(syzygy_board_key(b))) || !syzygy_mapped(t, type)) {
+		*state = PROBE_FAIL;
+		return (0);
+	}
+	idx = syzygy_encode(b, t, type, &d, &file, state);
+	if (*state == PROBE_CHANGE_STM) {
+		return (0);
+	}
+	if (type == SYZYGY_WDL) {
+		return (syzygy_decompress(d, idx) - 2);
+	}
+	return (syzygy_dtz_score(t, file, syzygy_decompress(d, idx), wdl));
+}
+
+/* @brief Check if a move is a capture or a pawn move */
+FT_INLINE s8 is_zeroing_move(ChessBoard *b, Move move) {
+	ChessPiece piece = b->mailbox[move_from(move)];
+
+	return (move_is_capture(move) || piece == WHITE_PAWN || piece == BLACK_PAWN);
+}
+
+/* @brief Check if the side to move is mated */
+FT_INLINE s8 is_mated(ChessBoard *b) {
+	return (u8ValueGet(b->info, b->turn == IS_BLACK ? BLACK_CHECK : WHITE_CHECK) && !has_legal_move(b, b->turn == IS_BLACK));
+}
+
+/* @brief Get the WDL value, the captures (and the pawn moves) are searched before the table probe
+ * @param b				ChessBoard struct, the moves are played and unplayed
+ * @param check_zeroing	Search the pawn moves too, the DTZ of the position is wrong if one is the best move
+ * @param state			Filled with the probe state
+ * @return WDL value, side to move point of view
+*/
+static s32 syzygy_search(ChessBoard *b, s8 check_zeroing, s8 *state) {
+	Move	moves[MAX_MOVES];
+	Undo	undo;
+	s32		count = generate_legal_moves(b, moves);
+	s32		value = 0, best = TB_LOSS, searched = 0;
+	s8		no_more_moves = FALSE;
+
+	for (s32 i = 0; i < count; i++) {
+		if (!move_is_capture(moves[i]) && (!check_zeroing || !is_zeroing_move(b, moves[i]))) {
+			continue ;
+		}
+		searched++;
+		make_move(b, moves[i], &undo);
+		value = -syzygy_search(b, FALSE, state);
+		unmake_move(b, moves[i], &undo);
+		if (*state == PROBE_FAIL) {
+			return (TB_DRAW);
+		}
+		if (value > best) {
+			best = value;
+			if (value >= TB_WIN) {
+				*state = PROBE_ZEROING_BEST_MOVE;
+				return (value);
+			}
+		}
+	}
+	/* All the moves are searched, the table value can be wrong (only 'en passant' captures, pat) */
+	no_more_moves = searched != 0 && searched == count;
+	if (no_more_moves) {
+		value = best;
+	} else {
+		value = syzygy_probe_table(b, SYZYGY_WDL, TB_DRAW, state);
+		if (*state == PROBE_FAIL) {
+			return (TB_DRAW);
+		}
+	}
+	/* The DTZ store a 'don't care' value when a capture is as good */
+	if (best >= value) {
+		*state = best > TB_DRAW || no_more_moves ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+		return (best);
+	}
+	*state = PROBE_OK;
+	return (value);
+}
+
+/* @brief DTZ of a position where the best move is a capture or a pawn move */
+FT_INLINE s32 dtz_before_zeroing(s32 wdl) {
+	if (wdl == TB_WIN) {
+		return (1);
+	} else if (wdl == TB_CURSED_WIN) {
+		return (101);
+	} else if (wdl == TB_BLESSED_LOSS) {
+		return (-101);
+	}
+	return (wdl == TB_LOSS ? -1 : 0);
+}
+
+/* @brief Get the DTZ of a position
+ * @param b		ChessBoard struct, the moves are played and unplayed
+ * @param state	Filled with the probe state
+ * @return DTZ in plies, positive for a win, negative for a loss, 0 for a draw, 100 more for the cursed wins
+*/
+static s32 syzygy_dtz(ChessBoard *b, s8 *state) {
+	Move	moves[MAX_MOVES];
+	Undo	undo;
+	s32		wdl = 0, dtz = 0, min_dtz = 0xFFFF, count = 0;
+	s8		zeroing = FALSE;
+
+	*state = PROBE_OK;
+	wdl = syzygy_search(b, TRUE, state);
+	/* The DTZ tables don't store the draws */
+	if (*state == PROBE_FAIL || wdl == TB_DRAW) {
+		return (0);
+	}
+	if (*state == PROBE_ZEROING_BEST_MOVE) {
+		return (dtz_before_zeroing(wdl));
+	}
+	dtz = syzygy_probe_table(b, SYZYGY_DTZ, wdl, state);
+	if (*state == PROBE_FAIL) {
+		return (0);
+	}
+	if (*state != PROBE_CHANGE_STM) {
+		return ((dtz + 100 * (wdl == TB_BLESSED_LOSS || wdl == TB_CURSED_WIN)) * (wdl > 0 ? 1 : -1));
+	}
+	/* The table store the other side to move, the best DTZ of the moves */
+	count = generate_legal_moves(b, moves);
+	for (s32 i = 0; i < count; i++) {
+		zeroing = is_zeroing_move(b, moves[i]);
+		make_move(b, moves[i], &undo);
+		/* The DTZ of a capture or pawn move is the one before it */
+		dtz = zeroing ? -dtz_before_zeroing(syzygy_search(b, FALSE, state)) : -syzygy_dtz(b, state);
+		if (dtz == 1 && is_mated(b)) {
+			min_dtz = 1;
+		}
+		if (!zeroing) {
+			dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+		}
+		if (dtz < min_dtz && (dtz > 0) == (wdl > 0) && dtz != 0) {
+			min_dtz = dtz;
+		}
+		unmake_move(b, moves[i], &undo);
+		if (*state == PROBE_FAIL) {
+			return (0);
+		}
+	}
+	/* No legal move, the position is mat */
+	return (min_dtz == 0xFFFF ? -1 : min_dtz);
+}
+
+/* @brief Check if a side can still castle */
+static s8 syzygy_castle_rights(ChessBoard *b) {
+	return (castle_available(b, WHITE_KING_MOVED, WHITE_KING_ROOK_MOVED, WHITE_ROOK, WHITE_KING_ROOK_START_POS)
+		|| castle_available(b, WHITE_KING_MOVED, WHITE_QUEEN_ROOK_MOVED, WHITE_ROOK, WHITE_QUEEN_ROOK_START_POS)
+		|| castle_available(b, BLACK_KING_MOVED, BLACK_KING_ROOK_MOVED, BLACK_ROOK, BLACK_KING_ROOK_START_POS)
+		|| castle_available(b, BLACK_KING_MOVED, BLACK_QUEEN_ROOK_MOVED, BLACK_ROOK, BLACK_QUEEN_ROOK_START_POS));
+}
+
+/* @brief Check if a position can be probed: few pieces and no castle right */
+FT_INLINE s8 syzygy_can_probe(ChessBoard *b) {
+	return (bitboard_count(b->occupied) <= tb.max_pieces && !syzygy_castle_rights(b));
+}
+
+/* @brief Register a table if its WDL file exists
+ * @param white	Piece kinds of the strong side (0 pawn to 4 queen), king excluded, strongest first
+ * @param black	Piece kinds of the other side, -1 terminated
+*/
+static void syzygy_add(const s32 *white, const s32 *black) {
+	SyzygyTable	*t = NULL;
+	s32			counts[2][5] = {{0}}, len = 0, pawns[2] = {0};
+	char		*path = NULL;
+	FILE		*file = NULL;
+	s8			lead_white = FALSE;
+
+	if (tb.count == tb.capacity) {
+		t = realloc(tb.tables, (tb.capacity + 64) * sizeof(SyzygyTable));
+		if (!t) {
+			return ;
+		}
+		tb.tables = t;
+		tb.capacity += 64;
+	}
+	t = &tb.tables[tb.count];
+	ft_bzero(t, sizeof(SyzygyTable));
+	t->name[len++] = 'K';
+	for (s32 i = 0; white[i] >= 0; i++) {
+		t->name[len++] = tb_piece_char[white[i]];
+		counts[0][white[i]]++;
+	}
+	t->name[len++] = 'v';
+	t->name[len++] = 'K';
+	for (s32 i = 0; black[i] >= 0; i++) {
+		t->name[len++] = tb_piece_char[black[i]];
+		counts[1][black[i]]++;
+	}
+	if (!(path = syzygy_file_path(t, SYZYGY_WDL))) {
+		return ;
+	}
+	file = fopen(path, "rb");
+	free(path);
+	if (!file) {
+		return ;
+	}
+	fclose(file);
+	t->piece_count = len - 1;
+	t->key = syzygy_count_key(counts[0], counts[1]);
+	t->key2 = syzygy_count_key(counts[1], counts[0]);
+	pawns[0] = counts[0][0];
+	pawns[1] = counts[1][0];
+	t->has_pawns = pawns[0] + pawns[1] > 0;
+	for (s32 type = 1; type < 5; type++) {
+		t->has_unique_pieces |= counts[0][type] == 1 || counts[1][type] == 1;
+	}
+	t->has_unique_pieces |= pawns[0] == 1 || pawns[1] == 1;
+	/* The leading color has the fewer pawns, the better compression */
+	lead_white = !pawns[1] || (pawns[0] && pawns[1] >= pawns[0]);
+	t->pawn_count[0] = lead_white ? pawns[0] : pawns[1];
+	t->pawn_count[1] = lead_white ? pawns[1] : pawns[0];
+	syzygy_hash_insert(t->key, tb.count);
+	syzygy_hash_insert(t->key2, tb.count);
+	if (t->piece_count > tb.max_pieces) {
+		tb.max_pieces = t->piece_count;
+	}
+	tb.count++;
+}
+
+/* @brief Register the tables of all the materials up to SYZYGY_MAX_PIECES pieces */
+static void syzygy_add_all() {
+	for (s32 p1 = 0; p1 < 5; p1++) {
+		syzygy_add((s32 []){p1, -1}, (s32 []){-1});
+		for (s32 p2 = 0; p2 <= p1; p2++) {
+			syzygy_add((s32 []){p1, p2, -1}, (s32 []){-1});
+			syzygy_add((s32 []){p1, -1}, (s32 []){p2, -1});
+			for (s32 p3 = 0; p3 < 5; p3++) {
+				syzygy_add((s32 []){p1, p2, -1}, (s32 []){p3, -1});
+			}
+			for (s32 p3 = 0; p3 <= p2; p3++) {
+				syzygy_add((s32 []){p1, p2, p3, -1}, (s32 []){-1});
+				for (s32 p4 = 0; p4 <= p3; p4++) {
+					syzygy_add((s32 []){p1, p2, p3, p4, -1}, (s32 []){-1});
+				}
+				for (s32 p4 = 0; p4 < 5; p4++) {
+					syzygy_add((s32 []){p1, p2, p3, -1}, (s32 []){p4, -1});
+				}
+			}
+			for (s32 p3 = 0; p3 <= p1; p3++) {
+				for (s32 p4 = 0; p4 <= (p1 == p3 ? p2 : p3); p4++) {
+					syzygy_add((s32 []){p1, p2, -1}, (s32 []){p3, p4, -1});
+				}
+			}
+		}
+	}
+}
+
+/* @brief Register the tablebases of a directory, the files are mapped on their first probe
+ * @param path	Directory of the .rtbw and .rtbz files, NULL or empty for no tablebase
+ * @return Pieces of the largest table found, 0 without table
+ * @note Not thread safe, call it before the search
+*/
+s32 syzygy_init(const char *path) {
+	static s8 index_ready = FALSE;
+
+	syzygy_free();
+	if (!path || !path[0]) {
+		return (0);
+	}
+	if (!index_ready) {
+		init_attack_table();
+		syzygy_init_index();
+		index_ready = TRUE;
+	}
+	if (!(tb.path = ft_strdup(path))) {
+		return (0);
+	}
+	syzygy_add_all();
+	if (tb.count == 0) {
+		CHESS_LOG(LOG_INFO, "No tablebase found in %s\n", path);
+	} else {
+		CHESS_LOG(LOG_INFO, "Tablebases %s: %d tables, up to %d pieces\n", path, tb.count, tb.max_pieces);
+	}
+	return (tb.max_pieces);
+}
+
+/* @brief Unmap the tables and forget the directory */
+void syzygy_free() {
+	for (s32 i = 0; i < tb.count; i++) {
+		for (s32 type = SYZYGY_WDL; type <= SYZYGY_DTZ; type++) {
+			syzygy_free_pairs(&tb.tables[i], type);
+			syzygy_unmap_file(&tb.tables[i].file[type]);
+		}
+	}
+	free(tb.tables);
+	free(tb.path);
+	ft_bzero(&tb, sizeof(Syzygy));
+}
+
+/* @brief Get the number of pieces of the largest table, 0 without table */
+s32 syzygy_max_pieces() {
+	return (tb.max_pieces);
+}
+
+/* @brief Probe the WDL tables
+ * @param b		ChessBoard struct, the moves are played and unplayed
+ * @return WDL result, side to move point of view, WDL_UNKNOWN if no table give a certain result
+ * @note A win or loss is only given at halfmove count 0, the 50 moves counter may draw it otherwise
+*/
+EndgameWDL syzygy_probe_wdl(ChessBoard *b) {
+	s8	state = PROBE_OK;
+	s32	wdl = 0;
+
+	if (!syzygy_can_probe(b)) {
+		return (WDL_UNKNOWN);
+	}
+	wdl = syzygy_search(b, FALSE, &state);
+	if (state == PROBE_FAIL) {
+		return (WDL_UNKNOWN);
+	}
+	/* A cursed win or a blessed loss is a draw with the 50 moves rule */
+	if (wdl > TB_LOSS && wdl < TB_WIN) {
+		return (WDL_DRAW);
+	}
+	if (b->halfmove_count != 0) {
+		return (WDL_UNKNOWN);
+	}
+	return (wdl == TB_WIN ? WDL_WIN : WDL_LOSS);
+}
+
+/* @brief Probe the DTZ tables
+ * @param b		ChessBoard struct, the moves are played and unplayed
+ * @param dtz	Filled with the DTZ in plies, positive for a win, negative for a loss,
+ *				0 for a draw, 100 more for a cursed win or blessed loss
+ * @return TRUE on success, FALSE if the position can't be probed (no table)
+*/
+s8 syzygy_probe_dtz(ChessBoard *b, s32 *dtz) {
+	s8 state = PROBE_OK;
+
+	if (!syzygy_can_probe(b)) {
+		return (FALSE);
+	}
+	*dtz = syzygy_dtz(b, &state);
+	return (state != PROBE_FAIL);
+}
+
+/* @brief Rank a root move by its DTZ, the higher the better
+ * @param dtz		DTZ after the move, root side point of view
+ * @param halfmove	Halfmove count of the root
+*/
+static s32 syzygy_root_rank(s32 dtz, s32 halfmove) {
+	/* The shortest win, then the wins the 50 moves rule may draw */
+	if (dtz > 0) {
+		return (dtz + halfmove <= 99 ? SYZYGY_MAX_DTZ - dtz : SYZYGY_MAX_DTZ / 2 - (dtz + halfmove));
+	}
+	/* The losses the 50 moves rule may draw, then the longest loss */
+	if (dtz < 0) {
+		return (-dtz + halfmove > 100 ? -SYZYGY_MAX_DTZ / 2 - dtz : -SYZYGY_MAX_DTZ - dtz);
+	}
+	return (0);
+}
+
+/* @brief Keep the best root moves by their DTZ
+ * @param b		ChessBoard struct, the moves are played and unplayed
+ * @param moves	Root moves, filtered in place
+ * @param count	Number of root moves
+ * @return Number of moves kept, 0 if the position can't be probed (no table), the moves are unchanged
+*/
+s32 syzygy_root_filter(ChessBoard *b, Move *moves, s32 count) {
+	s32		rank[MAX_MOVES];
+	s32		best = -SYZYGY_MAX_DTZ - 1, dtz = 0, kept = 0;
+	s8		state = PROBE_OK;
+	Undo	undo;
+
+	if (count == 0 || !syzygy_can_probe(b)) {
+		return (0);
+	}
+	for (s32 i = 0; i < count; i++) {
+		make_move(b, moves[i], &undo);
+		if (b->halfmove_count == 0) {
+			/* Capture or pawn move, the DTZ is the one of the move */
+			dtz = dtz_before_zeroing(-syzygy_search(b, FALSE, &state));
+		} else if (b->halfmove_count >= 100 || repetition_count(b) >= 3) {
+			dtz = 0;
+		} else {
+			dtz = -syzygy_dtz(b, &state);
+			dtz += dtz > 0 ? 1 : dtz < 0 ? -1 : 0;
+		}
+		if (dtz == 2 && is_mated(b)) {
+			dtz = 1;
+		}
+		unmake_move(b, moves[i], &undo);
+		if (state == PROBE_FAIL) {
+			return (0);
+		}
+		rank[i] = syzygy_root_rank(dtz, b->halfmove_count);
+		best = rank[i] > best ? rank[i] : best;
+	}
+	for (s32 i = 0; i < count; i++) {
+		if (rank[i] == best) {
+			moves[kept++] = moves[i];
+		}
+	}
+	return (kept);
+}
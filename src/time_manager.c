@@ -0,0 +1,79 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/chess_bot.h"
+
+/*
+ * Time manager, turn the game clock into the search deadlines.
+ * The clock left (minus TM_MOVE_OVERHEAD_MS) is shared between the moves left, estimated from
+ * the move number, and most of the increment is added: this is the soft deadline.
+ * The hard deadline let the search finish a depth that take longer than expected, it's at most
+ * a part of the clock so a move can never flag, even when the estimation is wrong.
+ * The level time limit (set_bot_skill) stay a cap, the clock never make a bot think longer than its level.
+ * The time is read in search_should_stop every TIME_CHECK_MASK + 1 nodes (hard deadline),
+ * and between two depths of the main thread (soft deadline).
+*/
+
+/* @brief Set the search deadlines from the game clock, call it after set_bot_skill
+ * @param info				SearchInfo struct, time_limit_ms (level cap) is kept if lower
+ * @param clock				BotClock struct, NULL for no clock (the level limits only)
+ * @param fullmove_count	Move number, for the moves left estimation
+*/
+void time_manager_init(SearchInfo *info, const BotClock *clock, u16 fullmove_count) {
+	u64 avail = 0, moves_left = 0, soft = 0, hard = 0;
+
+	info->soft_limit_ms = 0;
+	if (!clock) {
+		return ;
+	}
+	avail = clock->remaining_ms > TM_MOVE_OVERHEAD_MS ? clock->remaining_ms - TM_MOVE_OVERHEAD_MS : 0;
+	if (clock->moves_to_go != 0) {
+		moves_left = clock->moves_to_go;
+	} else {
+		moves_left = fullmove_count + TM_MIN_MOVES_LEFT < TM_MOVES_HORIZON ? TM_MOVES_HORIZON - fullmove_count : TM_MIN_MOVES_LEFT;
+	}
+	/* The increment is given after the move, only a part of it is spent */
+	soft = avail / moves_left + (clock->increment_ms * 3) / 4;
+	hard = soft * TM_HARD_FACTOR;
+	if (hard > avail / TM_HARD_MAX_DIV) {
+		hard = avail / TM_HARD_MAX_DIV;
+	}
+	if (info->time_limit_ms != 0 && hard > info->time_limit_ms) {
+		hard = info->time_limit_ms;
+	}
+	/* 0 is no limit, an empty clock still give a short search */
+	if (hard < TM_MIN_TIME_MS) {
+		hard = TM_MIN_TIME_MS;
+	}
+	if (soft > hard) {
+		soft = hard;
+	} else if (soft < TM_MIN_TIME_MS) {
+		soft = TM_MIN_TIME_MS;
+	}
+	info->time_limit_ms = (u32)hard;
+	info->soft_limit_ms = (u32)soft;
+	CHESS_LOG(LOG_DEBUG, "Time manager: clock %llu ms, move %u, soft %u ms, hard %u ms\n"
+		, (unsigned long long)clock->remaining_ms, fullmove_count, info->soft_limit_ms, info->time_limit_ms);
+}
+
+/* @brief Check if a new depth can start, called by the main thread after each finished depth
+ * @param info			SearchInfo struct
+ * @param stable_depths	Number of depths in a row with the same best move
+ * @return TRUE if the search must stop, FALSE otherwise
+ * @note A stable best move stop the search before the soft deadline, a new best move extend it.
+ *		A depth take about the time of all the previous ones, after half the hard deadline
+ *		it would be cut and its time lost.
+*/
+s8 time_manager_stop_depth(SearchInfo *info, s32 stable_depths) {
+	static const u32	scale[TM_STABILITY_MAX + 1] = TM_STABILITY_SCALE;
+	u64					limit = 0, elapsed = 0;
+
+	if (info->soft_limit_ms == 0 || __atomic_load_n(&info->ponder, __ATOMIC_RELAXED)) {
+		return (FALSE);
+	}
+	if (stable_depths > TM_STABILITY_MAX) {
+		stable_depths = TM_STABILITY_MAX;
+	}
+	elapsed = search_time_ms() - info->start_ms;
+	limit = (u64)info->soft_limit_ms * scale[stable_depths] / 100;
+	return (elapsed >= limit || elapsed >= info->time_limit_ms / 2);
+}
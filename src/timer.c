@@ -36,7 +36,12 @@ void draw_timer_rect(SDLHandle *h) {
 	static u64	prev_tick = 0;
 	u64 		now = 0, elapsed_time = 0;
 	u32 		*timer_to_update = NULL;
-	s8 			decrement_time = has_flag(h->flag, FLAG_NETWORK) && h->player_info.nt_info && h->player_info.nt_info->peer_conected && has_flag(h->flag, FLAG_FIRST_MOVE_PLAYED);
+	s8 			network = has_flag(h->flag, FLAG_NETWORK);
+	s8 			decrement_time = network && h->player_info.nt_info && h->player_info.nt_info->peer_conected && has_flag(h->flag, FLAG_FIRST_MOVE_PLAYED);
+	/* In local mode the bottom timer is the player color one, the side to move timer run in a bot game */
+	s8 			my_turn = network ? h->player_info.turn : h->board->turn == h->player_info.color;
+
+	decrement_time |= !network && has_flag(h->flag, FLAG_BOT_GAME) && has_flag(h->flag, FLAG_FIRST_MOVE_PLAYED);
 
 	/* Draw timer rect */
 	SDL_SetRenderDrawColor(h->renderer, 180, 180, 180, 255);
@@ -52,7 +57,7 @@ void draw_timer_rect(SDLHandle *h) {
 		elapsed_time = now - prev_tick;
 		SDL_SetRenderDrawColor(h->renderer, 0, 0, 150, 150);
 		/* Get the timer to update */
-		if (h->player_info.turn == TRUE) {
+		if (my_turn) {
 			SDL_RenderFillRect(h->renderer, &h->timer_rect_bot);
 			SDL_RenderFillRect(h->renderer, &h->name_rect_bot);
 			timer_to_update = &h->my_remaining_time;
@@ -62,10 +67,12 @@ void draw_timer_rect(SDLHandle *h) {
 			timer_to_update = &h->enemy_remaining_time;
 		} 
 
-		/* Update timer every second */
+		/* Update timer every second, a stopped timer restart a full second later */
 		if (decrement_time && elapsed_time >= 1) {
 			if (*timer_to_update > 0) { (*timer_to_update)-- ; }
 			prev_tick = now;
+		} else if (!decrement_time) {
+			prev_tick = now;
 		}
 	}
 	/* Draw timer text */
@@ -0,0 +1,185 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/chess_bot.h"
+
+/*
+ * Packed entry data layout:
+ *	bits  0-15: move
+ *	bits 16-31: score (s16)
+ *	bits 32-39: depth
+ *	bits 40-41: bound
+ *	bits 42-47: age
+*/
+#define TT_DATA_PACK(move, score, depth, bound, age) \
+	((u64)(u16)(move) | ((u64)(u16)(s16)(score) << 16) | ((u64)(u8)(depth) << 32) \
+	| ((u64)((bound) & 3) << 40) | ((u64)((age) & TT_AGE_MASK) << 42))
+
+#define TT_DATA_MOVE(data)	((Move)((data) & 0xFFFF))
+#define TT_DATA_SCORE(data)	((s32)(s16)(((data) >> 16) & 0xFFFF))
+#define TT_DATA_DEPTH(data)	((s32)(((data) >> 32) & 0xFF))
+#define TT_DATA_BOUND(data)	((TTBound)(((data) >> 40) & 3))
+#define TT_DATA_AGE(data)	((u8)(((data) >> 42) & TT_AGE_MASK))
+
+/* @brief Atomic load/store of a u64, no lock and no ordering, only tearing free on 64 bits targets */
+FT_INLINE u64 tt_load(u64 *ptr) {
+	return (__atomic_load_n(ptr, __ATOMIC_RELAXED));
+}
+
+FT_INLINE void tt_write(u64 *ptr, u64 value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+}
+
+/* @brief Init the table, the size is rounded down to a power of two bucket count
+ * @param tt		TranspositionTable struct
+ * @param size_mb	Table size in MB
+ * @return TRUE on success, FALSE on malloc failure (the table is left empty)
+*/
+s8 tt_init(TranspositionTable *tt, u32 size_mb) {
+	u64 bucket_count = 1;
+
+	fast_bzero(tt, sizeof(TranspositionTable));
+	if (size_mb == 0) {
+		size_mb = 1;
+	}
+	while (bucket_count * 2 * sizeof(TTBucket) <= (u64)size_mb * 1024ULL * 1024ULL) {
+		bucket_count *= 2;
+	}
+
+	/* Over allocate one cache line to align the buckets */
+	tt->alloc = malloc(bucket_count * sizeof(TTBucket) + sizeof(TTBucket));
+	if (!tt->alloc) {
+		CHESS_LOG(LOG_ERROR, "Transposition table malloc failed (%u MB)\n", size_mb);
+		return (FALSE);
+	}
+	tt->bucket = (TTBucket *)(((uintptr_t)tt->alloc + sizeof(TTBucket) - 1) & ~(uintptr_t)(sizeof(TTBucket) - 1));
+	tt->mask = bucket_count - 1;
+	tt->size_mb = size_mb;
+	tt_clear(tt);
+	CHESS_LOG(LOG_INFO, "Transposition table: %u MB, %llu buckets\n", size_mb, (unsigned long long)bucket_count);
+	return (TRUE);
+}
+
+/* @brief Resize the table, the content is lost
+ * @param tt		TranspositionTable struct, not used by a search
+ * @param size_mb	New table size in MB
+ * @return TRUE on success, FALSE on malloc failure
+*/
+s8 tt_resize(TranspositionTable *tt, u32 size_mb) {
+	if (tt->alloc && tt->size_mb == size_mb) {
+		tt_clear(tt);
+		return (TRUE);
+	}
+	tt_free(tt);
+	return (tt_init(tt, size_mb));
+}
+
+/* @brief Clear all the entries and reset the age */
+void tt_clear(TranspositionTable *tt) {
+	if (tt->bucket) {
+		fast_bzero(tt->bucket, (tt->mask + 1) * sizeof(TTBucket));
+	}
+	tt->age = 0;
+}
+
+/* @brief Free the table */
+void tt_free(TranspositionTable *tt) {
+	free(tt->alloc);
+	fast_bzero(tt, sizeof(TranspositionTable));
+}
+
+/* @brief Start a new search, entries of the previous searches become replaceable first */
+void tt_new_search(TranspositionTable *tt) {
+	tt->age = (tt->age + 1) & TT_AGE_MASK;
+}
+
+/* @brief Convert a mate score to be relative to the node instead of the root */
+FT_INLINE s32 score_to_tt(s32 score, s32 ply) {
+	if (score > SCORE_MATE - MAX_PLY) {
+		return (score + ply);
+	} else if (score < -SCORE_MATE + MAX_PLY) {
+		return (score - ply);
+	}
+	return (score);
+}
+
+/* @brief Convert a stored mate score back to be relative to the root */
+FT_INLINE s32 score_from_tt(s32 score, s32 ply) {
+	if (score > SCORE_MATE - MAX_PLY) {
+		return (score - ply);
+	} else if (score < -SCORE_MATE + MAX_PLY) {
+		return (score + ply);
+	}
+	return (score);
+}
+
+/* @brief Look for a position in the table
+ * @param tt	TranspositionTable struct
+ * @param key	Zobrist key of the position
+ * @param ply	Distance from the root, for the mate scores
+ * @param out	TTData filled on hit
+ * @return TRUE if the position is found, FALSE otherwise
+*/
+s8 tt_probe(TranspositionTable *tt, u64 key, s32 ply, TTData *out) {
+	TTBucket	*bucket = NULL;
+	u64			data = 0;
+
+	if (!tt || !tt->bucket) {
+		return (FALSE);
+	}
+	bucket = &tt->bucket[key & tt->mask];
+	for (s32 i = 0; i < TT_BUCKET_SIZE; i++) {
+		data = tt_load(&bucket->entry[i].data);
+		if ((tt_load(&bucket->entry[i].check) ^ data) == key && TT_DATA_BOUND(data) != TT_BOUND_NONE) {
+			out->move = TT_DATA_MOVE(data);
+			out->score = score_from_tt(TT_DATA_SCORE(data), ply);
+			out->depth = TT_DATA_DEPTH(data);
+			out->bound = TT_DATA_BOUND(data);
+			return (TRUE);
+		}
+	}
+	return (FALSE);
+}
+
+/* @brief Store a position in the table
+ * @param tt	TranspositionTable struct
+ * @param key	Zobrist key of the position
+ * @param ply	Distance from the root, for the mate scores
+ * @param depth	Search depth of the score
+ * @param bound	TTBound enum
+ * @param score	Score of the position
+ * @param move	Best move, MOVE_NONE keep the move already stored for this position
+ * @note The same position is always replaced, otherwise the entry with the lowest
+ *		depth minus age penalty is replaced
+*/
+void tt_store(TranspositionTable *tt, u64 key, s32 ply, s32 depth, TTBound bound, s32 score, Move move) {
+	TTBucket	*bucket = NULL;
+	TTEntry		*replace = NULL;
+	u64			data = 0;
+	s32			value = 0, best_value = 0x7FFFFFFF;
+	u8			age_diff = 0;
+
+	if (!tt || !tt->bucket) {
+		return ;
+	}
+	bucket = &tt->bucket[key & tt->mask];
+	for (s32 i = 0; i < TT_BUCKET_SIZE; i++) {
+		data = tt_load(&bucket->entry[i].data);
+		if ((tt_load(&bucket->entry[i].check) ^ data) == key) {
+			replace = &bucket->entry[i];
+			if (move == MOVE_NONE) {
+				move = TT_DATA_MOVE(data);
+			}
+			break ;
+		}
+		/* Old entries lose 8 depth per search generation */
+		age_diff = (tt->age - TT_DATA_AGE(data)) & TT_AGE_MASK;
+		value = TT_DATA_DEPTH(data) - 8 * age_diff;
+		if (value < best_value) {
+			best_value = value;
+			replace = &bucket->entry[i];
+		}
+	}
+	data = TT_DATA_PACK(move, score_to_tt(score, ply), depth, bound, tt->age);
+	tt_write(&replace->data, data);
+	tt_write(&replace->check, key ^ data);
+}
@@ -0,0 +1,446 @@
+#include "../include/chess.h"
+#include "../include/chess_log.h"
+#include "../include/chess_bot.h"
+
+#ifndef CHESS_WINDOWS_VERSION
+	#include <errno.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+/*
+ * UCI engine adapter, an engine binary is started once and kept alive between the moves.
+ * The commands are written on the engine stdin pipe, the engine stdout is read with a
+ * line reader: the bytes are kept in the engine buffer until a full line is received.
+ * A move is asked with 'position fen <fen> [moves ...]' then 'go movetime <ms>', the answer
+ * is the 'bestmove' line. If the engine die (EOF, broken pipe) or don't answer, it's
+ * restarted and the request is sent again, at most UCI_MAX_RESTART times.
+*/
+
+/* @brief Convert a move in UCI coordinate notation (e2e4, e7e8q)
+ * @param move	Move
+ * @param buff	Output, UCI_MOVE_SIZE bytes
+*/
+void uci_move_to_str(Move move, char *buff) {
+	static const char	promotion_char[] = "nbrq";
+	ChessTile			from = move_from(move), to = move_to(move);
+
+	buff[0] = 'a' + (from & 7);
+	buff[1] = '1' + (from >> 3);
+	buff[2] = 'a' + (to & 7);
+	buff[3] = '1' + (to >> 3);
+	buff[4] = move_is_promotion(move) ? promotion_char[move_flag(move) & 3] : '\0';
+	buff[5] = '\0';
+}
+
+/* @brief Find the legal move of a UCI coordinate notation move (e2e4, e7e8q)
+ * @param b		ChessBoard struct
+ * @param str	Move string, the move end at the first space or the end of the string
+ * @return The legal move, MOVE_NONE if the move isn't legal
+*/
+Move uci_parse_move(ChessBoard *b, const char *str) {
+	Move	moves[MAX_MOVES];
+	s32		count = 0;
+	char	buff[UCI_MOVE_SIZE];
+
+	if (ft_strlen(str) < 4 || str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8'
+		|| str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+		return (MOVE_NONE);
+	}
+	count = generate_legal_moves(b, moves);
+	for (s32 i = 0; i < count; i++) {
+		uci_move_to_str(moves[i], buff);
+		if (ft_strncmp(buff, str, 4) != 0) {
+			continue ;
+		}
+		/* The promotion char is the fifth one, nothing after a non promotion move */
+		if (move_is_promotion(moves[i]) ? str[4] == buff[4] : (str[4] == '\0' || str[4] == ' ')) {
+			return (moves[i]);
+		}
+	}
+	return (MOVE_NONE);
+}
+
+#ifdef CHESS_WINDOWS_VERSION
+
+s8 uci_engine_start(UciEngine *e, const char *path) {
+	ft_bzero(e, sizeof(UciEngine));
+	CHESS_LOG(LOG_ERROR, "UCI engine %s: not supported on windows\n", path);
+	return (FALSE);
+}
+
+void uci_engine_stop(UciEngine *e) {
+	ft_bzero(e, sizeof(UciEngine));
+}
+
+s8 uci_engine_send(UciEngine *e, const char *cmd) {
+	(void)e, (void)cmd;
+	return (FALSE);
+}
+
+s32 uci_engine_read_line(UciEngine *e, char *line, u32 size, u32 timeout_ms) {
+	(void)e, (void)line, (void)size, (void)timeout_ms;
+	return (UCI_READ_ERROR);
+}
+
+Move uci_engine_go(UciEngine *e, ChessBoard *b, const char *fen, const char *moves, u32 movetime_ms, s8 *stop) {
+	(void)e, (void)b, (void)fen, (void)moves, (void)movetime_ms, (void)stop;
+	return (MOVE_NONE);
+}
+
+#else
+
+/* @brief Check if a line start with a UCI keyword followed by a space or the end of the line */
+static s8 is_uci_keyword(const char *line, const char *keyword) {
+	u32 len = ft_strlen(keyword);
+
+	return (ft_strncmp(line, keyword, len) == 0 && (line[len] == '\0' || line[len] == ' '));
+}
+
+/* @brief Write all the bytes on the engine stdin
+ * @return TRUE on success, FALSE if the engine is dead (broken pipe)
+*/
+static s8 uci_write(UciEngine *e, const char *data, u32 len) {
+	ssize_t ret = 0;
+
+	while (len > 0) {
+		ret = write(e->in_fd, data, len);
+		if (ret < 0 && errno == EINTR) {
+			continue ;
+		} else if (ret <= 0) {
+			return (FALSE);
+		}
+		data += ret;
+		len -= ret;
+	}
+	return (TRUE);
+}
+
+/* @brief Send a command to the engine, the new line is added
+ * @param e		UciEngine struct
+ * @param cmd	UCI command
+ * @return TRUE on success, FALSE if the engine is dead
+*/
+s8 uci_engine_send(UciEngine *e, const char *cmd) {
+	if (e->pid <= 0) {
+		return (FALSE);
+	}
+	CHESS_LOG(LOG_DEBUG, "UCI > %s\n", cmd);
+	return (uci_write(e, cmd, ft_strlen(cmd)) && uci_write(e, "\n", 1));
+}
+
+/* @brief Move the first buffered line in line
+ * @return TRUE if a full line is buffered, FALSE otherwise
+*/
+static s8 uci_pop_line(UciEngine *e, char *line, u32 size) {
+	u32 len = 0, copy = 0;
+
+	while (len < e->buff_len && e->buff[len] != '\n') {
+		len++;
+	}
+	if (len == e->buff_len) {
+		return (FALSE);
+	}
+	copy = len < size - 1 ? len : size - 1;
+	ft_memcpy(line, e->buff, copy);
+	/* The UCI line can end with \r\n */
+	if (copy > 0 && line[copy - 1] == '\r') {
+		copy--;
+	}
+	line[copy] = '\0';
+	e->buff_len -= len + 1;
+	memmove(e->buff, e->buff + len + 1, e->buff_len);
+	return (TRUE);
+}
+
+/* @brief Read the next line of the engine output
+ * @param e				UciEngine struct
+ * @param line			Output line, without the new line
+ * @param size			Line size, a longer line is cut
+ * @param timeout_ms	Time to wait for the line
+ * @return UCI_READ_LINE, UCI_READ_TIMEOUT or UCI_READ_ERROR (engine dead)
+*/
+s32 uci_engine_read_line(UciEngine *e, char *line, u32 size, u32 timeout_ms) {
+	u64				end = search_time_ms() + timeout_ms;
+	u64				now = 0;
+	struct pollfd	pfd = {0};
+	ssize_t			ret = 0;
+
+	while (!uci_pop_line(e, line, size)) {
+		/* A line bigger than the buffer is dropped */
+		if (e->buff_len == UCI_BUFF_SIZE) {
+			e->buff_len = 0;
+		}
+		now = search_time_ms();
+		if (now >= end) {
+			return (UCI_READ_TIMEOUT);
+		}
+		pfd.fd = e->out_fd;
+		pfd.events = POLLIN;
+		ret = poll(&pfd, 1, (s32)(end - now));
+		if (ret < 0 && errno == EINTR) {
+			continue ;
+		} else if (ret < 0) {
+			return (UCI_READ_ERROR);
+		} else if (ret == 0) {
+			return (UCI_READ_TIMEOUT);
+		}
+		ret = read(e->out_fd, e->buff + e->buff_len, UCI_BUFF_SIZE - e->buff_len);
+		if (ret < 0 && errno == EINTR) {
+			continue ;
+		} else if (ret <= 0) {
+			return (UCI_READ_ERROR);
+		}
+		e->buff_len += ret;
+	}
+	CHESS_LOG(LOG_DEBUG, "UCI < %s\n", line);
+	return (UCI_READ_LINE);
+}
+
+/* @brief Read the engine output until a line start with keyword
+ * @return UCI_READ_LINE when the line is found, UCI_READ_TIMEOUT or UCI_READ_ERROR
+*/
+static s32 uci_wait_keyword(UciEngine *e, const char *keyword, char *line, u32 size, u32 timeout_ms) {
+	u64	end = search_time_ms() + timeout_ms;
+	u64	now = 0;
+	s32	ret = UCI_READ_TIMEOUT;
+
+	while ((now = search_time_ms()) < end) {
+		if ((ret = uci_engine_read_line(e, line, size, end - now)) != UCI_READ_LINE) {
+			return (ret);
+		}
+		if (is_uci_keyword(line, keyword)) {
+			return (UCI_READ_LINE);
+		}
+	}
+	return (UCI_READ_TIMEOUT);
+}
+
+/* @brief Start the engine process, the stdin and stdout are piped
+ * @return TRUE on success, FALSE otherwise
+*/
+static s8 uci_spawn(UciEngine *e) {
+	s32 to_engine[2] = {-1, -1}, from_engine[2] = {-1, -1};
+
+	if (pipe(to_engine) != 0 || pipe(from_engine) != 0) {
+		CHESS_LOG(LOG_ERROR, "UCI engine: pipe failed\n");
+		goto pipe_error;
+	}
+	e->pid = fork();
+	if (e->pid < 0) {
+		CHESS_LOG(LOG_ERROR, "UCI engine: fork failed\n");
+		goto pipe_error;
+	} else if (e->pid == 0) {
+		dup2(to_engine[0], STDIN_FILENO);
+		dup2(from_engine[1], STDOUT_FILENO);
+		close(to_engine[0]);
+		close(to_engine[1]);
+		close(from_engine[0]);
+		close(from_engine[1]);
+		execl(e->path, e->path, (char *)NULL);
+		_exit(127);
+	}
+	close(to_engine[0]);
+	close(from_engine[1]);
+	e->in_fd = to_engine[1];
+	e->out_fd = from_engine[0];
+	e->buff_len = 0;
+	return (TRUE);
+
+	pipe_error:
+		for (s32 i = 0; i < 2; i++) {
+			if (to_engine[i] >= 0) { close(to_engine[i]); }
+			if (from_engine[i] >= 0) { close(from_engine[i]); }
+		}
+		e->pid = 0;
+		return (FALSE);
+}
+
+/* @brief Close the pipes of a finished engine process, the path is kept for a restart */
+static void uci_close(UciEngine *e) {
+	close(e->in_fd);
+	close(e->out_fd);
+	e->pid = 0;
+	e->buff_len = 0;
+}
+
+/* @brief Kill the engine process and close the pipes */
+static void uci_kill(UciEngine *e) {
+	if (e->pid <= 0) {
+		return ;
+	}
+	kill(e->pid, SIGKILL);
+	waitpid(e->pid, NULL, 0);
+	uci_close(e);
+}
+
+/* @brief Start the engine and do the UCI handshake (uci/uciok, isready/readyok)
+ * @return TRUE if the engine is ready, FALSE otherwise
+*/
+static s8 uci_launch(UciEngine *e) {
+	char line[UCI_LINE_SIZE];
+
+	if (!uci_spawn(e)) {
+		return (FALSE);
+	}
+	if (!uci_engine_send(e, "uci")
+		|| uci_wait_keyword(e, "uciok", line, UCI_LINE_SIZE, UCI_INIT_TIMEOUT_MS) != UCI_READ_LINE
+		|| !uci_engine_send(e, "isready")
+		|| uci_wait_keyword(e, "readyok", line, UCI_LINE_SIZE, UCI_INIT_TIMEOUT_MS) != UCI_READ_LINE) {
+		CHESS_LOG(LOG_ERROR, "UCI engine %s: no answer to the handshake\n", e->path);
+		uci_kill(e);
+		return (FALSE);
+	}
+	CHESS_LOG(LOG_INFO, "UCI engine %s ready (pid %d)\n", e->path, (s32)e->pid);
+	return (TRUE);
+}
+
+/* @brief Restart a dead or stuck engine
+ * @return TRUE if the engine is ready, FALSE if it can't be restarted
+*/
+static s8 uci_restart(UciEngine *e) {
+	uci_kill(e);
+	if (e->restart_count >= UCI_MAX_RESTART) {
+		CHESS_LOG(LOG_ERROR, "UCI engine %s: too many restarts\n", e->path);
+		return (FALSE);
+	}
+	e->restart_count++;
+	CHESS_LOG(LOG_INFO, "UCI engine %s: restart %u\n", e->path, e->restart_count);
+	return (uci_launch(e));
+}
+
+/* @brief Start an engine, the process is kept alive until uci_engine_stop
+ * @param e		UciEngine struct
+ * @param path	Engine binary path
+ * @return TRUE if the engine answered the handshake, FALSE otherwise
+*/
+s8 uci_engine_start(UciEngine *e, const char *path) {
+	ft_bzero(e, sizeof(UciEngine));
+	if (!(e->path = ft_strdup(path))) {
+		return (FALSE);
+	}
+	/* A write on the pipe of a dead engine must fail, not kill the game */
+	signal(SIGPIPE, SIG_IGN);
+	if (!uci_launch(e)) {
+		free(e->path);
+		e->path = NULL;
+		return (FALSE);
+	}
+	return (TRUE);
+}
+
+/* @brief Ask the engine to quit and free the engine resources, safe to call on a stopped engine
+ * @param e		UciEngine struct
+*/
+void uci_engine_stop(UciEngine *e) {
+	char line[UCI_LINE_SIZE];
+
+	if (e->pid > 0 && uci_engine_send(e, "quit")) {
+		/* The quit close the engine output, the read return on EOF */
+		uci_engine_read_line(e, line, UCI_LINE_SIZE, UCI_QUIT_TIMEOUT_MS);
+	}
+	uci_kill(e);
+	free(e->path);
+	ft_bzero(e, sizeof(UciEngine));
+}
+
+/* @brief Send the position and the go command, read the best move
+ * @return UCI_READ_LINE with the bestmove line in line, UCI_READ_TIMEOUT or UCI_READ_ERROR
+*/
+static s32 uci_search(UciEngine *e, const char *fen, const char *moves, u32 movetime_ms, s8 *stop, char *line) {
+	char	*cmd = NULL;
+	s8		sent = FALSE;
+	s8		stop_sent = FALSE;
+	u64		end = 0, now = 0;
+	s32		ret = UCI_READ_TIMEOUT;
+
+	cmd = ft_strjoin("position fen ", fen);
+	if (cmd && moves && moves[0]) {
+		cmd = ft_strjoin_free(cmd, " moves ", 'f');
+		cmd = ft_strjoin_free(cmd, (char *)moves, 'f');
+	}
+	if (!cmd) {
+		return (UCI_READ_ERROR);
+	}
+	sent = uci_engine_send(e, cmd);
+	free(cmd);
+	cmd = ft_strjoin_free("go movetime ", ft_itoa(movetime_ms), 's');
+	sent = sent && cmd && uci_engine_send(e, cmd);
+	free(cmd);
+	if (!sent) {
+		return (UCI_READ_ERROR);
+	}
+
+	/* The engine has movetime + margin to answer, a stop is sent on cancel or timeout */
+	end = search_time_ms() + movetime_ms + UCI_MOVE_MARGIN_MS;
+	while (TRUE) {
+		now = search_time_ms();
+		if (!stop_sent && ((stop && __atomic_load_n(stop, __ATOMIC_RELAXED)) || now >= end)) {
+			if (!uci_engine_send(e, "stop")) {
+				return (UCI_READ_ERROR);
+			}
+			stop_sent = TRUE;
+			end = now + UCI_MOVE_MARGIN_MS;
+		} else if (stop_sent && now >= end) {
+			return (UCI_READ_TIMEOUT);
+		}
+		/* Short reads, the cancel flag is checked between them */
+		ret = uci_engine_read_line(e, line, UCI_LINE_SIZE, UCI_POLL_MS);
+		if (ret == UCI_READ_ERROR) {
+			return (ret);
+		} else if (ret == UCI_READ_LINE && is_uci_keyword(line, "bestmove")) {
+			return (UCI_READ_LINE);
+		}
+	}
+}
+
+/* @brief Ask the engine the best move of a position, the engine is restarted if it died
+ * @param e				UciEngine struct, started
+ * @param b				ChessBoard struct, position after the moves, used to check the engine move
+ * @param fen			FEN of the start position
+ * @param moves			Moves played from the FEN, UCI notation separated by spaces, NULL for none
+ * @param movetime_ms	Engine search time
+ * @param stop			Cancel flag, the engine is stopped when it's set, NULL for none
+ * @return The legal best move, MOVE_NONE on failure, cancel or if the engine has no move
+*/
+Move uci_engine_go(UciEngine *e, ChessBoard *b, const char *fen, const char *moves, u32 movetime_ms, s8 *stop) {
+	char	line[UCI_LINE_SIZE];
+	s32		ret = UCI_READ_ERROR;
+	Move	move = MOVE_NONE;
+
+	if (!e->path) {
+		return (MOVE_NONE);
+	}
+	for (s32 attempt = 0; attempt < 2; attempt++) {
+		/* Engine exited between two moves, the process is already reaped */
+		if (e->pid > 0 && waitpid(e->pid, NULL, WNOHANG) != 0) {
+			uci_close(e);
+		}
+		if (e->pid <= 0 && !uci_restart(e)) {
+			return (MOVE_NONE);
+		}
+		if ((ret = uci_search(e, fen, moves, movetime_ms, stop, line)) == UCI_READ_LINE) {
+			e->restart_count = 0;
+			break ;
+		}
+		CHESS_LOG(LOG_ERROR, "UCI engine %s: %s during the search\n", e->path, ret == UCI_READ_TIMEOUT ? "no answer" : "died");
+		uci_kill(e);
+		/* A cancelled search is not sent again */
+		if (stop && __atomic_load_n(stop, __ATOMIC_RELAXED)) {
+			return (MOVE_NONE);
+		}
+	}
+	if (ret != UCI_READ_LINE || (stop && __atomic_load_n(stop, __ATOMIC_RELAXED))) {
+		return (MOVE_NONE);
+	}
+	/* 'bestmove <move> [ponder <move>]', '(none)' or '0000' without legal move */
+	move = line[8] == ' ' ? uci_parse_move(b, line + 9) : MOVE_NONE;
+	if (move == MOVE_NONE) {
+		CHESS_LOG(LOG_ERROR, "UCI engine %s: illegal best move |%s|\n", e->path, line);
+	}
+	return (move);
+}
+
+#endif
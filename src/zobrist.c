@@ -0,0 +1,108 @@
+#include "../include/chess.h"
+
+/*
+ * Zobrist hashing.
+ * Each piece on each tile, each castle right, each 'en passant' file and the black side
+ * to move get a random 64 bits key. The position key is the xor of the keys of the current
+ * state, so a move only xor in/out the keys it changes.
+ * Two positions with the same pieces, side to move, castle rights and 'en passant' captures
+ * must have the same key (threefold repetition): the castle rights are hashed, not the six
+ * moved bits of the info byte, and the 'en passant' file only if a pawn can take, like polyglot_key.
+ * The keys come from a fixed seed xorshift, the key of a position is the same for each run.
+*/
+
+u64 g_zobrist_piece[PIECE_MAX][TILE_MAX];
+u64 g_zobrist_castle[4];
+u64 g_zobrist_en_passant[8];
+u64 g_zobrist_turn;
+
+/* @brief Xorshift64* pseudo random generator
+ * @param state	Generator state, updated
+ * @return The next random number
+*/
+static u64 zobrist_random(u64 *state) {
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return (*state * 0x2545F4914F6CDD1DULL);
+}
+
+/* @brief Init the zobrist keys, only the first call fill the tables */
+void init_zobrist_table() {
+	static s8	initialised = FALSE;
+	u64			state = 0x9E3779B97F4A7C15ULL;
+
+	if (initialised) {
+		return ;
+	}
+	for (s32 type = 0; type < PIECE_MAX; type++) {
+		for (s32 tile = 0; tile < TILE_MAX; tile++) {
+			g_zobrist_piece[type][tile] = zobrist_random(&state);
+		}
+	}
+	for (s32 right = 0; right < 4; right++) {
+		g_zobrist_castle[right] = zobrist_random(&state);
+	}
+	for (s32 file = 0; file < 8; file++) {
+		g_zobrist_en_passant[file] = zobrist_random(&state);
+	}
+	g_zobrist_turn = zobrist_random(&state);
+	initialised = TRUE;
+}
+
+/* @brief Get the zobrist key of the castle rights, a right is the king and the rook never moved
+ * @param info	Info byte of the board
+ * @return The castle rights key
+*/
+u64 zobrist_castle_key(u8 info) {
+	u64 key = 0;
+
+	if (!u8ValueGet(info, WHITE_KING_MOVED) && !u8ValueGet(info, WHITE_KING_ROOK_MOVED)) {
+		key ^= g_zobrist_castle[0];
+	}
+	if (!u8ValueGet(info, WHITE_KING_MOVED) && !u8ValueGet(info, WHITE_QUEEN_ROOK_MOVED)) {
+		key ^= g_zobrist_castle[1];
+	}
+	if (!u8ValueGet(info, BLACK_KING_MOVED) && !u8ValueGet(info, BLACK_KING_ROOK_MOVED)) {
+		key ^= g_zobrist_castle[2];
+	}
+	if (!u8ValueGet(info, BLACK_KING_MOVED) && !u8ValueGet(info, BLACK_QUEEN_ROOK_MOVED)) {
+		key ^= g_zobrist_castle[3];
+	}
+	return (key);
+}
+
+/* @brief Get the zobrist key of the 'en passant' file
+ * @param b		ChessBoard struct
+ * @return The file key if a pawn of the side to move can take 'en passant', 0 otherwise
+*/
+u64 zobrist_en_passant_key(ChessBoard *b) {
+	if (!en_passant_attackers(b)) {
+		return (0);
+	}
+	return (g_zobrist_en_passant[b->en_passant_tile & 7]);
+}
+
+/* @brief Compute the zobrist key of the board from scratch
+ * @param b		ChessBoard struct
+ * @return The zobrist key
+*/
+u64 compute_zobrist_key(ChessBoard *b) {
+	Bitboard	pieces = 0;
+	u64			key = 0;
+
+	init_zobrist_table();
+	for (s32 type = 0; type < PIECE_MAX; type++) {
+		pieces = b->piece[type];
+		while (pieces) {
+			key ^= g_zobrist_piece[type][get_tile_from_mask(pieces)];
+			pieces &= pieces - 1;
+		}
+	}
+	key ^= zobrist_castle_key(b->info);
+	key ^= zobrist_en_passant_key(b);
+	if (b->turn == IS_BLACK) {
+		key ^= g_zobrist_turn;
+	}
+	return (key);
+}